@@ -0,0 +1,423 @@
+//Headless benchmark of the asset pipeline: imports, cooks and loads every .glb
+//under a resource directory N times and prints timings as JSON on stdout.
+//
+//  AssetBenchmark [--runs N] [--float] [--cache-dir DIR] [resource directory (default: Resources)]
+//
+//Cooked files go to DIR, by default a temporary directory removed on exit, so
+//the resource tree is never written to.
+
+#include "GlbReader.h"
+#include "ModelCache.h"
+#include "ModelImporter.h"
+#include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::atomic<uint64_t> allocatedBytes{ 0 };
+    std::atomic<uint64_t> allocationCount{ 0 };
+}
+
+namespace
+{
+    //Every replaced operator new ends up here, null on failure
+    void* countedAllocate(size_t size, size_t alignment) noexcept
+    {
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        size = size == 0 ? 1 : size;
+        if (alignment <= alignof(std::max_align_t))
+        {
+            return std::malloc(size);
+        }
+#if defined(_MSC_VER)
+        return _aligned_malloc(size, alignment);
+#else
+        //aligned_alloc wants the size to be a multiple of the alignment
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    }
+
+    void countedFree(void* p, size_t alignment) noexcept
+    {
+#if defined(_MSC_VER)
+        if (alignment > alignof(std::max_align_t))
+        {
+            _aligned_free(p);
+            return;
+        }
+#else
+        (void)alignment;
+#endif
+        std::free(p);
+    }
+
+    void* throwingAllocate(size_t size, size_t alignment)
+    {
+        if (void* p = countedAllocate(size, alignment))
+        {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+//Count every heap allocation made while a stage runs. Every form is replaced,
+//so counts are complete and each delete matches its new under sanitizers.
+void* operator new(size_t size)
+{
+    return throwingAllocate(size, 0);
+}
+
+void* operator new[](size_t size)
+{
+    return throwingAllocate(size, 0);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, 0);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return throwingAllocate(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return throwingAllocate(size, size_t(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size, size_t(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+    countedFree(p, 0);
+}
+
+void operator delete[](void* p) noexcept
+{
+    countedFree(p, 0);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    countedFree(p, 0);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    countedFree(p, 0);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    countedFree(p, 0);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    countedFree(p, 0);
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept
+{
+    countedFree(p, size_t(alignment));
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept
+{
+    countedFree(p, size_t(alignment));
+}
+
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept
+{
+    countedFree(p, size_t(alignment));
+}
+
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept
+{
+    countedFree(p, size_t(alignment));
+}
+
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    countedFree(p, size_t(alignment));
+}
+
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    countedFree(p, size_t(alignment));
+}
+
+namespace
+{
+    struct StageResult
+    {
+        const char* name;
+        double medianMs = 0.0;
+        double p99Ms = 0.0;
+        uint64_t bytesAllocated = 0;
+        uint64_t allocations = 0;
+        uint64_t inputBytes = 0;
+    };
+
+    struct AssetResult
+    {
+        std::string path;
+        uint64_t fileBytes = 0;
+        uint64_t vertices = 0;
+        uint64_t triangles = 0;
+        std::vector<StageResult> stages;
+    };
+
+    //Run a stage N times, allocation counters report the average per run
+    StageResult measure(const char* name, int runs, uint64_t inputBytes, const std::function<void()>& stage)
+    {
+        std::vector<double> durations;
+        durations.reserve(size_t(runs));
+        uint64_t bytesBefore = allocatedBytes.load();
+        uint64_t countBefore = allocationCount.load();
+        for (int run = 0; run < runs; ++run)
+        {
+            auto start = std::chrono::steady_clock::now();
+            stage();
+            auto end = std::chrono::steady_clock::now();
+            durations.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        uint64_t bytes = allocatedBytes.load() - bytesBefore;
+        uint64_t count = allocationCount.load() - countBefore;
+
+        std::sort(durations.begin(), durations.end());
+        StageResult result;
+        result.name = name;
+        result.medianMs = durations[durations.size() / 2];
+        result.p99Ms = durations[std::min(durations.size() - 1, size_t(double(durations.size()) * 0.99))];
+        result.bytesAllocated = bytes / uint64_t(runs);
+        result.allocations = count / uint64_t(runs);
+        result.inputBytes = inputBytes;
+        return result;
+    }
+
+    std::string escapeJson(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    //Copy the streams and texture levels into a staging buffer like the renderer uploads do
+    size_t stageUpload(const CookedModel& model, const std::vector<std::shared_ptr<CookedTexture>>& textures, std::vector<uint8_t>& staging)
+    {
+        size_t copied = 0;
+        for (const auto& primitive : model.getPrimitives())
+        {
+            staging.resize(std::max<size_t>(staging.size(), std::max(primitive.getVertexBufferSize(), primitive.getIndexBufferSize())));
+            memcpy(staging.data(), primitive.vertices, primitive.getVertexBufferSize());
+            memcpy(staging.data(), primitive.indices, primitive.getIndexBufferSize());
+            copied += primitive.getVertexBufferSize() + primitive.getIndexBufferSize();
+        }
+        for (const auto& cooked : textures)
+        {
+            const auto& texture = cooked->getTexture();
+            staging.resize(std::max<size_t>(staging.size(), texture.dataSize));
+            memcpy(staging.data(), texture.data, texture.dataSize);
+            copied += texture.dataSize;
+        }
+        return copied;
+    }
+
+    AssetResult benchmarkAsset(const std::string& path, const ImportSettings& settings, const std::string& cacheDirectory, int runs)
+    {
+        AssetResult asset;
+        asset.path = path;
+        asset.fileBytes = std::filesystem::file_size(path);
+
+        auto imported = ModelImporter::importFile(path, settings);
+        for (const auto& primitive : imported.primitives)
+        {
+            asset.vertices += primitive.vertices.size();
+            asset.triangles += (primitive.lods.empty() ? primitive.indices.size() : primitive.lods[0].indexCount) / 3;
+        }
+
+        //Decode, optimize, simplify and quantize from the source file, then
+        //decode, mipmap and compress every image the way the texture tasks do
+        asset.stages.push_back(measure("import", runs, asset.fileBytes, [&]() {
+            ModelImporter::importFile(path, settings);
+            GlbReader reader;
+            reader.open(path);
+            for (const auto& texture : imported.textures)
+            {
+                ModelImporter::importTexture(path, reader, texture.imageIndex, texture.role, settings);
+            }
+        }));
+
+        //Serialize the imported model to the cooked blob
+        ModelCache::SourceStamp stamp;
+        size_t cookedBytes = 0;
+        asset.stages.push_back(measure("cook", runs, asset.fileBytes, [&]() {
+            cookedBytes = ModelCache::cook(imported, stamp).size();
+        }));
+
+        //Warm cache: map the cooked files and copy their streams and levels for upload
+        auto loadAll = [&](std::vector<std::shared_ptr<CookedTexture>>& textures) {
+            auto model = ModelCache::load(path, settings, cacheDirectory);
+            textures.clear();
+            for (size_t i = 0; i < model->getTextureSources().size(); ++i)
+            {
+                textures.push_back(ModelCache::loadTexture(path, model, i, settings, cacheDirectory));
+            }
+            return model;
+        };
+        std::vector<std::shared_ptr<CookedTexture>> textures;
+        loadAll(textures);
+        std::vector<uint8_t> staging;
+        asset.stages.push_back(measure("load", runs, cookedBytes, [&]() {
+            auto model = loadAll(textures);
+            stageUpload(*model, textures, staging);
+        }));
+        return asset;
+    }
+
+    void printJson(const std::vector<AssetResult>& assets, const ImportSettings& settings, int runs)
+    {
+        printf("{\n");
+        printf("  \"runs\": %d,\n", runs);
+        printf("  \"settings\": { \"quantizeVertices\": %s, \"lodCount\": %u },\n", settings.quantizeVertices ? "true" : "false", settings.lodCount);
+        printf("  \"assets\": [\n");
+        for (size_t i = 0; i < assets.size(); ++i)
+        {
+            const auto& asset = assets[i];
+            printf("    {\n");
+            printf("      \"path\": \"%s\",\n", escapeJson(asset.path).c_str());
+            printf("      \"fileBytes\": %llu,\n", (unsigned long long)asset.fileBytes);
+            printf("      \"vertices\": %llu,\n", (unsigned long long)asset.vertices);
+            printf("      \"triangles\": %llu,\n", (unsigned long long)asset.triangles);
+            printf("      \"stages\": {\n");
+            for (size_t s = 0; s < asset.stages.size(); ++s)
+            {
+                const auto& stage = asset.stages[s];
+                double seconds = stage.medianMs / 1000.0;
+                double mbPerSecond = seconds > 0.0 ? double(stage.inputBytes) / 1.0e6 / seconds : 0.0;
+                double verticesPerSecond = seconds > 0.0 ? double(asset.vertices) / seconds : 0.0;
+                printf("        \"%s\": { \"medianMs\": %.4f, \"p99Ms\": %.4f, \"bytesAllocated\": %llu, \"allocations\": %llu, \"mbPerSecond\": %.2f, \"verticesPerSecond\": %.0f }%s\n",
+                    stage.name, stage.medianMs, stage.p99Ms,
+                    (unsigned long long)stage.bytesAllocated, (unsigned long long)stage.allocations,
+                    mbPerSecond, verticesPerSecond, s + 1 < asset.stages.size() ? "," : "");
+            }
+            printf("      }\n");
+            printf("    }%s\n", i + 1 < assets.size() ? "," : "");
+        }
+        printf("  ]\n");
+        printf("}\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int runs = 10;
+    std::string directory = "Resources";
+    std::string cacheDirectory;
+    ImportSettings settings;
+    settings.quantizeVertices = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+        {
+            runs = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--float") == 0)
+        {
+            settings.quantizeVertices = false;
+        }
+        else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc)
+        {
+            cacheDirectory = argv[++i];
+        }
+        else
+        {
+            directory = argv[i];
+        }
+    }
+
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, ec))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".glb")
+        {
+            paths.push_back(entry.path().generic_string());
+        }
+    }
+    if (ec || paths.empty())
+    {
+        fprintf(stderr, "No .glb files found under %s\n", directory.c_str());
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    const bool temporaryCache = cacheDirectory.empty();
+    if (temporaryCache)
+    {
+        const auto name = "AssetBenchmark-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        cacheDirectory = (std::filesystem::temp_directory_path(ec) / name).generic_string();
+    }
+
+    setLogEnabled(false);
+    std::vector<AssetResult> assets;
+    int result = 0;
+    for (const auto& path : paths)
+    {
+        try
+        {
+            assets.push_back(benchmarkAsset(path, settings, cacheDirectory, runs));
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+            result = 1;
+            break;
+        }
+    }
+    if (temporaryCache)
+    {
+        std::filesystem::remove_all(cacheDirectory, ec);
+    }
+    if (result == 0)
+    {
+        printJson(assets, settings, runs);
+    }
+    return result;
+}
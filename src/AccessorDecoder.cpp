@@ -0,0 +1,421 @@
+#include "AccessorDecoder.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ACCESSOR_DECODER_SSE2 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ACCESSOR_DECODER_AVX2 1
+#endif
+
+namespace
+{
+    template<class T>
+    inline T readValue(const uint8_t* p)
+    {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    template<int Type>
+    constexpr size_t componentSizeOf()
+    {
+        return Type == AccessorView::Byte || Type == AccessorView::UnsignedByte ? 1 :
+            Type == AccessorView::Short || Type == AccessorView::UnsignedShort ? 2 : 4;
+    }
+
+    //Scalar conversion of one component
+    template<int Type>
+    inline float convertComponent(const uint8_t* p, bool normalized)
+    {
+        switch (Type)
+        {
+        case AccessorView::Byte:
+        {
+            float v = float(readValue<int8_t>(p));
+            return normalized ? std::max(v / 127.0f, -1.0f) : v;
+        }
+        case AccessorView::UnsignedByte:
+        {
+            float v = float(readValue<uint8_t>(p));
+            return normalized ? v / 255.0f : v;
+        }
+        case AccessorView::Short:
+        {
+            float v = float(readValue<int16_t>(p));
+            return normalized ? std::max(v / 32767.0f, -1.0f) : v;
+        }
+        case AccessorView::UnsignedShort:
+        {
+            float v = float(readValue<uint16_t>(p));
+            return normalized ? v / 65535.0f : v;
+        }
+        case AccessorView::UnsignedInt:
+        {
+            double v = double(readValue<uint32_t>(p));
+            return float(normalized ? v / 4294967295.0 : v);
+        }
+        default:
+            return readValue<float>(p);
+        }
+    }
+
+    template<int Type>
+    inline void convertElement(const uint8_t* src, float* dst, int n, bool normalized)
+    {
+        const size_t componentSize = componentSizeOf<Type>();
+        for (int c = 0; c < n; ++c)
+        {
+            dst[c] = convertComponent<Type>(src + c * componentSize, normalized);
+        }
+    }
+
+    inline float* dstElement(float* dst, size_t dstStride, size_t i)
+    {
+        return reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(dst) + i * dstStride);
+    }
+
+    template<int Type>
+    constexpr float normalizeScale()
+    {
+        return Type == AccessorView::Byte ? 1.0f / 127.0f :
+            Type == AccessorView::UnsignedByte ? 1.0f / 255.0f :
+            Type == AccessorView::Short ? 1.0f / 32767.0f :
+            Type == AccessorView::UnsignedShort ? 1.0f / 65535.0f : 1.0f;
+    }
+
+    template<int Type>
+    constexpr bool isSigned()
+    {
+        return Type == AccessorView::Byte || Type == AccessorView::Short;
+    }
+
+    //Bytes one SIMD load reads for an element (always four components)
+    template<int Type>
+    constexpr size_t simdLoadBytes()
+    {
+        return 4 * componentSizeOf<Type>();
+    }
+
+#ifdef ACCESSOR_DECODER_SSE2
+    //Store the first n lanes of v
+    inline void storeLanes(float* dst, __m128 v, int n)
+    {
+        switch (n)
+        {
+        case 4:
+            _mm_storeu_ps(dst, v);
+            break;
+        case 3:
+            _mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+            _mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+            break;
+        case 2:
+            _mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+            break;
+        default:
+            _mm_store_ss(dst, v);
+            break;
+        }
+    }
+
+    //Load four components of an integer element widened to int32 lanes
+    template<int Type>
+    inline __m128i loadIntegerLanes(const uint8_t* src)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        if constexpr (Type == AccessorView::UnsignedShort || Type == AccessorView::Short)
+        {
+            __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+            return isSigned<Type>() ? _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16) : _mm_unpacklo_epi16(raw, zero);
+        }
+        __m128i raw = _mm_cvtsi32_si128(readValue<int32_t>(src));
+        if constexpr (isSigned<Type>())
+        {
+            __m128i wide = _mm_unpacklo_epi8(raw, raw);
+            return _mm_srai_epi32(_mm_unpacklo_epi16(wide, wide), 24);
+        }
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(raw, zero), zero);
+    }
+#endif
+
+    template<int Type>
+    void decodeDense(const AccessorView& view, float* dst, size_t dstStride, int n)
+    {
+        const bool normalized = view.normalized;
+        size_t i = 0;
+        //Matrices are wider than a register and go through the scalar path
+        if (n > 4)
+        {
+            for (; i < view.count; ++i)
+            {
+                convertElement<Type>(view.data + i * view.byteStride, dstElement(dst, dstStride, i), n, normalized);
+            }
+            return;
+        }
+
+#ifdef ACCESSOR_DECODER_AVX2
+        //Two integer elements per iteration
+        if constexpr (Type != AccessorView::Float && Type != AccessorView::UnsignedInt)
+        {
+            const __m256 scale = _mm256_set1_ps(normalized ? normalizeScale<Type>() : 1.0f);
+            const __m256 lower = _mm256_set1_ps(normalized && isSigned<Type>() ? -1.0f : -3.0e38f);
+            for (; i + 1 < view.count && (i + 1) * view.byteStride + simdLoadBytes<Type>() <= view.available; i += 2)
+            {
+                const uint8_t* src0 = view.data + i * view.byteStride;
+                const uint8_t* src1 = src0 + view.byteStride;
+                __m256i lanes;
+                if constexpr (Type == AccessorView::UnsignedShort || Type == AccessorView::Short)
+                {
+                    __m128i packed = _mm_unpacklo_epi64(
+                        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src0)),
+                        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src1)));
+                    lanes = isSigned<Type>() ? _mm256_cvtepi16_epi32(packed) : _mm256_cvtepu16_epi32(packed);
+                }
+                else
+                {
+                    __m128i packed = _mm_unpacklo_epi32(
+                        _mm_cvtsi32_si128(readValue<int32_t>(src0)),
+                        _mm_cvtsi32_si128(readValue<int32_t>(src1)));
+                    lanes = isSigned<Type>() ? _mm256_cvtepi8_epi32(packed) : _mm256_cvtepu8_epi32(packed);
+                }
+                __m256 v = _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(lanes), scale), lower);
+                storeLanes(dstElement(dst, dstStride, i), _mm256_castps256_ps128(v), n);
+                storeLanes(dstElement(dst, dstStride, i + 1), _mm256_extractf128_ps(v, 1), n);
+            }
+        }
+#endif
+
+#ifdef ACCESSOR_DECODER_SSE2
+        if constexpr (Type != AccessorView::UnsignedInt)
+        {
+            const __m128 scale = _mm_set1_ps(normalized ? normalizeScale<Type>() : 1.0f);
+            const __m128 lower = _mm_set1_ps(normalized && isSigned<Type>() ? -1.0f : -3.0e38f);
+            for (; i < view.count && i * view.byteStride + simdLoadBytes<Type>() <= view.available; ++i)
+            {
+                const uint8_t* src = view.data + i * view.byteStride;
+                __m128 v;
+                if constexpr (Type == AccessorView::Float)
+                {
+                    v = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+                }
+                else
+                {
+                    v = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(loadIntegerLanes<Type>(src)), scale), lower);
+                }
+                storeLanes(dstElement(dst, dstStride, i), v, n);
+            }
+        }
+#endif
+
+        //Tail elements too close to the end of the bufferView for a full load
+        for (; i < view.count; ++i)
+        {
+            convertElement<Type>(view.data + i * view.byteStride, dstElement(dst, dstStride, i), n, normalized);
+        }
+    }
+
+    template<int Type>
+    void decodeSparse(const AccessorView& view, float* dst, size_t dstStride, int n)
+    {
+        const size_t elementSize = AccessorDecoder::getElementSize(view);
+        const size_t indexSize = AccessorDecoder::getComponentSize(view.sparse.indexComponentType);
+        for (size_t k = 0; k < view.sparse.count; ++k)
+        {
+            const uint8_t* p = view.sparse.indices + k * indexSize;
+            size_t target = indexSize == 1 ? readValue<uint8_t>(p) : indexSize == 2 ? readValue<uint16_t>(p) : readValue<uint32_t>(p);
+            if (target >= view.count)
+            {
+                throw std::runtime_error("Sparse accessor index out of range");
+            }
+            convertElement<Type>(view.sparse.values + k * elementSize, dstElement(dst, dstStride, target), n, view.normalized);
+        }
+    }
+
+    template<int Type>
+    void decodeFloats(const AccessorView& view, float* dst, size_t dstStride, int n)
+    {
+        if (view.data != nullptr)
+        {
+            decodeDense<Type>(view, dst, dstStride, n);
+        }
+        else
+        {
+            //Accessor without bufferView is initialized with zeros
+            for (size_t i = 0; i < view.count; ++i)
+            {
+                std::fill_n(dstElement(dst, dstStride, i), n, 0.0f);
+            }
+        }
+        if (view.sparse.count > 0)
+        {
+            decodeSparse<Type>(view, dst, dstStride, n);
+        }
+    }
+
+    template<class T>
+    void widenIndices(const uint8_t* src, size_t count, uint32_t* dst)
+    {
+        size_t i = 0;
+        if constexpr (sizeof(T) == sizeof(uint32_t))
+        {
+            memcpy(dst, src, count * sizeof(uint32_t));
+            return;
+        }
+#ifdef ACCESSOR_DECODER_AVX2
+        for (; i + 16 <= count; i += 16)
+        {
+            if constexpr (sizeof(T) == 2)
+            {
+                __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+                __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 16));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtepu16_epi32(lo));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 8), _mm256_cvtepu16_epi32(hi));
+            }
+            else
+            {
+                __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtepu8_epi32(raw));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(raw, 8)));
+            }
+        }
+#endif
+#ifdef ACCESSOR_DECODER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i a, b;
+            if constexpr (sizeof(T) == 2)
+            {
+                a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+                b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 16));
+            }
+            else
+            {
+                __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                a = _mm_unpacklo_epi8(raw, zero);
+                b = _mm_unpackhi_epi8(raw, zero);
+            }
+            __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(a, zero));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(a, zero));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(b, zero));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(b, zero));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            dst[i] = readValue<T>(src + i * sizeof(T));
+        }
+    }
+}
+
+size_t AccessorDecoder::getComponentSize(int componentType)
+{
+    switch (componentType)
+    {
+    case AccessorView::Byte:
+    case AccessorView::UnsignedByte:
+        return 1;
+    case AccessorView::Short:
+    case AccessorView::UnsignedShort:
+        return 2;
+    case AccessorView::UnsignedInt:
+    case AccessorView::Float:
+        return 4;
+    default:
+        throw std::runtime_error("Unsupported accessor component type");
+    }
+}
+
+size_t AccessorDecoder::getElementSize(const AccessorView& view)
+{
+    return getComponentSize(view.componentType) * size_t(view.componentCount);
+}
+
+void AccessorDecoder::readFloats(const AccessorView& view, float* dst, size_t dstStride, int dstComponents)
+{
+    int n = std::min(view.componentCount, dstComponents);
+    if (n <= 0 || view.count == 0)
+    {
+        return;
+    }
+
+    switch (view.componentType)
+    {
+    case AccessorView::Byte:
+        decodeFloats<AccessorView::Byte>(view, dst, dstStride, n);
+        break;
+    case AccessorView::UnsignedByte:
+        decodeFloats<AccessorView::UnsignedByte>(view, dst, dstStride, n);
+        break;
+    case AccessorView::Short:
+        decodeFloats<AccessorView::Short>(view, dst, dstStride, n);
+        break;
+    case AccessorView::UnsignedShort:
+        decodeFloats<AccessorView::UnsignedShort>(view, dst, dstStride, n);
+        break;
+    case AccessorView::UnsignedInt:
+        decodeFloats<AccessorView::UnsignedInt>(view, dst, dstStride, n);
+        break;
+    case AccessorView::Float:
+        decodeFloats<AccessorView::Float>(view, dst, dstStride, n);
+        break;
+    default:
+        throw std::runtime_error("Unsupported accessor component type");
+    }
+}
+
+void AccessorDecoder::readIndices(const AccessorView& view, uint32_t* dst)
+{
+    if (view.componentCount != 1)
+    {
+        throw std::runtime_error("Index accessor must be SCALAR");
+    }
+
+    if (view.data == nullptr)
+    {
+        std::fill_n(dst, view.count, 0u);
+    }
+    else
+    {
+        //Index bufferViews are always tightly packed
+        switch (view.componentType)
+        {
+        case AccessorView::UnsignedByte:
+            widenIndices<uint8_t>(view.data, view.count, dst);
+            break;
+        case AccessorView::UnsignedShort:
+            widenIndices<uint16_t>(view.data, view.count, dst);
+            break;
+        case AccessorView::UnsignedInt:
+            widenIndices<uint32_t>(view.data, view.count, dst);
+            break;
+        default:
+            throw std::runtime_error("Unsupported index component type");
+        }
+    }
+
+    if (view.sparse.count == 0)
+    {
+        return;
+    }
+    const size_t indexSize = getComponentSize(view.sparse.indexComponentType);
+    const size_t valueSize = getComponentSize(view.componentType);
+    for (size_t k = 0; k < view.sparse.count; ++k)
+    {
+        const uint8_t* p = view.sparse.indices + k * indexSize;
+        size_t target = indexSize == 1 ? readValue<uint8_t>(p) : indexSize == 2 ? readValue<uint16_t>(p) : readValue<uint32_t>(p);
+        const uint8_t* v = view.sparse.values + k * valueSize;
+        if (target >= view.count)
+        {
+            throw std::runtime_error("Sparse accessor index out of range");
+        }
+        dst[target] = valueSize == 1 ? readValue<uint8_t>(v) : valueSize == 2 ? readValue<uint16_t>(v) : readValue<uint32_t>(v);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//glTF accessor resolved to memory. Component types use the glTF enum values.
+struct AccessorView
+{
+    enum ComponentType
+    {
+        Byte = 5120,
+        UnsignedByte = 5121,
+        Short = 5122,
+        UnsignedShort = 5123,
+        UnsignedInt = 5125,
+        Float = 5126,
+    };
+
+    struct Sparse
+    {
+        size_t count = 0;
+        const uint8_t* indices = nullptr;
+        int indexComponentType = 0;
+        const uint8_t* values = nullptr;
+    };
+
+    //First element, nullptr when the accessor has no bufferView (all zeros)
+    const uint8_t* data = nullptr;
+    //Readable bytes from data to the end of the bufferView
+    size_t available = 0;
+    size_t count = 0;
+    size_t byteStride = 0;
+    int componentType = 0;
+    int componentCount = 0;
+    bool normalized = false;
+    Sparse sparse;
+};
+
+//Decodes accessors of any component type, stride and sparseness into
+//caller owned arrays. Uses SSE2 (and AVX2 when compiled for it) kernels
+//for the dense part.
+class AccessorDecoder
+{
+public:
+    static size_t getComponentSize(int componentType);
+    static size_t getElementSize(const AccessorView& view);
+
+    //Write min(componentCount, dstComponents) floats per element to dst,
+    //advancing dstStride bytes per element. Normalized integers are mapped
+    //to [0,1] / [-1,1], other integers are converted as is.
+    static void readFloats(const AccessorView& view, float* dst, size_t dstStride, int dstComponents);
+
+    //Widen scalar index accessor to 32-bit
+    static void readIndices(const AccessorView& view, uint32_t* dst);
+};
@@ -0,0 +1,124 @@
+#include "AnimationSampler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ANIMATION_SAMPLER_SSE2 1
+#endif
+
+float AnimationSampler::wrapTime(float time, float duration, bool loop)
+{
+    if (!(duration > 0.0f))
+    {
+        return 0.0f;
+    }
+    if (!loop)
+    {
+        return std::clamp(time, 0.0f, duration);
+    }
+    const float wrapped = std::fmod(time, duration);
+    return wrapped < 0.0f ? wrapped + duration : wrapped;
+}
+
+namespace
+{
+    //Two frames around time and the blend factor between them
+    void findFrames(const CookedModel::Animation& animation, float time, uint32_t& frame, uint32_t& next, float& weight)
+    {
+        const float position = std::max(time, 0.0f) * animation.frameRate;
+        const uint32_t last = animation.frameCount - 1;
+        frame = std::min(uint32_t(position), last);
+        next = std::min(frame + 1, last);
+        weight = std::clamp(position - float(frame), 0.0f, 1.0f);
+    }
+}
+
+void AnimationSampler::sample(const CookedModel::Animation& animation, uint32_t jointCount, float time, JointPose* pose)
+{
+    uint32_t frame, next;
+    float weight;
+    findFrames(animation, time, frame, next, weight);
+    blend(animation.keys + size_t(frame) * jointCount, animation.keys + size_t(next) * jointCount, jointCount, weight, pose);
+}
+
+void AnimationSampler::sampleWeights(const CookedModel::Animation& animation, uint32_t weightCount, float time, float* weights)
+{
+    uint32_t frame, next;
+    float weight;
+    findFrames(animation, time, frame, next, weight);
+    blendWeights(animation.weights + size_t(frame) * weightCount, animation.weights + size_t(next) * weightCount, weightCount, weight, weights);
+}
+
+void AnimationSampler::blendWeights(const float* a, const float* b, uint32_t weightCount, float weight, float* result)
+{
+    uint32_t i = 0;
+#if ANIMATION_SAMPLER_SSE2
+    const __m128 w = _mm_set1_ps(weight);
+    for (; i + 4 <= weightCount; i += 4)
+    {
+        const __m128 va = _mm_loadu_ps(a + i);
+        _mm_storeu_ps(result + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + i), va), w)));
+    }
+#endif
+    for (; i < weightCount; ++i)
+    {
+        result[i] = a[i] + (b[i] - a[i]) * weight;
+    }
+}
+
+void AnimationSampler::blend(const JointPose* a, const JointPose* b, uint32_t jointCount, float weight, JointPose* result)
+{
+    uint32_t joint = 0;
+#if ANIMATION_SAMPLER_SSE2
+    const __m128 w = _mm_set1_ps(weight);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; joint < jointCount; ++joint)
+    {
+        const __m128 ta = _mm_loadu_ps(a[joint].translation);
+        const __m128 ra = _mm_loadu_ps(a[joint].rotation);
+        const __m128 sa = _mm_loadu_ps(a[joint].scale);
+        const __m128 tb = _mm_loadu_ps(b[joint].translation);
+        __m128 rb = _mm_loadu_ps(b[joint].rotation);
+        const __m128 sb = _mm_loadu_ps(b[joint].scale);
+
+        //q and -q are the same rotation, flip b onto a's hemisphere
+        __m128 d = _mm_mul_ps(ra, rb);
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+        rb = _mm_xor_ps(rb, _mm_and_ps(d, signMask));
+
+        __m128 r = _mm_add_ps(ra, _mm_mul_ps(_mm_sub_ps(rb, ra), w));
+        __m128 length = _mm_mul_ps(r, r);
+        length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(2, 3, 0, 1)));
+        length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(1, 0, 3, 2)));
+        r = _mm_div_ps(r, _mm_sqrt_ps(length));
+
+        _mm_storeu_ps(result[joint].translation, _mm_add_ps(ta, _mm_mul_ps(_mm_sub_ps(tb, ta), w)));
+        _mm_storeu_ps(result[joint].rotation, r);
+        _mm_storeu_ps(result[joint].scale, _mm_add_ps(sa, _mm_mul_ps(_mm_sub_ps(sb, sa), w)));
+    }
+#endif
+    for (; joint < jointCount; ++joint)
+    {
+        const auto& pa = a[joint];
+        const auto& pb = b[joint];
+        JointPose blended;
+        const float d = pa.rotation[0] * pb.rotation[0] + pa.rotation[1] * pb.rotation[1] + pa.rotation[2] * pb.rotation[2] + pa.rotation[3] * pb.rotation[3];
+        const float sign = d < 0.0f ? -1.0f : 1.0f;
+        float lengthSquared = 0.0f;
+        for (int i = 0; i < 4; ++i)
+        {
+            blended.translation[i] = pa.translation[i] + (pb.translation[i] - pa.translation[i]) * weight;
+            blended.scale[i] = pa.scale[i] + (pb.scale[i] - pa.scale[i]) * weight;
+            blended.rotation[i] = pa.rotation[i] + (pb.rotation[i] * sign - pa.rotation[i]) * weight;
+            lengthSquared += blended.rotation[i] * blended.rotation[i];
+        }
+        const float length = std::sqrt(lengthSquared);
+        for (int i = 0; i < 4; ++i)
+        {
+            blended.rotation[i] /= length;
+        }
+        result[joint] = blended;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include "ModelCache.h"
+
+//Pose sampling and blending on baked clips. Rotations use normalized lerp
+//along the short arc, which is close to slerp between neighbouring baked frames.
+class AnimationSampler
+{
+public:
+    //Time wrapped into the clip when looping, clamped to it otherwise
+    static float wrapTime(float time, float duration, bool loop);
+
+    //Pose of every joint at time (seconds, already wrapped) from the two nearest frames
+    static void sample(const CookedModel::Animation& animation, uint32_t jointCount, float time, JointPose* pose);
+
+    //result = a moved toward b by weight in [0, 1]; result may alias a or b
+    static void blend(const JointPose* a, const JointPose* b, uint32_t jointCount, float weight, JointPose* result);
+
+    //Morph target weights at time from the two nearest frames
+    static void sampleWeights(const CookedModel::Animation& animation, uint32_t weightCount, float time, float* weights);
+
+    //Linear mix of two weight sets, same aliasing rules as blend
+    static void blendWeights(const float* a, const float* b, uint32_t weightCount, float weight, float* result);
+};
@@ -0,0 +1,171 @@
+#include "AnimationSystem.h"
+#include "AnimationSampler.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MorphTargets.h"
+#include "Skinning.h"
+#include <algorithm>
+
+namespace
+{
+    //Vertices deformed per task when one mesh is split across the workers
+    constexpr size_t VerticesPerTask = 4096;
+}
+
+bool AnimationSystem::isAnimated(const CookedModel& model)
+{
+    return model.getSkeleton().jointCount != 0 || model.getMorphWeightCount() != 0;
+}
+
+std::shared_ptr<AnimationInstance> AnimationSystem::create(std::shared_ptr<const CookedModel> model)
+{
+    auto instance = std::make_shared<AnimationInstance>();
+    const auto& skeleton = model->getSkeleton();
+    instance->clip = model->getAnimations().empty() ? -1 : 0;
+    instance->jointMatrices.resize(size_t(skeleton.jointCount) * 16);
+    instance->skinMatrices.resize(size_t(skeleton.jointCount) * 16);
+    instance->pose.resize(skeleton.jointCount);
+    instance->blendPose.resize(skeleton.jointCount);
+    instance->morphWeights.assign(model->getMorphWeights(), model->getMorphWeights() + model->getMorphWeightCount());
+    instance->blendMorphWeights.resize(model->getMorphWeightCount());
+    instance->deformedVertices.resize(model->getPrimitives().size());
+    for (size_t i = 0; i < model->getPrimitives().size(); ++i)
+    {
+        const auto& primitive = model->getPrimitives()[i];
+        if (primitive.skin != nullptr || primitive.morphTargetCount != 0)
+        {
+            //Bind pose until the first update; deformed primitives always keep float vertices
+            const auto* vertices = static_cast<const ModelVertex*>(primitive.vertices);
+            instance->deformedVertices[i].assign(vertices, vertices + primitive.vertexCount);
+        }
+    }
+    instance->model = std::move(model);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_instances.push_back(instance);
+    return instance;
+}
+
+void AnimationSystem::update(float deltaTime)
+{
+    //Rebuilt every frame, so it lives in the frame arena
+    FrameVector<std::shared_ptr<AnimationInstance>> live;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        live.reserve(m_instances.size());
+        for (size_t i = 0; i < m_instances.size();)
+        {
+            if (auto instance = m_instances[i].lock())
+            {
+                live.push_back(std::move(instance));
+                ++i;
+            }
+            else
+            {
+                m_instances[i] = std::move(m_instances.back());
+                m_instances.pop_back();
+            }
+        }
+    }
+
+    JobSystem::getInstance().parallelFor(live.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            updateInstance(*live[i], deltaTime);
+        }
+    });
+}
+
+void AnimationSystem::updateInstance(AnimationInstance& instance, float deltaTime)
+{
+    const auto& model = *instance.model;
+    const auto& skeleton = model.getSkeleton();
+    const auto& animations = model.getAnimations();
+    const uint32_t weightCount = model.getMorphWeightCount();
+    if (skeleton.jointCount == 0 && weightCount == 0)
+    {
+        return;
+    }
+
+    //Clocks advance once, pose and weights are sampled at the same time
+    auto advance = [&](int clip, float& time) -> const CookedModel::Animation* {
+        if (clip < 0 || size_t(clip) >= animations.size())
+        {
+            return nullptr;
+        }
+        const auto& animation = animations[size_t(clip)];
+        time = AnimationSampler::wrapTime(time + deltaTime * instance.speed, animation.duration, instance.loop);
+        return &animation;
+    };
+    const auto* primary = advance(instance.clip, instance.time);
+    const bool blending = instance.blendClip >= 0 && instance.blendWeight > 0.0f;
+    const auto* secondary = blending ? advance(instance.blendClip, instance.blendTime) : nullptr;
+    const float blendWeight = std::min(instance.blendWeight, 1.0f);
+
+    if (skeleton.jointCount != 0)
+    {
+        auto samplePose = [&](const CookedModel::Animation* animation, float time, JointPose* pose) {
+            if (animation == nullptr)
+            {
+                std::copy(skeleton.restPose, skeleton.restPose + skeleton.jointCount, pose);
+                return;
+            }
+            AnimationSampler::sample(*animation, skeleton.jointCount, time, pose);
+        };
+        samplePose(primary, instance.time, instance.pose.data());
+        if (blending)
+        {
+            samplePose(secondary, instance.blendTime, instance.blendPose.data());
+            AnimationSampler::blend(instance.pose.data(), instance.blendPose.data(), skeleton.jointCount, blendWeight, instance.pose.data());
+        }
+        Skinning::computeMatrices(skeleton, instance.pose.data(), instance.jointMatrices.data(), instance.skinMatrices.data());
+    }
+    if (weightCount != 0)
+    {
+        auto sampleWeights = [&](const CookedModel::Animation* animation, float time, float* weights) {
+            if (animation == nullptr)
+            {
+                std::copy(model.getMorphWeights(), model.getMorphWeights() + weightCount, weights);
+                return;
+            }
+            AnimationSampler::sampleWeights(*animation, weightCount, time, weights);
+        };
+        sampleWeights(primary, instance.time, instance.morphWeights.data());
+        if (blending)
+        {
+            sampleWeights(secondary, instance.blendTime, instance.blendMorphWeights.data());
+            AnimationSampler::blendWeights(instance.morphWeights.data(), instance.blendMorphWeights.data(), weightCount, blendWeight, instance.morphWeights.data());
+        }
+    }
+
+    const auto& primitives = model.getPrimitives();
+    for (size_t i = 0; i < primitives.size(); ++i)
+    {
+        const auto& primitive = primitives[i];
+        const bool morphed = primitive.morphTargetCount != 0;
+        const bool skinned = primitive.skin != nullptr;
+        if (!morphed && !skinned)
+        {
+            continue;
+        }
+        //Deformed models are always cooked with float vertices
+        auto vertices = static_cast<const ModelVertex*>(primitive.vertices);
+        auto result = instance.deformedVertices[i].data();
+        const float* weights = instance.morphWeights.data() + primitive.morphWeightOffset;
+        JobSystem::getInstance().parallelFor(primitive.vertexCount, VerticesPerTask, [&](size_t begin, size_t end) {
+            //Morph targets move the bind pose, skinning then poses the morphed vertices in place
+            const ModelVertex* source = vertices;
+            if (morphed)
+            {
+                std::copy(vertices + begin, vertices + end, result + begin);
+                MorphTargets::apply(primitive.morphDeltas, primitive.morphTargetOffsets, primitive.morphTargetCount, weights, begin, end, result);
+                source = result;
+            }
+            if (skinned)
+            {
+                Skinning::skinVertices(instance.skinMatrices.data(), source, primitive.skin, begin, end, result);
+            }
+        });
+    }
+    ++instance.version;
+}
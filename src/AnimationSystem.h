@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ModelCache.h"
+
+//Playback state of one animated model and the deformed result of the last update.
+//Playback fields are set by game code between updates, outputs are read by the
+//renderer after them.
+struct AnimationInstance
+{
+    std::shared_ptr<const CookedModel> model;
+    //Index into model->getAnimations(), -1 holds the rest pose
+    int clip = 0;
+    float time = 0.0f;
+    float speed = 1.0f;
+    bool loop = true;
+    //Second clip mixed in by blendWeight in [0, 1], -1 for none; it advances
+    //on its own clock so cross-fades keep both motions going
+    int blendClip = -1;
+    float blendTime = 0.0f;
+    float blendWeight = 0.0f;
+
+    //Model space joint transforms, for attachments and hitboxes
+    std::vector<float> jointMatrices;
+    std::vector<float> skinMatrices;
+    //Morph target weights of the last update, indexed like CookedModel::getMorphWeights()
+    std::vector<float> morphWeights;
+    //Skinned and/or morphed vertices per primitive, empty for static ones
+    std::vector<std::vector<ModelVertex>> deformedVertices;
+    //Bumped by every update that produced new vertices
+    uint64_t version = 0;
+
+    //Scratch poses, sized once so updates never allocate
+    std::vector<JointPose> pose;
+    std::vector<JointPose> blendPose;
+    std::vector<float> blendMorphWeights;
+};
+
+//Batched animation for every live instance: clips are sampled and blended,
+//skinning matrices built, morph targets applied and vertices skinned once per
+//frame. Instances are spread across the JobSystem and large meshes are split
+//further, so many characters scale with the core count.
+class AnimationSystem
+{
+public:
+    //Model has a skeleton or morph targets to animate
+    static bool isAnimated(const CookedModel& model);
+
+    //Instance of an animated model playing its first clip, updated until released
+    std::shared_ptr<AnimationInstance> create(std::shared_ptr<const CookedModel> model);
+
+    //Advance every instance by deltaTime seconds and deform its vertices; call
+    //once per frame, the instance list is built in the FrameArena
+    void update(float deltaTime);
+
+private:
+    static void updateInstance(AnimationInstance& instance, float deltaTime);
+
+    std::mutex m_mutex;
+    std::vector<std::weak_ptr<AnimationInstance>> m_instances;
+};
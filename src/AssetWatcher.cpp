@@ -0,0 +1,59 @@
+#include "AssetWatcher.h"
+
+AssetWatcher::AssetWatcher(std::chrono::milliseconds interval)
+    : m_interval(interval), m_lastPoll(std::chrono::steady_clock::now())
+{
+}
+
+void AssetWatcher::watch(const std::string& path)
+{
+    for (const auto& entry : m_entries)
+    {
+        if (entry.path == path)
+        {
+            return;
+        }
+    }
+
+    Entry entry;
+    entry.path = path;
+    std::error_code ec;
+    entry.writeTime = std::filesystem::last_write_time(path, ec);
+    m_entries.push_back(entry);
+}
+
+std::vector<std::string> AssetWatcher::poll()
+{
+    std::vector<std::string> changed;
+    const auto now = std::chrono::steady_clock::now();
+    if (now - m_lastPoll < m_interval)
+    {
+        return changed;
+    }
+    m_lastPoll = now;
+
+    for (auto& entry : m_entries)
+    {
+        std::error_code ec;
+        auto writeTime = std::filesystem::last_write_time(entry.path, ec);
+        //Missing files (mid-save rename) keep their last known state
+        if (ec || writeTime == entry.writeTime)
+        {
+            entry.pending = false;
+            continue;
+        }
+
+        if (entry.pending && writeTime == entry.pendingTime)
+        {
+            entry.writeTime = writeTime;
+            entry.pending = false;
+            changed.push_back(entry.path);
+        }
+        else
+        {
+            entry.pendingTime = writeTime;
+            entry.pending = true;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//Polls last_write_time of registered files. A change is reported once the
+//write time has stayed the same for one poll interval, so files are not picked
+//up while an exporter is still writing them.
+class AssetWatcher
+{
+public:
+    explicit AssetWatcher(std::chrono::milliseconds interval = std::chrono::milliseconds(250));
+
+    //Start watching path, repeated calls for the same path are ignored
+    void watch(const std::string& path);
+
+    //Paths modified since the last report, empty until the interval has elapsed
+    std::vector<std::string> poll();
+
+private:
+    struct Entry
+    {
+        std::string path;
+        std::filesystem::file_time_type writeTime;
+        std::filesystem::file_time_type pendingTime;
+        bool pending = false;
+    };
+
+    std::vector<Entry> m_entries;
+    std::chrono::milliseconds m_interval;
+    std::chrono::steady_clock::time_point m_lastPoll;
+};
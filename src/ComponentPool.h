@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+//Entity handle: slot index plus the generation of the slot, so handles of
+//destroyed entities never alias the entity reusing the slot
+struct Entity
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+//Type erased part of a pool, lets the world drop every component of an entity
+class ComponentPoolBase
+{
+public:
+    virtual ~ComponentPoolBase() = default;
+    virtual bool contains(uint32_t index) const = 0;
+    virtual void remove(uint32_t index) = 0;
+    virtual size_t size() const = 0;
+    //Entity index of every component, in component order
+    const std::vector<uint32_t>& getEntities() const { return m_dense; }
+
+protected:
+    static constexpr uint32_t Absent = UINT32_MAX;
+    //Entity index to component slot, Absent where the entity has none
+    std::vector<uint32_t> m_sparse;
+    std::vector<uint32_t> m_dense;
+};
+
+//Sparse set of one component type. Components are packed into one array in
+//slot order; removal moves the last component into the hole, so the array
+//never has gaps and systems stream through it linearly.
+template<class T>
+class ComponentPool : public ComponentPoolBase
+{
+public:
+    //Called with the entity index before a component is removed or replaced
+    using Teardown = std::function<void(uint32_t, T&)>;
+
+    void setTeardown(Teardown teardown) { m_teardown = std::move(teardown); }
+
+    template<class... Args>
+    T& emplace(uint32_t index, Args&&... args)
+    {
+        if (index >= m_sparse.size())
+        {
+            m_sparse.resize(size_t(index) + 1, Absent);
+        }
+        if (m_sparse[index] != Absent)
+        {
+            //Replace in place, the slot keeps its position
+            T& component = m_components[m_sparse[index]];
+            if (m_teardown)
+            {
+                m_teardown(index, component);
+            }
+            component = T{ std::forward<Args>(args)... };
+            return component;
+        }
+        m_sparse[index] = uint32_t(m_dense.size());
+        m_dense.push_back(index);
+        m_components.push_back(T{ std::forward<Args>(args)... });
+        return m_components.back();
+    }
+
+    bool contains(uint32_t index) const override
+    {
+        return index < m_sparse.size() && m_sparse[index] != Absent;
+    }
+
+    void remove(uint32_t index) override
+    {
+        if (!contains(index))
+        {
+            return;
+        }
+        const uint32_t slot = m_sparse[index];
+        if (m_teardown)
+        {
+            m_teardown(index, m_components[slot]);
+        }
+        const uint32_t last = uint32_t(m_dense.size() - 1);
+        if (slot != last)
+        {
+            m_components[slot] = std::move(m_components[last]);
+            m_dense[slot] = m_dense[last];
+            m_sparse[m_dense[slot]] = slot;
+        }
+        m_components.pop_back();
+        m_dense.pop_back();
+        m_sparse[index] = Absent;
+    }
+
+    size_t size() const override { return m_components.size(); }
+
+    //Caller checks contains first
+    T& get(uint32_t index) { return m_components[m_sparse[index]]; }
+    const T& get(uint32_t index) const { return m_components[m_sparse[index]]; }
+
+    T* find(uint32_t index) { return contains(index) ? &m_components[m_sparse[index]] : nullptr; }
+
+    //Components packed in slot order, parallel to getEntities()
+    T* data() { return m_components.data(); }
+    const T* data() const { return m_components.data(); }
+
+private:
+    std::vector<T> m_components;
+    Teardown m_teardown;
+};
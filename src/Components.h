@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "ComponentPool.h"
+#include "Renderer.h"
+#include "SpatialIndex.h"
+#include "TransformHierarchy.h"
+
+//Components shared by the game's entities. Plain data only, behaviour lives in
+//the systems of Player, Enemy and Field.
+
+//Node in the scene's TransformHierarchy, which owns the pose and world matrix
+struct Transform
+{
+    TransformNode node;
+};
+
+//Entity findable through the scene's SpatialIndex, user data is the entity handle
+struct SpatialComponent
+{
+    //Half extent of the box around the world position
+    float radius = 1.0f;
+    uint32_t proxy = SpatialIndex::InvalidProxy;
+
+    //Index and generation together, so hits never resolve to an entity reusing the slot
+    static uint64_t toUserData(Entity entity) { return uint64_t(entity.generation) << 32 | entity.index; }
+    static Entity toEntity(uint64_t userData) { return Entity{ uint32_t(userData), uint32_t(userData >> 32) }; }
+};
+
+//Model drawn for the entity, the renderer is created by Scene::initialize
+struct RenderComponent
+{
+    UINT modelID = 0;
+    std::unique_ptr<Renderer> renderer;
+};
+
+//Entity steered by the player
+struct PlayerControl
+{
+    //Camera orbit per update in radians
+    float cameraSpin = 0.1f;
+};
+
+//Entity driven by enemy logic
+struct EnemyControl
+{
+};
@@ -0,0 +1,6 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//64-bit non-cryptographic hash of a byte range (XXH64 compatible)
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
@@ -1,10 +1,19 @@
 #include "Enemy.h"
 
-Enemy::Enemy()
+Entity Enemy::create(World& world, TransformHierarchy& transforms)
 {
-    m_modelID = 2;
+    Entity entity = world.create();
+    world.add<Transform>(entity, transforms.create());
+    world.add<SpatialComponent>(entity);
+    world.add<RenderComponent>(entity, 2u);
+    world.add<EnemyControl>(entity);
+    return entity;
 }
 
-void Enemy::update()
+void Enemy::update(const SystemContext& context)
 {
+    //Enemies are independent of each other, large groups are split across workers
+    context.world.parallelEach<EnemyControl, Transform>(EnemyChunkSize, [](Entity, EnemyControl&, Transform&)
+    {
+    });
 }
@@ -1,10 +1,16 @@
 #pragma once
-#include "GameObject.h"
-class Enemy :
-    public GameObject
+#include "SystemScheduler.h"
+#include "Components.h"
+
+//Enemy entity: prefab and per frame system
+class Enemy
 {
 public:
-    Enemy();
-    void update() override;
+    static Entity create(World& world, TransformHierarchy& transforms);
+    static void update(const SystemContext& context);
+
+private:
+    //Enemies updated per job
+    static constexpr size_t EnemyChunkSize = 64;
 };
 
@@ -1,13 +1,9 @@
 #include "Field.h"
 
-Field::Field()
+Entity Field::create(World& world, TransformHierarchy& transforms)
 {
-    m_modelID = 0;
+    Entity entity = world.create();
+    world.add<Transform>(entity, transforms.create());
+    world.add<RenderComponent>(entity, 0u);
+    return entity;
 }
-
-void Field::update()
-{
-    
-}
-
-
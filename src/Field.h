@@ -1,12 +1,12 @@
 #pragma once
-#include "GameObject.h"
+#include "World.h"
+#include "Components.h"
 
-class Field :
-    public GameObject
+//Static stage geometry, no per frame logic
+class Field
 {
 public:
-    Field();
-    void update() override;
+    static Entity create(World& world, TransformHierarchy& transforms);
 private:
     
 };
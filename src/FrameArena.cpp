@@ -0,0 +1,125 @@
+#include "FrameArena.h"
+#include <cstdio>
+#include "Log.h"
+
+namespace
+{
+    std::atomic<uint64_t> s_nextArenaId{ 1 };
+
+    //Last arena used by this thread, skips the lock on every allocation
+    struct ThreadCache
+    {
+        uint64_t arenaId = 0;
+        void* threadArena = nullptr;
+    };
+    thread_local ThreadCache t_cache;
+
+    size_t roundUpPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+FrameArena::FrameArena(size_t threadCapacity)
+    : m_id(s_nextArenaId.fetch_add(1))
+    , m_threadCapacity(threadCapacity)
+{
+}
+
+FrameArena& FrameArena::getInstance()
+{
+    static FrameArena arena;
+    return arena;
+}
+
+FrameArena::ThreadArena& FrameArena::getThreadArena()
+{
+    if (t_cache.arenaId == m_id)
+    {
+        return *static_cast<ThreadArena*>(t_cache.threadArena);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& threadArena = m_threadArenas[std::this_thread::get_id()];
+    if (!threadArena)
+    {
+        threadArena = std::make_unique<ThreadArena>();
+        for (auto& buffer : threadArena->buffers)
+        {
+            buffer.capacity = m_threadCapacity;
+        }
+    }
+    t_cache.arenaId = m_id;
+    t_cache.threadArena = threadArena.get();
+    return *threadArena;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    Buffer& buffer = getThreadArena().buffers[m_frameNumber.load(std::memory_order_relaxed) % FrameCount];
+    if (!buffer.memory)
+    {
+        buffer.memory.reset(new std::byte[buffer.capacity]);
+    }
+    //Align the address, the heap only guarantees the default new alignment
+    const uintptr_t base = reinterpret_cast<uintptr_t>(buffer.memory.get());
+    const uintptr_t aligned = (base + buffer.used + alignment - 1) & ~uintptr_t(alignment - 1);
+    if (aligned + size <= base + buffer.capacity)
+    {
+        buffer.used = size_t(aligned + size - base);
+        return reinterpret_cast<void*>(aligned);
+    }
+    //Out of room until the next rewind grows the buffer
+    buffer.overflow.emplace_back(new std::byte[size + alignment]);
+    buffer.overflowBytes += size + alignment;
+    const uintptr_t chunk = reinterpret_cast<uintptr_t>(buffer.overflow.back().get());
+    return reinterpret_cast<void*>((chunk + alignment - 1) & ~uintptr_t(alignment - 1));
+}
+
+void FrameArena::rewind(Buffer& buffer)
+{
+    if (!buffer.overflow.empty())
+    {
+        //Room for everything the frame asked for, allocated lazily on next use
+        buffer.capacity = roundUpPowerOfTwo(buffer.used + buffer.overflowBytes);
+        buffer.memory.reset();
+        buffer.overflow.clear();
+        buffer.overflowBytes = 0;
+    }
+    buffer.used = 0;
+}
+
+FrameArenaStats FrameArena::beginFrame()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FrameArenaStats stats;
+    const uint64_t frameNumber = m_frameNumber.load(std::memory_order_relaxed);
+    const uint32_t ending = uint32_t(frameNumber % FrameCount);
+    for (const auto& entry : m_threadArenas)
+    {
+        const Buffer& buffer = entry.second->buffers[ending];
+        stats.usedBytes += buffer.used + buffer.overflowBytes;
+        stats.overflowBytes += buffer.overflowBytes;
+    }
+    if (stats.usedBytes > m_highWaterBytes)
+    {
+        m_highWaterBytes = stats.usedBytes;
+        char line[256];
+        snprintf(line, sizeof(line), "Frame arena high-water mark %zu bytes at frame %llu across %zu threads, %zu bytes from the heap",
+            stats.usedBytes, (unsigned long long)frameNumber, m_threadArenas.size(), stats.overflowBytes);
+        logMessage(line);
+    }
+    stats.highWaterBytes = m_highWaterBytes;
+
+    m_frameNumber.store(frameNumber + 1, std::memory_order_relaxed);
+    const uint32_t starting = uint32_t((frameNumber + 1) % FrameCount);
+    for (auto& entry : m_threadArenas)
+    {
+        rewind(entry.second->buffers[starting]);
+    }
+    return stats;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//Memory use of one frame across every thread
+struct FrameArenaStats
+{
+    size_t usedBytes = 0;
+    //Largest usedBytes of any frame so far
+    size_t highWaterBytes = 0;
+    //Bytes that did not fit the sub-arenas and came from the heap
+    size_t overflowBytes = 0;
+};
+
+//Bump allocator for data that lives at most a few frames: culling lists, sort
+//keys, per frame scratch. Every thread bumps its own sub-arena, so allocation
+//is a pointer add without locks, and nothing is freed individually; a frame's
+//memory is rewound as a whole FrameCount frames later, once the GPU can no
+//longer read what was built in it. A sub-arena that runs out borrows from the
+//heap for the rest of the frame and is grown to fit at its next rewind, so a
+//steady workload stops touching the heap after a few frames.
+class FrameArena
+{
+public:
+    //Frames whose allocations are alive at once, matches the renderer's frame buffers
+    static constexpr uint32_t FrameCount = 2;
+    static constexpr size_t DefaultThreadCapacity = 256 << 10;
+
+    explicit FrameArena(size_t threadCapacity = DefaultThreadCapacity);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    //Process wide arena rewound by the main loop
+    static FrameArena& getInstance();
+
+    //Memory of the current frame on the calling thread, never fails
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    template<class T>
+    T* allocateArray(size_t count)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    //Frame boundary: rewinds the buffers of the frame about to start and
+    //returns the usage of the frame that ended. No thread may allocate meanwhile.
+    FrameArenaStats beginFrame();
+    uint64_t getFrameNumber() const { return m_frameNumber.load(std::memory_order_relaxed); }
+
+private:
+    struct Buffer
+    {
+        std::unique_ptr<std::byte[]> memory;
+        size_t capacity = 0;
+        size_t used = 0;
+        std::vector<std::unique_ptr<std::byte[]>> overflow;
+        size_t overflowBytes = 0;
+    };
+
+    struct ThreadArena
+    {
+        Buffer buffers[FrameCount];
+    };
+
+    ThreadArena& getThreadArena();
+    void rewind(Buffer& buffer);
+
+    //Distinguishes arenas in the per thread lookup cache
+    const uint64_t m_id;
+    const size_t m_threadCapacity;
+    std::atomic<uint64_t> m_frameNumber{ 0 };
+    size_t m_highWaterBytes = 0;
+    std::mutex m_mutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<ThreadArena>> m_threadArenas;
+};
+
+//STL allocator on FrameArena::getInstance(); deallocate is a no-op, memory
+//returns with the frame. Containers must not outlive FrameCount frames.
+template<class T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+
+    FrameAllocator() = default;
+    template<class U>
+    FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t count) { return FrameArena::getInstance().allocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template<class U>
+    bool operator==(const FrameAllocator<U>&) const { return true; }
+    template<class U>
+    bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template<class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -34,3 +34,13 @@ const bool Game::getIsGameRunning()
 {
     return m_isGameRunning;
 }
+
+void Game::setFrameArenaStats(const FrameArenaStats& stats)
+{
+    m_frameArenaStats = stats;
+}
+
+const FrameArenaStats& Game::getFrameArenaStats() const
+{
+    return m_frameArenaStats;
+}
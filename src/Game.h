@@ -1,5 +1,6 @@
 #pragma once
 #include "GameScene.h"
+#include "FrameArena.h"
 
 class Game
 {
@@ -11,9 +12,13 @@ public:
     void update();
     void terminate();
     const bool getIsGameRunning();
+    //Frame arena usage of the previous frame, set once per frame before update
+    void setFrameArenaStats(const FrameArenaStats& stats);
+    const FrameArenaStats& getFrameArenaStats() const;
 
 private:
     bool m_isGameRunning;
+    FrameArenaStats m_frameArenaStats;
     
     std::unordered_map<std::string, std::unique_ptr<Scene>> m_sceneList;
 };
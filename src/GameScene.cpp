@@ -3,17 +3,18 @@
 GameScene::GameScene()
 {
 
-    //m_gameObjectList.emplace_back(std::make_unique<Field>());
-    m_gameObjectList.emplace_back(std::make_unique<Player>());
-    //m_gameObjectList.emplace_back(std::make_unique<Enemy>());
+    //Field::create(m_world, m_transforms);
+    Player::create(m_world, m_transforms);
+    //Enemy::create(m_world, m_transforms);
+
+    //Disjoint component sets, the two systems run concurrently
+    m_systems.add(ComponentAccess().read<PlayerControl>().write<RenderComponent>(), Player::update);
+    m_systems.add(ComponentAccess().write<EnemyControl, Transform>(), Enemy::update);
 }
 
 void GameScene::update()
 {
-    for (size_t i = 0; i < m_gameObjectList.size(); ++i)
-    {
-        m_gameObjectList[i]->update();
-    }
+    m_systems.run(SystemContext{ m_world, m_transforms, m_spatialIndex });
 
 }
 
@@ -0,0 +1,159 @@
+#include "GlbReader.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t GlbMagic = 0x46546C67;       //"glTF"
+    constexpr uint32_t GlbVersion = 2;
+    constexpr uint32_t ChunkTypeJson = 0x4E4F534A;  //"JSON"
+    constexpr uint32_t ChunkTypeBinary = 0x004E4942;  //"BIN\0"
+    constexpr size_t HeaderSize = 12;
+    constexpr size_t ChunkHeaderSize = 8;
+
+    uint32_t readU32(const uint8_t* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+}
+
+void GlbReader::open(const std::string& path)
+{
+    m_document = nlohmann::json();
+    m_binary = nullptr;
+    m_binarySize = 0;
+    if (!m_file.open(path))
+    {
+        throw std::runtime_error("Failed to open model: " + path);
+    }
+
+    const uint8_t* data = m_file.data();
+    const size_t size = m_file.size();
+    if (size < HeaderSize || readU32(data) != GlbMagic)
+    {
+        throw std::runtime_error("Not a binary glTF file: " + path);
+    }
+    if (readU32(data + 4) != GlbVersion)
+    {
+        throw std::runtime_error("Unsupported glTF version: " + path);
+    }
+    const size_t length = readU32(data + 8);
+    if (length > size || length < HeaderSize)
+    {
+        throw std::runtime_error("Truncated glTF file: " + path);
+    }
+
+    //Chunk table: JSON first, then at most one BIN chunk, unknown chunks are skipped
+    const uint8_t* json = nullptr;
+    size_t jsonSize = 0;
+    size_t offset = HeaderSize;
+    while (offset + ChunkHeaderSize <= length)
+    {
+        const size_t chunkSize = readU32(data + offset);
+        const uint32_t chunkType = readU32(data + offset + 4);
+        offset += ChunkHeaderSize;
+        if (chunkSize > length - offset)
+        {
+            throw std::runtime_error("glTF chunk exceeds file size: " + path);
+        }
+
+        if (json == nullptr)
+        {
+            if (chunkType != ChunkTypeJson)
+            {
+                throw std::runtime_error("glTF file does not start with a JSON chunk: " + path);
+            }
+            json = data + offset;
+            jsonSize = chunkSize;
+        }
+        else if (chunkType == ChunkTypeBinary && m_binary == nullptr)
+        {
+            m_binary = data + offset;
+            m_binarySize = chunkSize;
+        }
+        //Chunks are padded to 4 bytes
+        offset += (chunkSize + 3) & ~size_t(3);
+    }
+    if (json == nullptr)
+    {
+        throw std::runtime_error("glTF file has no JSON chunk: " + path);
+    }
+
+    try
+    {
+        m_document = nlohmann::json::parse(json, json + jsonSize);
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        throw std::runtime_error("Failed to parse glTF JSON (" + path + "): " + e.what());
+    }
+    if (!m_document.is_object())
+    {
+        throw std::runtime_error("glTF JSON is not an object: " + path);
+    }
+}
+
+const nlohmann::json& GlbReader::getElement(const char* arrayName, int64_t index) const
+{
+    auto it = m_document.find(arrayName);
+    if (it == m_document.end() || !it->is_array() || index < 0 || uint64_t(index) >= it->size() || !(*it)[size_t(index)].is_object())
+    {
+        throw std::runtime_error(std::string("Invalid ") + arrayName + " index in glTF");
+    }
+    return (*it)[size_t(index)];
+}
+
+GlbReader::Span GlbReader::getBufferView(int64_t index) const
+{
+    const auto& bufferView = getElement("bufferViews", index);
+    const auto& buffer = getElement("buffers", getIndex(bufferView, "buffer"));
+    //Only the embedded BIN chunk is mapped, external and data URIs are not supported
+    if (buffer.contains("uri") || m_binary == nullptr)
+    {
+        throw std::runtime_error("glTF buffer is not stored in the BIN chunk");
+    }
+
+    const uint64_t byteOffset = getUnsigned(bufferView, "byteOffset", 0);
+    const uint64_t byteLength = getUnsigned(bufferView, "byteLength", 0);
+    if (byteOffset > m_binarySize || byteLength > m_binarySize - byteOffset)
+    {
+        throw std::runtime_error("bufferView exceeds buffer size in glTF");
+    }
+
+    Span span;
+    span.data = m_binary + byteOffset;
+    span.size = size_t(byteLength);
+    span.byteStride = size_t(getUnsigned(bufferView, "byteStride", 0));
+    return span;
+}
+
+uint64_t GlbReader::getUnsigned(const nlohmann::json& object, const char* key, uint64_t fallback)
+{
+    auto it = object.find(key);
+    if (it == object.end())
+    {
+        return fallback;
+    }
+    if (!it->is_number_unsigned())
+    {
+        throw std::runtime_error(std::string("glTF property is not an unsigned integer: ") + key);
+    }
+    return it->get<uint64_t>();
+}
+
+int64_t GlbReader::getIndex(const nlohmann::json& object, const char* key)
+{
+    auto it = object.find(key);
+    if (it == object.end())
+    {
+        return -1;
+    }
+    if (!it->is_number_unsigned())
+    {
+        throw std::runtime_error(std::string("glTF index is not an unsigned integer: ") + key);
+    }
+    return int64_t(std::min<uint64_t>(it->get<uint64_t>(), uint64_t(INT64_MAX)));
+}
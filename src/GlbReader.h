@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+#include "ThirdPartyHeaders/json.hpp"
+
+//Memory mapped .glb container. Validates the header and chunk table and hands
+//out spans into the mapping instead of copying the BIN chunk.
+class GlbReader
+{
+public:
+    struct Span
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        //0 when the bufferView is tightly packed
+        size_t byteStride = 0;
+    };
+
+    //Map and validate the file, throws std::runtime_error on malformed input
+    void open(const std::string& path);
+
+    const nlohmann::json& getDocument() const { return m_document; }
+    //The whole mapped file, e.g. for hashing
+    const uint8_t* getFileData() const { return m_file.data(); }
+    size_t getFileSize() const { return m_file.size(); }
+    //Entry of a top level array such as "accessors", throws when out of range
+    const nlohmann::json& getElement(const char* arrayName, int64_t index) const;
+    //Bounds checked view of a bufferView inside the BIN chunk
+    Span getBufferView(int64_t index) const;
+
+    //Optional glTF properties with validation, -1 for a missing index
+    static uint64_t getUnsigned(const nlohmann::json& object, const char* key, uint64_t fallback);
+    static int64_t getIndex(const nlohmann::json& object, const char* key);
+
+private:
+    MappedFile m_file;
+    nlohmann::json m_document;
+    const uint8_t* m_binary = nullptr;
+    size_t m_binarySize = 0;
+};
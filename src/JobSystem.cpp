@@ -0,0 +1,327 @@
+#include "JobSystem.h"
+#include <exception>
+#include <utility>
+
+struct JobSystem::Job
+{
+    std::function<void()> func;
+    //Unfinished dependencies plus one held by schedule while it registers them
+    std::atomic<uint32_t> pendingDependencies{ 1 };
+    std::mutex mutex;
+    //Jobs waiting for this one; the first few are stored inline, so typical
+    //dependency graphs do not allocate
+    static constexpr size_t InlineDependents = 4;
+    JobHandle dependents[InlineDependents];
+    size_t dependentCount = 0;
+    std::vector<JobHandle> moreDependents;
+    bool finished = false;
+    std::atomic<bool> done{ false };
+    std::exception_ptr error;
+};
+
+//Memory blocks of finished jobs. Every job allocates one block of the same
+//size holding the job and its reference counts.
+struct JobSystem::JobPool
+{
+    std::mutex mutex;
+    std::vector<void*> blocks;
+    size_t blockSize = 0;
+
+    ~JobPool()
+    {
+        for (void* block : blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+};
+
+//Allocator for allocate_shared, takes blocks from the JobPool before the heap
+template<class T>
+class JobSystem::JobAllocator
+{
+public:
+    using value_type = T;
+
+    explicit JobAllocator(std::shared_ptr<JobPool> pool) : m_pool(std::move(pool)) {}
+    template<class U>
+    JobAllocator(const JobAllocator<U>& other) : m_pool(other.m_pool) {}
+
+    T* allocate(size_t n)
+    {
+        const size_t size = n * sizeof(T);
+        {
+            std::lock_guard<std::mutex> lock(m_pool->mutex);
+            if (m_pool->blockSize == 0)
+            {
+                m_pool->blockSize = size;
+            }
+            if (size == m_pool->blockSize && !m_pool->blocks.empty())
+            {
+                void* block = m_pool->blocks.back();
+                m_pool->blocks.pop_back();
+                return static_cast<T*>(block);
+            }
+        }
+        return static_cast<T*>(::operator new(size));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_pool->mutex);
+            if (n * sizeof(T) == m_pool->blockSize)
+            {
+                m_pool->blocks.push_back(p);
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    template<class U>
+    bool operator==(const JobAllocator<U>& other) const { return m_pool == other.m_pool; }
+    template<class U>
+    bool operator!=(const JobAllocator<U>& other) const { return m_pool != other.m_pool; }
+
+private:
+    template<class U>
+    friend class JobAllocator;
+
+    std::shared_ptr<JobPool> m_pool;
+};
+
+namespace
+{
+    //Scheduler and deque owned by the current thread, null outside worker threads
+    thread_local JobSystem* t_system = nullptr;
+    thread_local size_t t_workerIndex = 0;
+}
+
+JobSystem::JobSystem(size_t workerCount)
+    : m_jobPool(std::make_shared<JobPool>())
+{
+    if (workerCount == 0)
+    {
+        const size_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    m_workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    m_threads.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        m_threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_sleepCondition.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+JobSystem& JobSystem::getInstance()
+{
+    static JobSystem system;
+    return system;
+}
+
+JobSystem::JobHandle JobSystem::schedule(std::function<void()> func, const std::vector<JobHandle>& dependencies)
+{
+    auto job = std::allocate_shared<Job>(JobAllocator<Job>(m_jobPool));
+    job->func = std::move(func);
+    for (const auto& dependency : dependencies)
+    {
+        if (!dependency)
+        {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (!dependency->finished)
+        {
+            job->pendingDependencies.fetch_add(1);
+            if (dependency->dependentCount < Job::InlineDependents)
+            {
+                dependency->dependents[dependency->dependentCount++] = job;
+            }
+            else
+            {
+                dependency->moreDependents.push_back(job);
+            }
+        }
+    }
+    if (job->pendingDependencies.fetch_sub(1) == 1)
+    {
+        enqueue(job);
+    }
+    return job;
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+    helpUntil([&job]() { return job->done.load(std::memory_order_acquire); });
+    if (job->error)
+    {
+        std::rethrow_exception(job->error);
+    }
+}
+
+bool JobSystem::isFinished(const JobHandle& job)
+{
+    return job->done.load(std::memory_order_acquire);
+}
+
+void JobSystem::enqueue(JobHandle job)
+{
+    //Workers keep their own jobs local, others spread round robin
+    const size_t index = t_system == this ? t_workerIndex : m_nextWorker.fetch_add(1) % m_workers.size();
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->pushBack(std::move(job));
+    }
+    m_queuedJobs.fetch_add(1);
+    {
+        //Orders the count against a worker checking it before sleeping
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_sleepCondition.notify_one();
+}
+
+JobSystem::JobHandle JobSystem::take()
+{
+    if (m_queuedJobs.load() == 0)
+    {
+        return nullptr;
+    }
+    const size_t workerCount = m_workers.size();
+    size_t first = m_nextWorker.load();
+    if (t_system == this)
+    {
+        //Newest own job first, its data is most likely still in cache
+        Worker& own = *m_workers[t_workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.count != 0)
+        {
+            JobHandle job = own.popBack();
+            m_queuedJobs.fetch_sub(1);
+            return job;
+        }
+        first = t_workerIndex + 1;
+    }
+    //Steal the oldest job of another deque
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        Worker& victim = *m_workers[(first + i) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.count != 0)
+        {
+            JobHandle job = victim.popFront();
+            m_queuedJobs.fetch_sub(1);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::Worker::pushBack(JobHandle job)
+{
+    if (count == jobs.size())
+    {
+        //Unroll the ring into a larger one
+        std::vector<JobHandle> grown(std::max<size_t>(16, jobs.size() * 2));
+        for (size_t i = 0; i < count; ++i)
+        {
+            grown[i] = std::move(jobs[(head + i) % jobs.size()]);
+        }
+        jobs.swap(grown);
+        head = 0;
+    }
+    jobs[(head + count) % jobs.size()] = std::move(job);
+    ++count;
+}
+
+JobSystem::JobHandle JobSystem::Worker::popBack()
+{
+    --count;
+    return std::move(jobs[(head + count) % jobs.size()]);
+}
+
+JobSystem::JobHandle JobSystem::Worker::popFront()
+{
+    JobHandle job = std::move(jobs[head]);
+    head = (head + 1) % jobs.size();
+    --count;
+    return job;
+}
+
+void JobSystem::run(const JobHandle& job)
+{
+    try
+    {
+        job->func();
+    }
+    catch (...)
+    {
+        job->error = std::current_exception();
+    }
+    //Drop captures now rather than when the last handle goes away
+    job->func = nullptr;
+    JobHandle dependents[Job::InlineDependents];
+    size_t dependentCount;
+    std::vector<JobHandle> moreDependents;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished = true;
+        dependentCount = job->dependentCount;
+        std::move(job->dependents, job->dependents + dependentCount, dependents);
+        job->dependentCount = 0;
+        moreDependents.swap(job->moreDependents);
+    }
+    job->done.store(true, std::memory_order_release);
+    auto release = [this](JobHandle& dependent) {
+        if (dependent->pendingDependencies.fetch_sub(1) == 1)
+        {
+            enqueue(std::move(dependent));
+        }
+    };
+    for (size_t i = 0; i < dependentCount; ++i)
+    {
+        release(dependents[i]);
+    }
+    for (auto& dependent : moreDependents)
+    {
+        release(dependent);
+    }
+}
+
+void JobSystem::workerLoop(size_t index)
+{
+    t_system = this;
+    t_workerIndex = index;
+    while (true)
+    {
+        JobHandle job = take();
+        if (job)
+        {
+            run(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepCondition.wait(lock, [this]() { return m_stopping || m_queuedJobs.load() > 0; });
+        if (m_stopping && m_queuedJobs.load() == 0)
+        {
+            return;
+        }
+    }
+}
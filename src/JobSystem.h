@@ -0,0 +1,151 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Work-stealing scheduler for frame work. Every worker owns a deque: it pushes
+//and pops jobs at the back, idle workers steal from the front of the others.
+//Jobs may depend on other jobs and start once every dependency has finished.
+//Threads waiting for a job run queued jobs meanwhile, so jobs can wait on
+//jobs without tying up a worker.
+class JobSystem
+{
+public:
+    struct Job;
+    using JobHandle = std::shared_ptr<Job>;
+
+    //workerCount 0 uses one worker per hardware thread besides the caller
+    explicit JobSystem(size_t workerCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    //Process wide scheduler for game systems
+    static JobSystem& getInstance();
+
+    //Run func once every job in dependencies has finished. Exceptions from
+    //func are rethrown by wait; dependents still run.
+    JobHandle schedule(std::function<void()> func, const std::vector<JobHandle>& dependencies = {});
+    //Block until job has finished, running other jobs meanwhile
+    void wait(const JobHandle& job);
+    static bool isFinished(const JobHandle& job);
+
+    //Run func(begin, end) over [0, count) in chunks on the workers and the
+    //calling thread, returns when every chunk is done. func must not throw.
+    template<class F>
+    void parallelFor(size_t count, size_t chunkSize, const F& func)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        chunkSize = chunkSize == 0 ? 1 : chunkSize;
+        if (count <= chunkSize)
+        {
+            func(size_t(0), count);
+            return;
+        }
+        //Up to one helper per worker pulls chunks alongside the caller. The
+        //caller returns only after every helper has finished, so the state lives
+        //on its stack and each job captures one reference, which std::function
+        //stores without allocating.
+        struct State
+        {
+            const F* func;
+            size_t count;
+            size_t chunkSize;
+            size_t chunkCount;
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> activeHelpers{ 0 };
+
+            void runChunks()
+            {
+                for (size_t chunk = next.fetch_add(1); chunk < chunkCount; chunk = next.fetch_add(1))
+                {
+                    const size_t begin = chunk * chunkSize;
+                    (*func)(begin, std::min(begin + chunkSize, count));
+                }
+            }
+        };
+        State state;
+        state.func = &func;
+        state.count = count;
+        state.chunkSize = chunkSize;
+        state.chunkCount = (count + chunkSize - 1) / chunkSize;
+        const size_t helpers = std::min(state.chunkCount - 1, m_workers.size());
+        state.activeHelpers.store(helpers);
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            schedule([&state]() {
+                state.runChunks();
+                state.activeHelpers.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        state.runChunks();
+        helpUntil([&state]() { return state.activeHelpers.load(std::memory_order_acquire) == 0; });
+    }
+
+    size_t getWorkerCount() const { return m_workers.size(); }
+
+private:
+    //Recycles job memory, see JobAllocator in the .cpp
+    struct JobPool;
+    template<class T>
+    class JobAllocator;
+
+    struct Worker
+    {
+        std::mutex mutex;
+        //Ring buffer of jobs; grows when full and never shrinks, so steady
+        //state scheduling does not allocate
+        std::vector<JobHandle> jobs;
+        size_t head = 0;
+        size_t count = 0;
+
+        void pushBack(JobHandle job);
+        JobHandle popBack();
+        JobHandle popFront();
+    };
+
+    //Run queued jobs until done() holds
+    template<class Done>
+    void helpUntil(const Done& done)
+    {
+        while (!done())
+        {
+            JobHandle next = take();
+            if (next)
+            {
+                run(next);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void workerLoop(size_t index);
+    void enqueue(JobHandle job);
+    //Pop from the own deque of a worker thread, otherwise steal; null when every deque is empty
+    JobHandle take();
+    void run(const JobHandle& job);
+
+    //Shared with the allocator of every job, so handles may outlive the system
+    std::shared_ptr<JobPool> m_jobPool;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    //Jobs sitting in any deque, lets idle workers sleep
+    std::atomic<size_t> m_queuedJobs{ 0 };
+    //Spreads jobs scheduled from outside the workers across their deques
+    std::atomic<size_t> m_nextWorker{ 0 };
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCondition;
+    bool m_stopping = false;
+};
@@ -0,0 +1,33 @@
+#include "Log.h"
+#include <atomic>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cstdio>
+#endif
+
+namespace
+{
+    std::atomic<bool> logEnabled{ true };
+}
+
+void setLogEnabled(bool enabled)
+{
+    logEnabled = enabled;
+}
+
+void logMessage(const std::string& message)
+{
+    if (!logEnabled)
+    {
+        return;
+    }
+#ifdef _WIN32
+    OutputDebugStringA((message + "\n").c_str());
+#else
+    fprintf(stderr, "%s\n", message.c_str());
+#endif
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+
+//Write a line to the debugger output (stderr on non-Windows builds)
+void logMessage(const std::string& message);
+
+//Drop messages, e.g. while benchmarking the import pipeline
+void setLogEnabled(bool enabled);
@@ -0,0 +1,199 @@
+#include "MeshBounds.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESH_BOUNDS_SSE2 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MESH_BOUNDS_AVX2 1
+#endif
+
+namespace
+{
+    void setCenter(BoundingVolume& bounds)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            bounds.center[axis] = (bounds.min[axis] + bounds.max[axis]) * 0.5f;
+        }
+    }
+
+    float getDistanceSquared(const float a[3], const float b[3])
+    {
+        const float dx = a[0] - b[0];
+        const float dy = a[1] - b[1];
+        const float dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    //Farthest squared distance from center; positions are strided by the vertex size
+    float getMaxDistanceSquared(const ModelVertex* vertices, size_t count, const float center[3])
+    {
+        size_t i = 0;
+        float result = 0.0f;
+#if MESH_BOUNDS_AVX2
+        //Two vertices per register: the 16 bytes at Pos hold x, y, z and a stray lane
+        const __m256 c = _mm256_setr_ps(center[0], center[1], center[2], 0.0f, center[0], center[1], center[2], 0.0f);
+        const __m256 mask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+        __m256 best = _mm256_setzero_ps();
+        for (; i + 2 <= count; i += 2)
+        {
+            const __m256 p = _mm256_setr_m128(_mm_loadu_ps(vertices[i].Pos), _mm_loadu_ps(vertices[i + 1].Pos));
+            const __m256 d = _mm256_and_ps(_mm256_sub_ps(p, c), mask);
+            __m256 sq = _mm256_mul_ps(d, d);
+            //Horizontal sum of the three lanes of each half
+            sq = _mm256_add_ps(sq, _mm256_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+            sq = _mm256_add_ps(sq, _mm256_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 0, 3, 2)));
+            best = _mm256_max_ps(best, sq);
+        }
+        const __m128 halves = _mm_max_ps(_mm256_castps256_ps128(best), _mm256_extractf128_ps(best, 1));
+        result = _mm_cvtss_f32(halves);
+#elif MESH_BOUNDS_SSE2
+        const __m128 c = _mm_setr_ps(center[0], center[1], center[2], 0.0f);
+        const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        __m128 best = _mm_setzero_ps();
+        for (; i < count; ++i)
+        {
+            const __m128 d = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(vertices[i].Pos), c), mask);
+            __m128 sq = _mm_mul_ps(d, d);
+            sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+            sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 0, 3, 2)));
+            best = _mm_max_ps(best, sq);
+        }
+        result = _mm_cvtss_f32(best);
+#endif
+        for (; i < count; ++i)
+        {
+            result = std::max(result, getDistanceSquared(vertices[i].Pos, center));
+        }
+        return result;
+    }
+}
+
+BoundingVolume MeshBounds::fromMinMax(const float minimum[3], const float maximum[3])
+{
+    BoundingVolume bounds;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        bounds.min[axis] = minimum[axis];
+        bounds.max[axis] = maximum[axis];
+    }
+    setCenter(bounds);
+    bounds.radius = std::sqrt(getDistanceSquared(bounds.min, bounds.center));
+    return bounds;
+}
+
+BoundingVolume MeshBounds::compute(const ModelVertex* vertices, size_t count)
+{
+    BoundingVolume bounds;
+    if (count == 0)
+    {
+        return bounds;
+    }
+
+    //Loading 16 bytes at Pos reads into Normal, which stays inside the vertex
+    static_assert(sizeof(ModelVertex) >= 4 * sizeof(float), "Position loads read four floats");
+    size_t i = 0;
+    float minimum[4] = { vertices[0].Pos[0], vertices[0].Pos[1], vertices[0].Pos[2], 0.0f };
+    float maximum[4] = { minimum[0], minimum[1], minimum[2], 0.0f };
+#if MESH_BOUNDS_AVX2
+    //Two vertices per register
+    __m256 lo = _mm256_setr_m128(_mm_loadu_ps(vertices[0].Pos), _mm_loadu_ps(vertices[0].Pos));
+    __m256 hi = lo;
+    for (; i + 2 <= count; i += 2)
+    {
+        const __m256 p = _mm256_setr_m128(_mm_loadu_ps(vertices[i].Pos), _mm_loadu_ps(vertices[i + 1].Pos));
+        lo = _mm256_min_ps(lo, p);
+        hi = _mm256_max_ps(hi, p);
+    }
+    _mm_storeu_ps(minimum, _mm_min_ps(_mm256_castps256_ps128(lo), _mm256_extractf128_ps(lo, 1)));
+    _mm_storeu_ps(maximum, _mm_max_ps(_mm256_castps256_ps128(hi), _mm256_extractf128_ps(hi, 1)));
+#elif MESH_BOUNDS_SSE2
+    __m128 lo = _mm_loadu_ps(vertices[0].Pos);
+    __m128 hi = lo;
+    for (; i < count; ++i)
+    {
+        const __m128 p = _mm_loadu_ps(vertices[i].Pos);
+        lo = _mm_min_ps(lo, p);
+        hi = _mm_max_ps(hi, p);
+    }
+    _mm_storeu_ps(minimum, lo);
+    _mm_storeu_ps(maximum, hi);
+#endif
+    for (; i < count; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = std::min(minimum[axis], vertices[i].Pos[axis]);
+            maximum[axis] = std::max(maximum[axis], vertices[i].Pos[axis]);
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        bounds.min[axis] = minimum[axis];
+        bounds.max[axis] = maximum[axis];
+    }
+    setCenter(bounds);
+    //Exact radius around the box center, usually much tighter than the box corners
+    bounds.radius = std::sqrt(getMaxDistanceSquared(vertices, count, bounds.center));
+    return bounds;
+}
+
+BoundingVolume MeshBounds::merge(const BoundingVolume& a, const BoundingVolume& b)
+{
+    BoundingVolume bounds;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        bounds.min[axis] = std::min(a.min[axis], b.min[axis]);
+        bounds.max[axis] = std::max(a.max[axis], b.max[axis]);
+    }
+
+    const float distance = std::sqrt(getDistanceSquared(a.center, b.center));
+    if (distance + b.radius <= a.radius)
+    {
+        std::copy(a.center, a.center + 3, bounds.center);
+        bounds.radius = a.radius;
+    }
+    else if (distance + a.radius <= b.radius)
+    {
+        std::copy(b.center, b.center + 3, bounds.center);
+        bounds.radius = b.radius;
+    }
+    else
+    {
+        //Sphere spanning the far sides of both, centered on the line between them
+        bounds.radius = (distance + a.radius + b.radius) * 0.5f;
+        const float t = (bounds.radius - a.radius) / distance;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            bounds.center[axis] = a.center[axis] + (b.center[axis] - a.center[axis]) * t;
+        }
+    }
+    return bounds;
+}
+
+bool MeshBounds::isVisible(const BoundingVolume& bounds, const float planes[6][4])
+{
+    for (int p = 0; p < 6; ++p)
+    {
+        const float* plane = planes[p];
+        const float* c = bounds.center;
+        if (plane[0] * c[0] + plane[1] * c[1] + plane[2] * c[2] + plane[3] < -bounds.radius)
+        {
+            return false;
+        }
+        //Box corner farthest along the plane normal
+        const float x = plane[0] >= 0.0f ? bounds.max[0] : bounds.min[0];
+        const float y = plane[1] >= 0.0f ? bounds.max[1] : bounds.min[1];
+        const float z = plane[2] >= 0.0f ? bounds.max[2] : bounds.min[2];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include "ModelData.h"
+
+//Bounding volume construction for primitives and whole models
+class MeshBounds
+{
+public:
+    //Box from known extents (glTF accessor min/max), sphere through its corners
+    static BoundingVolume fromMinMax(const float minimum[3], const float maximum[3]);
+
+    //SIMD min/max reduction over the positions, then the sphere around the box
+    //center with the distance to the farthest vertex as radius
+    static BoundingVolume compute(const ModelVertex* vertices, size_t count);
+
+    //Volume enclosing both; the sphere is the smallest one around both spheres
+    static BoundingVolume merge(const BoundingVolume& a, const BoundingVolume& b);
+
+    //Sphere then box against inward facing normalized planes in the same space,
+    //as produced by MeshClusters::extractFrustumPlanes
+    static bool isVisible(const BoundingVolume& bounds, const float planes[6][4]);
+};
@@ -0,0 +1,199 @@
+#include "MeshClusters.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    //Cones wider than this cannot reject anything useful
+    constexpr float MinConeDot = 0.1f;
+
+    void finishCluster(const std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices, MeshCluster& cluster)
+    {
+        //Sphere around the AABB center of the referenced vertices
+        float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t i = cluster.indexOffset; i < cluster.indexOffset + cluster.indexCount; ++i)
+        {
+            const auto& pos = vertices[indices[i]].Pos;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                minimum[axis] = std::min(minimum[axis], pos[axis]);
+                maximum[axis] = std::max(maximum[axis], pos[axis]);
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            cluster.center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+        }
+        float radiusSq = 0.0f;
+        for (uint32_t i = cluster.indexOffset; i < cluster.indexOffset + cluster.indexCount; ++i)
+        {
+            const auto& pos = vertices[indices[i]].Pos;
+            float dx = pos[0] - cluster.center[0];
+            float dy = pos[1] - cluster.center[1];
+            float dz = pos[2] - cluster.center[2];
+            radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+        }
+        cluster.radius = std::sqrt(radiusSq);
+
+        //Cone axis is the mean face normal, spread is the widest deviation from it
+        std::vector<float> normals;
+        normals.reserve(cluster.indexCount);
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t i = cluster.indexOffset; i < cluster.indexOffset + cluster.indexCount; i += 3)
+        {
+            const auto& p0 = vertices[indices[i]].Pos;
+            const auto& p1 = vertices[indices[i + 1]].Pos;
+            const auto& p2 = vertices[indices[i + 2]].Pos;
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            //glTF front faces wind counter-clockwise, e1 x e2 points outward
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length == 0.0f)
+            {
+                continue;
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                normals.push_back(n[k] / length);
+                axis[k] += n[k] / length;
+            }
+        }
+
+        cluster.coneCutoff = 1.0f;
+        float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        if (axisLength == 0.0f || normals.empty())
+        {
+            return;
+        }
+        float minDot = 1.0f;
+        for (size_t i = 0; i < normals.size(); i += 3)
+        {
+            float d = (normals[i] * axis[0] + normals[i + 1] * axis[1] + normals[i + 2] * axis[2]) / axisLength;
+            minDot = std::min(minDot, d);
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            cluster.coneAxis[k] = axis[k] / axisLength;
+        }
+        if (minDot > MinConeDot)
+        {
+            cluster.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+    }
+}
+
+void MeshClusters::build(const std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices, MeshLod& lod, std::vector<MeshCluster>& clusters)
+{
+    lod.clusterOffset = uint32_t(clusters.size());
+    lod.clusterCount = 0;
+
+    //Vertex to cluster stamp, avoids clearing a set per cluster
+    std::vector<uint32_t> seen(vertices.size(), ~0u);
+    uint32_t stamp = 0;
+    uint32_t clusterVertices = 0;
+
+    MeshCluster cluster;
+    cluster.indexOffset = lod.indexOffset;
+    const uint32_t end = lod.indexOffset + lod.indexCount;
+    for (uint32_t i = lod.indexOffset; i + 2 < end; i += 3)
+    {
+        uint32_t newVertices = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            newVertices += seen[indices[i + k]] != stamp ? 1 : 0;
+        }
+        if (cluster.indexCount > 0 &&
+            (clusterVertices + newVertices > MaxClusterVertices || cluster.indexCount / 3 + 1 > MaxClusterTriangles))
+        {
+            finishCluster(indices, vertices, cluster);
+            clusters.push_back(cluster);
+            cluster = MeshCluster();
+            cluster.indexOffset = i;
+            clusterVertices = 0;
+            ++stamp;
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            if (seen[indices[i + k]] != stamp)
+            {
+                seen[indices[i + k]] = stamp;
+                ++clusterVertices;
+            }
+        }
+        cluster.indexCount += 3;
+    }
+    if (cluster.indexCount > 0)
+    {
+        finishCluster(indices, vertices, cluster);
+        clusters.push_back(cluster);
+    }
+    lod.clusterCount = uint32_t(clusters.size()) - lod.clusterOffset;
+}
+
+void MeshClusters::extractFrustumPlanes(const float m[16], float planes[6][4])
+{
+    //clip = v * M, so plane component j combines row j of the clip x/y/z/w columns
+    for (int j = 0; j < 4; ++j)
+    {
+        float x = m[4 * j], y = m[4 * j + 1], z = m[4 * j + 2], w = m[4 * j + 3];
+        planes[0][j] = w + x;   //left
+        planes[1][j] = w - x;   //right
+        planes[2][j] = w + y;   //bottom
+        planes[3][j] = w - y;   //top
+        planes[4][j] = z;       //near, D3D clip z starts at 0
+        planes[5][j] = w - z;   //far
+    }
+    for (int p = 0; p < 6; ++p)
+    {
+        float length = std::sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if (length > 0.0f)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                planes[p][j] /= length;
+            }
+        }
+    }
+}
+
+void MeshClusters::cull(const MeshCluster* clusters, size_t clusterCount, const float planes[6][4], const float cameraPosition[3], std::vector<DrawRange>& ranges)
+{
+    for (size_t i = 0; i < clusterCount; ++i)
+    {
+        const auto& cluster = clusters[i];
+        const float* c = cluster.center;
+
+        bool visible = true;
+        for (int p = 0; p < 6 && visible; ++p)
+        {
+            visible = planes[p][0] * c[0] + planes[p][1] * c[1] + planes[p][2] * c[2] + planes[p][3] >= -cluster.radius;
+        }
+        if (!visible)
+        {
+            continue;
+        }
+
+        if (cluster.coneCutoff < 1.0f)
+        {
+            float d[3] = { c[0] - cameraPosition[0], c[1] - cameraPosition[1], c[2] - cameraPosition[2] };
+            float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            float along = d[0] * cluster.coneAxis[0] + d[1] * cluster.coneAxis[1] + d[2] * cluster.coneAxis[2];
+            if (along >= cluster.coneCutoff * distance + cluster.radius)
+            {
+                continue;
+            }
+        }
+
+        if (!ranges.empty() && ranges.back().indexOffset + ranges.back().indexCount == cluster.indexOffset)
+        {
+            ranges.back().indexCount += cluster.indexCount;
+        }
+        else
+        {
+            ranges.push_back({ cluster.indexOffset, cluster.indexCount });
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+//Contiguous index range drawn with one DrawIndexedInstanced call
+struct DrawRange
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+};
+
+//Splits detail levels into small clusters with bounds for per-cluster culling.
+//Clusters are consecutive triangles of the already cache-optimized index
+//stream, so each one is a plain index range and the draw order is unchanged.
+class MeshClusters
+{
+public:
+    //Cluster the triangles of lod, appending to clusters and recording the cluster range in lod
+    static void build(const std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices, MeshLod& lod, std::vector<MeshCluster>& clusters);
+
+    //Planes (a, b, c, d) facing inwards, extracted from a row-vector
+    //world-view-projection matrix so they live in model space
+    static void extractFrustumPlanes(const float worldViewProjection[16], float planes[6][4]);
+
+    //Append the index ranges of clusters inside the frustum and not facing away
+    //from the camera (model space), merging neighbouring ranges
+    static void cull(const MeshCluster* clusters, size_t clusterCount, const float planes[6][4], const float cameraPosition[3], std::vector<DrawRange>& ranges);
+};
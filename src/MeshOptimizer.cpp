@@ -0,0 +1,420 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    //Forsyth scoring parameters
+    constexpr int ForsythCacheSize = 32;
+    constexpr float CacheDecayPower = 1.5f;
+    constexpr float LastTriangleScore = 0.75f;
+    constexpr float ValenceBoostScale = 2.0f;
+    constexpr float ValenceBoostPower = 0.5f;
+    constexpr uint32_t MaxValenceTable = 32;
+
+    struct ScoreTables
+    {
+        float cache[ForsythCacheSize];
+        float valence[MaxValenceTable];
+
+        ScoreTables()
+        {
+            for (int i = 0; i < ForsythCacheSize; ++i)
+            {
+                cache[i] = i < 3 ? LastTriangleScore :
+                    std::pow(1.0f - float(i - 3) / float(ForsythCacheSize - 3), CacheDecayPower);
+            }
+            valence[0] = 0.0f;
+            for (uint32_t i = 1; i < MaxValenceTable; ++i)
+            {
+                valence[i] = ValenceBoostScale * std::pow(float(i), -ValenceBoostPower);
+            }
+        }
+    };
+
+    float vertexScore(const ScoreTables& tables, int cachePosition, uint32_t liveTriangles)
+    {
+        if (liveTriangles == 0)
+        {
+            return -1.0f;
+        }
+        float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+        score += liveTriangles < MaxValenceTable ? tables.valence[liveTriangles] :
+            ValenceBoostScale * std::pow(float(liveTriangles), -ValenceBoostPower);
+        return score;
+    }
+
+    //Exact FIFO cache simulation using insertion timestamps
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t vertexCount, uint32_t cacheSize)
+            : m_timestamps(vertexCount, 0), m_cacheSize(cacheSize), m_time(cacheSize + 1)
+        {
+        }
+
+        //Returns true on a miss
+        bool access(uint32_t vertex)
+        {
+            if (m_time - m_timestamps[vertex] > m_cacheSize)
+            {
+                m_timestamps[vertex] = m_time++;
+                return true;
+            }
+            return false;
+        }
+
+        void reset()
+        {
+            m_time += m_cacheSize + 1;
+        }
+
+    private:
+        std::vector<uint32_t> m_timestamps;
+        uint32_t m_cacheSize;
+        uint32_t m_time;
+    };
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.size() < 3)
+    {
+        return stats;
+    }
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t transformed = 0;
+    size_t unique = 0;
+    for (auto index : indices)
+    {
+        transformed += cache.access(index) ? 1 : 0;
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            ++unique;
+        }
+    }
+
+    stats.acmr = float(transformed) / float(indices.size() / 3);
+    stats.atvr = float(transformed) / float(unique);
+    return stats;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+    static const ScoreTables tables;
+
+    //Vertex to triangle adjacency, live triangles are kept at the front of each list
+    std::vector<uint32_t> liveCount(vertexCount, 0);
+    for (auto index : indices)
+    {
+        ++liveCount[index];
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                adjacency[fill[indices[t * 3 + k]]++] = uint32_t(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScores[v] = vertexScore(tables, -1, liveCount[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    uint32_t cache[ForsythCacheSize + 3];
+    uint32_t newCache[ForsythCacheSize + 3];
+    size_t cacheCount = 0;
+    size_t scanCursor = 0;
+    int64_t best = int64_t(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        //No candidate in the cache, continue with the next unemitted triangle
+        if (best < 0)
+        {
+            while (emitted[scanCursor])
+            {
+                ++scanCursor;
+            }
+            best = int64_t(scanCursor);
+        }
+
+        const uint32_t* tri = &indices[size_t(best) * 3];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[size_t(best)] = true;
+
+        //Remove triangle from its vertices' live lists
+        for (size_t k = 0; k < 3; ++k)
+        {
+            uint32_t v = tri[k];
+            uint32_t* list = &adjacency[adjacencyOffset[v]];
+            uint32_t count = liveCount[v];
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (list[i] == uint32_t(best))
+                {
+                    std::swap(list[i], list[count - 1]);
+                    break;
+                }
+            }
+            --liveCount[v];
+        }
+
+        //LRU update: emitted triangle moves to the front
+        size_t newCount = 0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            newCache[newCount++] = tri[k];
+        }
+        for (size_t i = 0; i < cacheCount; ++i)
+        {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+        for (size_t i = ForsythCacheSize; i < newCount; ++i)
+        {
+            cachePosition[newCache[i]] = -1;
+        }
+        cacheCount = std::min<size_t>(newCount, ForsythCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        //Rescore vertices in the cache and the triangles using them
+        for (size_t i = 0; i < newCount; ++i)
+        {
+            uint32_t v = newCache[i];
+            if (i < ForsythCacheSize)
+            {
+                cachePosition[v] = int(i);
+            }
+            float score = vertexScore(tables, cachePosition[v], liveCount[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+            const uint32_t* list = &adjacency[adjacencyOffset[v]];
+            for (uint32_t j = 0; j < liveCount[v]; ++j)
+            {
+                triangleScores[list[j]] += delta;
+            }
+        }
+
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cacheCount; ++i)
+        {
+            uint32_t v = cache[i];
+            const uint32_t* list = &adjacency[adjacencyOffset[v]];
+            for (uint32_t j = 0; j < liveCount[v]; ++j)
+            {
+                if (triangleScores[list[j]] > bestScore)
+                {
+                    bestScore = triangleScores[list[j]];
+                    best = list[j];
+                }
+            }
+        }
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices, float threshold)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+
+    //Hard boundaries: triangles where every vertex misses start a new cluster
+    std::vector<size_t> hardStarts;
+    {
+        FifoCache cache(vertices.size(), SimulatedCacheSize);
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            int misses = 0;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                misses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+            }
+            if (t == 0 || misses == 3)
+            {
+                hardStarts.push_back(t);
+            }
+        }
+        hardStarts.push_back(triangleCount);
+    }
+
+    //Soft boundaries: split further wherever the local ACMR stays within threshold
+    std::vector<size_t> clusterStarts;
+    {
+        FifoCache cache(vertices.size(), SimulatedCacheSize);
+        for (size_t c = 0; c + 1 < hardStarts.size(); ++c)
+        {
+            size_t start = hardStarts[c];
+            size_t end = hardStarts[c + 1];
+
+            cache.reset();
+            size_t clusterMisses = 0;
+            for (size_t t = start; t < end; ++t)
+            {
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    clusterMisses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+                }
+            }
+            const float clusterAcmr = float(clusterMisses) / float(end - start);
+
+            cache.reset();
+            clusterStarts.push_back(start);
+            size_t misses = 0;
+            size_t runStart = start;
+            for (size_t t = start; t < end; ++t)
+            {
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    misses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+                }
+                if (t + 1 < end && float(misses) / float(t + 1 - runStart) <= clusterAcmr * threshold)
+                {
+                    clusterStarts.push_back(t + 1);
+                    runStart = t + 1;
+                    misses = 0;
+                    cache.reset();
+                }
+            }
+        }
+        clusterStarts.push_back(triangleCount);
+    }
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+    if (clusterCount < 2)
+    {
+        return;
+    }
+
+    //Area weighted centroid and normal per cluster
+    float meshCentroid[3] = {};
+    float meshArea = 0.0f;
+    std::vector<float> clusterKeys(clusterCount);
+    std::vector<float> clusterData(clusterCount * 6, 0.0f);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        float* centroid = &clusterData[c * 6];
+        float* normal = &clusterData[c * 6 + 3];
+        float area = 0.0f;
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            const float* p0 = vertices[indices[t * 3]].Pos;
+            const float* p1 = vertices[indices[t * 3 + 1]].Pos;
+            const float* p2 = vertices[indices[t * 3 + 2]].Pos;
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float a = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int i = 0; i < 3; ++i)
+            {
+                centroid[i] += (p0[i] + p1[i] + p2[i]) / 3.0f * a;
+                normal[i] += n[i];
+            }
+            area += a;
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            meshCentroid[i] += centroid[i];
+            centroid[i] = area > 0.0f ? centroid[i] / area : 0.0f;
+        }
+        meshArea += area;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        meshCentroid[i] = meshArea > 0.0f ? meshCentroid[i] / meshArea : 0.0f;
+    }
+
+    //Clusters facing away from the mesh center are likely occluders, draw them first
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        const float* centroid = &clusterData[c * 6];
+        const float* normal = &clusterData[c * 6 + 3];
+        float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float key = 0.0f;
+        if (length > 0.0f)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                key += (centroid[i] - meshCentroid[i]) * normal[i] / length;
+            }
+        }
+        clusterKeys[c] = key;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return clusterKeys[a] > clusterKeys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (auto c : order)
+    {
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<ModelVertex>& vertices)
+{
+    std::vector<uint32_t> remap(vertices.size(), ~0u);
+    uint32_t next = 0;
+    for (auto& index : indices)
+    {
+        if (remap[index] == ~0u)
+        {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    std::vector<ModelVertex> reordered(next);
+    for (size_t v = 0; v < vertices.size(); ++v)
+    {
+        if (remap[v] != ~0u)
+        {
+            reordered[remap[v]] = vertices[v];
+        }
+    }
+    vertices.swap(reordered);
+    return remap;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+struct VertexCacheStats
+{
+    //Average cache miss ratio: transformed vertices per triangle (0.5 is ideal)
+    float acmr = 0.0f;
+    //Average transformed vertex ratio: transformed vertices per unique vertex (1.0 is ideal)
+    float atvr = 0.0f;
+};
+
+//Load-time reordering of triangle lists for post-transform cache, overdraw
+//and vertex fetch locality
+class MeshOptimizer
+{
+public:
+    //FIFO cache size used to simulate the post-transform cache
+    static constexpr uint32_t SimulatedCacheSize = 16;
+
+    static VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = SimulatedCacheSize);
+
+    //Reorder triangles for post-transform cache hits (Forsyth, linear-speed)
+    static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    //Reorder cache-optimized triangle clusters so outward facing clusters draw
+    //first. threshold bounds the ACMR increase caused by splitting clusters.
+    static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices, float threshold);
+
+    //Reorder vertices by first use and drop unreferenced ones. Returns the
+    //old to new vertex index remap (~0u for dropped vertices) so other
+    //per-vertex streams can follow.
+    static std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<ModelVertex>& vertices);
+};
@@ -0,0 +1,418 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    //Border edges get a perpendicular plane so open boundaries keep their shape
+    constexpr float BorderWeight = 10.0f;
+
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+    Vec3 position(const ModelVertex& vertex)
+    {
+        return { vertex.Pos[0], vertex.Pos[1], vertex.Pos[2] };
+    }
+
+    //Symmetric 4x4 plane quadric plus the accumulated weight
+    struct Quadric
+    {
+        float a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        float b0 = 0, b1 = 0, b2 = 0, c = 0;
+        float w = 0;
+
+        static Quadric fromPlane(const Vec3& n, float d, float weight)
+        {
+            Quadric q;
+            q.a00 = n.x * n.x * weight; q.a11 = n.y * n.y * weight; q.a22 = n.z * n.z * weight;
+            q.a01 = n.x * n.y * weight; q.a02 = n.x * n.z * weight; q.a12 = n.y * n.z * weight;
+            q.b0 = n.x * d * weight; q.b1 = n.y * d * weight; q.b2 = n.z * d * weight;
+            q.c = d * d * weight;
+            q.w = weight;
+            return q;
+        }
+
+        void add(const Quadric& q)
+        {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22; a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w;
+        }
+
+        //Weighted mean squared distance of p to the accumulated planes
+        float evaluate(const Vec3& p) const
+        {
+            float rx = a00 * p.x + a01 * p.y + a02 * p.z;
+            float ry = a01 * p.x + a11 * p.y + a12 * p.z;
+            float rz = a02 * p.x + a12 * p.y + a22 * p.z;
+            float e = p.x * rx + p.y * ry + p.z * rz + 2.0f * (p.x * b0 + p.y * b1 + p.z * b2) + c;
+            return w > 0.0f ? std::fabs(e) / w : 0.0f;
+        }
+    };
+
+    enum class VertexKind : uint8_t
+    {
+        Manifold,
+        Border,
+        Locked,
+    };
+
+    struct Edge
+    {
+        uint32_t a, b;
+        uint32_t count;
+    };
+
+    struct Collapse
+    {
+        uint32_t from, to;
+        float error;
+    };
+
+    uint64_t edgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    //Vertices with bitwise equal positions form one class that collapses as a unit
+    std::vector<uint32_t> buildPositionClasses(const std::vector<ModelVertex>& vertices)
+    {
+        struct PositionKey
+        {
+            uint32_t bits[3];
+            bool operator==(const PositionKey& other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+        };
+        struct PositionHash
+        {
+            size_t operator()(const PositionKey& key) const
+            {
+                return size_t(key.bits[0] * 73856093u ^ key.bits[1] * 19349663u ^ key.bits[2] * 83492791u);
+            }
+        };
+
+        std::unordered_map<PositionKey, uint32_t, PositionHash> lookup;
+        lookup.reserve(vertices.size());
+        std::vector<uint32_t> classes(vertices.size());
+        for (uint32_t i = 0; i < uint32_t(vertices.size()); ++i)
+        {
+            PositionKey key;
+            //+0.0 and -0.0 are the same position
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float value = vertices[i].Pos[axis] == 0.0f ? 0.0f : vertices[i].Pos[axis];
+                memcpy(&key.bits[axis], &value, sizeof(float));
+            }
+            classes[i] = lookup.emplace(key, i).first->second;
+        }
+        return classes;
+    }
+
+    //Undirected class edges with the number of triangles using them
+    std::vector<Edge> collectEdges(const std::vector<uint32_t>& triangles, const std::vector<uint32_t>& classes)
+    {
+        std::vector<uint64_t> keys;
+        keys.reserve(triangles.size());
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                keys.push_back(edgeKey(classes[triangles[i + k]], classes[triangles[i + (k + 1) % 3]]));
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<Edge> edges;
+        for (size_t i = 0; i < keys.size();)
+        {
+            size_t j = i;
+            while (j < keys.size() && keys[j] == keys[i])
+            {
+                ++j;
+            }
+            edges.push_back({ uint32_t(keys[i] >> 32), uint32_t(keys[i]), uint32_t(j - i) });
+            i = j;
+        }
+        return edges;
+    }
+
+    bool isBorder(const std::vector<Edge>& sortedEdges, uint32_t a, uint32_t b)
+    {
+        Edge probe{ std::min(a, b), std::max(a, b), 0 };
+        auto it = std::lower_bound(sortedEdges.begin(), sortedEdges.end(), probe,
+            [](const Edge& l, const Edge& r) { return l.a != r.a ? l.a < r.a : l.b < r.b; });
+        return it != sortedEdges.end() && it->a == probe.a && it->b == probe.b && it->count == 1;
+    }
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices,
+    size_t targetIndexCount, float targetError, float& resultError)
+{
+    resultError = 0.0f;
+    std::vector<uint32_t> triangles = indices;
+    if (triangles.size() <= targetIndexCount || vertices.empty())
+    {
+        return triangles;
+    }
+
+    const size_t vertexCount = vertices.size();
+    const auto classes = buildPositionClasses(vertices);
+    std::vector<Vec3> positions(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        positions[i] = position(vertices[i]);
+    }
+
+    //Wedge lists: all vertices sharing a class
+    std::vector<std::vector<uint32_t>> wedges(vertexCount);
+    for (uint32_t i = 0; i < uint32_t(vertexCount); ++i)
+    {
+        wedges[classes[i]].push_back(i);
+    }
+
+    //Face and border quadrics, accumulated per class
+    std::vector<Quadric> quadrics(vertexCount);
+    {
+        auto edges = collectEdges(triangles, classes);
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            const Vec3 p[3] = { positions[triangles[i]], positions[triangles[i + 1]], positions[triangles[i + 2]] };
+            Vec3 normal = cross(p[1] - p[0], p[2] - p[0]);
+            float length = std::sqrt(dot(normal, normal));
+            if (length == 0.0f)
+            {
+                continue;
+            }
+            normal = { normal.x / length, normal.y / length, normal.z / length };
+            auto face = Quadric::fromPlane(normal, -dot(normal, p[0]), length * 0.5f);
+            for (int k = 0; k < 3; ++k)
+            {
+                quadrics[classes[triangles[i + k]]].add(face);
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = classes[triangles[i + k]];
+                uint32_t b = classes[triangles[i + (k + 1) % 3]];
+                if (!isBorder(edges, a, b))
+                {
+                    continue;
+                }
+                Vec3 edge = p[(k + 1) % 3] - p[k];
+                float edgeLengthSq = dot(edge, edge);
+                Vec3 side = cross(edge, normal);
+                float sideLength = std::sqrt(dot(side, side));
+                if (sideLength == 0.0f)
+                {
+                    continue;
+                }
+                side = { side.x / sideLength, side.y / sideLength, side.z / sideLength };
+                auto border = Quadric::fromPlane(side, -dot(side, p[k]), edgeLengthSq * BorderWeight);
+                //Weight only shapes the error, it must not dilute the face average
+                border.w = 0.0f;
+                quadrics[a].add(border);
+                quadrics[b].add(border);
+            }
+        }
+    }
+
+    const float maxErrorSq = targetError * targetError;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> locked(vertexCount);
+    std::vector<VertexKind> kinds(vertexCount);
+    std::vector<uint32_t> borderEdgeCount(vertexCount);
+    std::vector<std::vector<uint32_t>> classTriangles(vertexCount);
+
+    while (triangles.size() > targetIndexCount)
+    {
+        auto edges = collectEdges(triangles, classes);
+
+        //Classify vertices: non-manifold edges and border corners are locked
+        std::fill(kinds.begin(), kinds.end(), VertexKind::Manifold);
+        std::fill(borderEdgeCount.begin(), borderEdgeCount.end(), 0);
+        for (const auto& edge : edges)
+        {
+            if (edge.count > 2)
+            {
+                kinds[edge.a] = VertexKind::Locked;
+                kinds[edge.b] = VertexKind::Locked;
+            }
+            else if (edge.count == 1)
+            {
+                ++borderEdgeCount[edge.a];
+                ++borderEdgeCount[edge.b];
+            }
+        }
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            if (kinds[i] != VertexKind::Locked && borderEdgeCount[i] > 0)
+            {
+                kinds[i] = borderEdgeCount[i] == 2 ? VertexKind::Border : VertexKind::Locked;
+            }
+        }
+
+        for (auto& list : classTriangles)
+        {
+            list.clear();
+        }
+        for (uint32_t i = 0; i < uint32_t(triangles.size()); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                classTriangles[classes[triangles[i + k]]].push_back(i);
+            }
+        }
+
+        //Cheapest valid direction per edge
+        std::vector<Collapse> candidates;
+        candidates.reserve(edges.size());
+        for (const auto& edge : edges)
+        {
+            Collapse best{ 0, 0, -1.0f };
+            for (int direction = 0; direction < 2; ++direction)
+            {
+                uint32_t from = direction == 0 ? edge.a : edge.b;
+                uint32_t to = direction == 0 ? edge.b : edge.a;
+                if (kinds[from] == VertexKind::Locked ||
+                    (kinds[from] == VertexKind::Border && (edge.count != 1 || kinds[to] != VertexKind::Border)))
+                {
+                    continue;
+                }
+                Quadric q = quadrics[from];
+                q.add(quadrics[to]);
+                float error = q.evaluate(positions[to]);
+                if (best.error < 0.0f || error < best.error)
+                {
+                    best = { from, to, error };
+                }
+            }
+            if (best.error >= 0.0f && best.error <= maxErrorSq)
+            {
+                candidates.push_back(best);
+            }
+        }
+        if (candidates.empty())
+        {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& l, const Collapse& r) { return l.error < r.error; });
+
+        //Roughly two triangles go away per collapse, leave slack for rejected ones
+        size_t collapseBudget = std::max<size_t>(1, (triangles.size() - targetIndexCount) / 6);
+        size_t collapsed = 0;
+        std::fill(locked.begin(), locked.end(), 0);
+        for (uint32_t i = 0; i < uint32_t(vertexCount); ++i)
+        {
+            remap[i] = i;
+        }
+
+        for (const auto& collapse : candidates)
+        {
+            if (collapsed >= collapseBudget)
+            {
+                break;
+            }
+            if (locked[collapse.from] || locked[collapse.to])
+            {
+                continue;
+            }
+
+            //Reject collapses that flip a surviving triangle
+            bool flips = false;
+            for (uint32_t t : classTriangles[collapse.from])
+            {
+                uint32_t c[3] = { classes[triangles[t]], classes[triangles[t + 1]], classes[triangles[t + 2]] };
+                if (c[0] == collapse.to || c[1] == collapse.to || c[2] == collapse.to)
+                {
+                    continue;
+                }
+                Vec3 before[3], after[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    before[k] = positions[c[k]];
+                    after[k] = c[k] == collapse.from ? positions[collapse.to] : before[k];
+                }
+                Vec3 n0 = cross(before[1] - before[0], before[2] - before[0]);
+                Vec3 n1 = cross(after[1] - after[0], after[2] - after[0]);
+                if (dot(n0, n1) <= 0.0f)
+                {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips)
+            {
+                continue;
+            }
+
+            //Lock the one-ring so the flip test above stays valid for this pass
+            for (uint32_t t : classTriangles[collapse.from])
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    locked[classes[triangles[t + k]]] = 1;
+                }
+            }
+            locked[collapse.to] = 1;
+
+            //Each wedge follows the target wedge with the closest normal and UV,
+            //so seams stay on their own side of the texture
+            for (uint32_t wedge : wedges[collapse.from])
+            {
+                const auto& n = vertices[wedge].Normal;
+                const auto& uv = vertices[wedge].UV;
+                uint32_t target = wedges[collapse.to].front();
+                float bestScore = -FLT_MAX;
+                for (uint32_t candidate : wedges[collapse.to])
+                {
+                    const auto& m = vertices[candidate].Normal;
+                    const auto& candidateUV = vertices[candidate].UV;
+                    const float du = uv[0] - candidateUV[0];
+                    const float dv = uv[1] - candidateUV[1];
+                    const float score = n[0] * m[0] + n[1] * m[1] + n[2] * m[2] - (du * du + dv * dv);
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        target = candidate;
+                    }
+                }
+                remap[wedge] = target;
+            }
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            resultError = std::max(resultError, collapse.error);
+            ++collapsed;
+        }
+        if (collapsed == 0)
+        {
+            break;
+        }
+
+        //Rewrite triangles and drop the ones that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            uint32_t a = remap[triangles[i]];
+            uint32_t b = remap[triangles[i + 1]];
+            uint32_t c = remap[triangles[i + 2]];
+            if (classes[a] == classes[b] || classes[b] == classes[c] || classes[a] == classes[c])
+            {
+                continue;
+            }
+            triangles[write++] = a;
+            triangles[write++] = b;
+            triangles[write++] = c;
+        }
+        triangles.resize(write);
+    }
+
+    resultError = std::sqrt(resultError);
+    return triangles;
+}
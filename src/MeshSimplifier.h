@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+//Quadric error metric edge collapse simplifier for LOD generation. Collapses
+//are restricted to existing vertices so every LOD indexes the same vertex
+//buffer; vertices sharing a position (normal seams) collapse together.
+class MeshSimplifier
+{
+public:
+    //Collapse edges until the triangle list shrinks to targetIndexCount or the
+    //next collapse would move the surface further than targetError (model
+    //units). resultError receives the largest error of the applied collapses.
+    static std::vector<uint32_t> simplify(const std::vector<uint32_t>& indices, const std::vector<ModelVertex>& vertices,
+        size_t targetIndexCount, float targetError, float& resultError);
+};
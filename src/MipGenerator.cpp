@@ -0,0 +1,374 @@
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIP_GENERATOR_AVX2 1
+#endif
+
+namespace
+{
+    constexpr float Pi = 3.14159265358979f;
+    //Kaiser window half width in destination texels and shape, as used by common texture tools
+    constexpr float KaiserWidth = 3.0f;
+    constexpr float KaiserAlpha = 4.0f;
+
+    float srgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    //Byte to linear float for sRGB and unorm channels
+    struct DecodeTables
+    {
+        float srgb[256];
+        float unorm[256];
+        DecodeTables()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                unorm[i] = float(i) / 255.0f;
+                srgb[i] = srgbToLinear(unorm[i]);
+            }
+        }
+    };
+
+    //Linear float quantized to 16 bits to sRGB byte, far below one output step
+    struct EncodeTable
+    {
+        static constexpr int Size = 1 << 16;
+        uint8_t srgb[Size];
+        EncodeTable()
+        {
+            for (int i = 0; i < Size; ++i)
+            {
+                srgb[i] = uint8_t(std::lround(linearToSrgb(float(i) / float(Size - 1)) * 255.0f));
+            }
+        }
+    };
+
+    const DecodeTables& getDecodeTables()
+    {
+        static const DecodeTables tables;
+        return tables;
+    }
+
+    const EncodeTable& getEncodeTable()
+    {
+        static const EncodeTable table;
+        return table;
+    }
+
+    float sinc(float x)
+    {
+        if (std::fabs(x) < 1e-5f)
+        {
+            return 1.0f;
+        }
+        return std::sin(Pi * x) / (Pi * x);
+    }
+
+    //Zeroth order modified Bessel function of the first kind
+    float bessel0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        const float half = x * 0.5f;
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (half / float(k)) * (half / float(k));
+            sum += term;
+            if (term < sum * 1e-7f)
+            {
+                break;
+            }
+        }
+        return sum;
+    }
+
+    //x in destination texels
+    float kaiser(float x)
+    {
+        const float t = x / KaiserWidth;
+        if (t * t >= 1.0f)
+        {
+            return 0.0f;
+        }
+        return sinc(x) * bessel0(KaiserAlpha * std::sqrt(1.0f - t * t)) / bessel0(KaiserAlpha);
+    }
+
+    //Source texels contributing to each destination texel along one axis,
+    //edge taps folded onto the border texels (clamp addressing)
+    struct Taps
+    {
+        std::vector<uint32_t> start;
+        std::vector<uint32_t> count;
+        std::vector<uint32_t> weightOffset;
+        std::vector<float> weights;
+    };
+
+    Taps buildTaps(uint32_t source, uint32_t destination, MipFilter filter)
+    {
+        Taps taps;
+        const float scale = float(source) / float(destination);
+        const float radius = filter == MipFilter::Box ? scale * 0.5f : KaiserWidth * scale;
+        std::vector<float> window;
+        for (uint32_t i = 0; i < destination; ++i)
+        {
+            const float center = (float(i) + 0.5f) * scale;
+            const int first = int(std::floor(center - radius));
+            const int last = int(std::ceil(center + radius));
+            const int begin = std::max(first, 0);
+            const int end = std::min(last, int(source) - 1);
+            window.assign(size_t(end - begin + 1), 0.0f);
+            float total = 0.0f;
+            for (int j = first; j <= last; ++j)
+            {
+                float weight;
+                if (filter == MipFilter::Box)
+                {
+                    //Exact coverage of texel j by the footprint
+                    weight = std::max(0.0f, std::min(float(j + 1), center + radius) - std::max(float(j), center - radius));
+                }
+                else
+                {
+                    weight = kaiser((float(j) + 0.5f - center) / scale);
+                }
+                window[size_t(std::clamp(j, begin, end) - begin)] += weight;
+                total += weight;
+            }
+            taps.start.push_back(uint32_t(begin));
+            taps.count.push_back(uint32_t(window.size()));
+            taps.weightOffset.push_back(uint32_t(taps.weights.size()));
+            for (float weight : window)
+            {
+                taps.weights.push_back(total != 0.0f ? weight / total : 0.0f);
+            }
+        }
+        return taps;
+    }
+
+    //Filter each row of RGBA float texels to the destination width
+    void filterRows(const float* source, uint32_t sourceWidth, uint32_t height, const Taps& taps, uint32_t width, float* destination)
+    {
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const float* row = source + size_t(y) * sourceWidth * 4;
+            float* out = destination + size_t(y) * width * 4;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const float* texel = row + size_t(taps.start[x]) * 4;
+                const float* weights = taps.weights.data() + taps.weightOffset[x];
+                const uint32_t count = taps.count[x];
+#ifdef MIP_GENERATOR_SSE2
+                //One RGBA texel per register
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t k = 0; k < count; ++k)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(texel + k * 4)));
+                }
+                _mm_storeu_ps(out + x * 4, sum);
+#else
+                float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (uint32_t k = 0; k < count; ++k)
+                {
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        sum[c] += weights[k] * texel[k * 4 + c];
+                    }
+                }
+                memcpy(out + x * 4, sum, sizeof(sum));
+#endif
+            }
+        }
+    }
+
+    //Filter whole rows into each destination row, vectorized along the row
+    void filterColumns(const float* source, uint32_t width, const Taps& taps, uint32_t height, float* destination)
+    {
+        const size_t rowFloats = size_t(width) * 4;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const float* rows = source + size_t(taps.start[y]) * rowFloats;
+            const float* weights = taps.weights.data() + taps.weightOffset[y];
+            const uint32_t count = taps.count[y];
+            float* out = destination + size_t(y) * rowFloats;
+            size_t i = 0;
+#ifdef MIP_GENERATOR_AVX2
+            for (; i + 8 <= rowFloats; i += 8)
+            {
+                __m256 sum = _mm256_setzero_ps();
+                for (uint32_t k = 0; k < count; ++k)
+                {
+                    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows + k * rowFloats + i)));
+                }
+                _mm256_storeu_ps(out + i, sum);
+            }
+#endif
+#ifdef MIP_GENERATOR_SSE2
+            for (; i + 4 <= rowFloats; i += 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t k = 0; k < count; ++k)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows + k * rowFloats + i)));
+                }
+                _mm_storeu_ps(out + i, sum);
+            }
+#endif
+            for (; i < rowFloats; ++i)
+            {
+                float sum = 0.0f;
+                for (uint32_t k = 0; k < count; ++k)
+                {
+                    sum += weights[k] * rows[k * rowFloats + i];
+                }
+                out[i] = sum;
+            }
+        }
+    }
+
+    //Float RGBA back to bytes; sRGB color goes through the encode table
+    void encodeLevel(const float* texels, size_t texelCount, bool srgb, uint8_t* out)
+    {
+        const auto& table = getEncodeTable();
+        size_t i = 0;
+#ifdef MIP_GENERATOR_SSE2
+        if (!srgb)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 scale = _mm_set1_ps(255.0f);
+            for (; i + 4 <= texelCount; i += 4)
+            {
+                __m128i packed[4];
+                for (int t = 0; t < 4; ++t)
+                {
+                    __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(texels + (i + t) * 4), zero), one);
+                    packed[t] = _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+                }
+                const __m128i words = _mm_packs_epi32(packed[0], packed[1]);
+                const __m128i words2 = _mm_packs_epi32(packed[2], packed[3]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_packus_epi16(words, words2));
+            }
+        }
+#endif
+        for (; i < texelCount; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                const float v = std::clamp(texels[i * 4 + c], 0.0f, 1.0f);
+                out[i * 4 + c] = srgb && c < 3
+                    ? table.srgb[int(v * float(EncodeTable::Size - 1) + 0.5f)]
+                    : uint8_t(v * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+uint32_t MipGenerator::getLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t size = std::max(width, height);
+    uint32_t count = 1;
+    while (size > 1 && count < MaxTextureLevels)
+    {
+        size >>= 1;
+        ++count;
+    }
+    return count;
+}
+
+void MipGenerator::generate(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter,
+    std::vector<TextureLevel>& levels, std::vector<uint8_t>& data)
+{
+    if (width == 0 || height == 0)
+    {
+        throw std::runtime_error("Texture has no texels");
+    }
+
+    auto appendLevel = [&](uint32_t levelWidth, uint32_t levelHeight) {
+        TextureLevel level;
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.rowPitch = levelWidth * 4;
+        level.size = level.rowPitch * levelHeight;
+        level.offset = uint32_t(data.size());
+        data.resize(data.size() + level.size);
+        levels.push_back(level);
+        return data.data() + level.offset;
+    };
+
+    //Reserve the whole chain up front so appending levels never reallocates
+    const uint32_t levelCount = getLevelCount(width, height);
+    size_t chainSize = 0;
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        chainSize += size_t(std::max(width >> level, 1u)) * std::max(height >> level, 1u) * 4;
+    }
+    data.reserve(data.size() + chainSize);
+
+    //The source level is stored as is
+    memcpy(appendLevel(width, height), pixels, size_t(width) * height * 4);
+    if (levelCount == 1)
+    {
+        return;
+    }
+
+    //The source is linearized one row at a time while filtering the first
+    //level, so no float copy of the full size image is ever made
+    const auto& decode = getDecodeTables();
+    const float* colorTable = srgb ? decode.srgb : decode.unorm;
+    std::vector<float> sourceRow(size_t(width) * 4);
+    std::vector<float> rows;
+    std::vector<float> current;
+    std::vector<float> next;
+    uint32_t currentWidth = width;
+    uint32_t currentHeight = height;
+    for (uint32_t level = 1; level < levelCount; ++level)
+    {
+        const uint32_t nextWidth = std::max(currentWidth >> 1, 1u);
+        const uint32_t nextHeight = std::max(currentHeight >> 1, 1u);
+        //Width first so the column pass runs on half the data
+        const auto rowTaps = buildTaps(currentWidth, nextWidth, filter);
+        rows.resize(size_t(nextWidth) * currentHeight * 4);
+        if (level == 1)
+        {
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                const uint8_t* texel = pixels + size_t(y) * width * 4;
+                for (size_t i = 0; i < size_t(width) * 4; i += 4)
+                {
+                    sourceRow[i] = colorTable[texel[i]];
+                    sourceRow[i + 1] = colorTable[texel[i + 1]];
+                    sourceRow[i + 2] = colorTable[texel[i + 2]];
+                    sourceRow[i + 3] = decode.unorm[texel[i + 3]];
+                }
+                filterRows(sourceRow.data(), width, 1, rowTaps, nextWidth, rows.data() + size_t(y) * nextWidth * 4);
+            }
+        }
+        else
+        {
+            filterRows(current.data(), currentWidth, currentHeight, rowTaps, nextWidth, rows.data());
+        }
+        next.resize(size_t(nextWidth) * nextHeight * 4);
+        filterColumns(rows.data(), nextWidth, buildTaps(currentHeight, nextHeight, filter), nextHeight, next.data());
+
+        encodeLevel(next.data(), size_t(nextWidth) * nextHeight, srgb, appendLevel(nextWidth, nextHeight));
+        //Later levels filter the float result, not the rounded bytes
+        current.swap(next);
+        currentWidth = nextWidth;
+        currentHeight = nextHeight;
+    }
+}
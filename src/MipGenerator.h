@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+//CPU mip chain generation for RGBA8 textures. Each level is resampled from the
+//previous one in float with a separable filter, so odd and non-power-of-two
+//sizes are filtered over their exact footprint instead of dropping texels.
+class MipGenerator
+{
+public:
+    //Levels of a full chain down to 1x1, capped at MaxTextureLevels
+    static uint32_t getLevelCount(uint32_t width, uint32_t height);
+
+    //Append every level, the source image first, to levels and data. Color
+    //channels of sRGB images are filtered in linear space; alpha always is.
+    static void generate(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter,
+        std::vector<TextureLevel>& levels, std::vector<uint8_t>& data);
+};
@@ -0,0 +1,902 @@
+#include "ModelCache.h"
+#include "ModelImporter.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MODEL_CACHE_SSE2 1
+#endif
+
+namespace
+{
+    //Bump whenever the blob layout or the import pipeline output changes
+    constexpr uint32_t CookedVersion = 16;
+    constexpr char CookedMagic[4] = { 'S', 'O', 'S', 'C' };
+    constexpr char CookedTextureMagic[4] = { 'S', 'O', 'S', 'T' };
+    constexpr uint64_t CookedAlignment = 16;
+
+    //Blob layout: CookedHeader | CookedPrimitive[primitiveCount] | CookedTextureSource[textureCount]
+    //| CookedAnimation[animationCount] | skeleton arrays | morph weights
+    //| vertex/index/cluster/skin/morph streams | texture material lists | animation keys and weights
+    struct CookedHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t fileSize;
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint64_t sourceHash;
+        uint64_t settingsHash;
+        uint32_t materialCount;
+        uint32_t primitiveCount;
+        uint32_t vertexFormat;
+        uint32_t textureCount;
+        uint32_t jointCount;
+        uint32_t animationCount;
+        uint32_t morphWeightCount;
+        uint32_t reserved;
+        uint64_t parentsOffset;
+        uint64_t inverseBindOffset;
+        uint64_t restPoseOffset;
+        //Default weights of every morph target of the model
+        uint64_t morphWeightsOffset;
+    };
+
+    struct CookedPrimitive
+    {
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t clusterOffset;
+        //0 for static primitives
+        uint64_t skinOffset;
+        //morphTargetCount + 1 delta offsets, then the deltas; 0 without targets
+        uint64_t morphTargetOffset;
+        uint64_t morphDeltaOffset;
+        uint64_t vertexHash;
+        uint64_t indexHash;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        int32_t materialIndex;
+        //2 or 4 bytes per index
+        uint32_t indexSize;
+        float positionOffset[3];
+        float positionScale[3];
+        uint32_t lodCount;
+        MeshLod lods[MaxLodCount];
+        uint32_t clusterCount;
+        BoundingVolume bounds;
+        uint32_t morphTargetCount;
+        uint32_t morphWeightOffset;
+    };
+
+    struct CookedTextureSource
+    {
+        uint64_t materialOffset;
+        uint32_t materialCount;
+        uint32_t role;
+        uint32_t imageIndex;
+        uint32_t reserved;
+    };
+
+    //Texture blob layout: CookedTextureHeader | levels back to back
+    struct CookedTextureHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t fileSize;
+        //Content hash of the model source the image was decoded from
+        uint64_t sourceHash;
+        uint64_t settingsHash;
+        uint32_t imageIndex;
+        uint32_t role;
+        uint32_t format;
+        uint32_t levelCount;
+        uint32_t dataSize;
+        uint32_t reserved;
+        TextureLevel levels[MaxTextureLevels];
+    };
+
+    struct CookedAnimation
+    {
+        uint64_t keysOffset;
+        //frameCount blocks of morphWeightCount weights
+        uint64_t weightsOffset;
+        float duration;
+        float frameRate;
+        uint32_t frameCount;
+        uint32_t reserved;
+        //Null terminated, longer names are cut
+        char name[48];
+    };
+
+    uint32_t getVertexStride(VertexFormat format)
+    {
+        return format == VertexFormat::Quantized ? sizeof(QuantizedVertex) : sizeof(ModelVertex);
+    }
+
+    //Narrowest index size able to address every vertex of the primitive
+    uint32_t selectIndexSize(size_t vertexCount)
+    {
+        return vertexCount <= 0xFFFF ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    //Pack 32-bit indices known to be below 65536 into 16-bit
+    void narrowIndices(const uint32_t* src, size_t count, uint16_t* dst)
+    {
+        size_t i = 0;
+#ifdef MODEL_CACHE_SSE2
+        //Bias into signed range so the saturating pack is exact
+        const __m128i bias32 = _mm_set1_epi32(0x8000);
+        const __m128i bias16 = _mm_set1_epi16(short(0x8000));
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i a = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), bias32);
+            __m128i b = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4)), bias32);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(_mm_packs_epi32(a, b), bias16));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            dst[i] = uint16_t(src[i]);
+        }
+    }
+
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + CookedAlignment - 1) & ~(CookedAlignment - 1);
+    }
+
+    const CookedHeader* readHeader(const uint8_t* data, size_t size)
+    {
+        if (data == nullptr || size < sizeof(CookedHeader))
+        {
+            return nullptr;
+        }
+        auto header = reinterpret_cast<const CookedHeader*>(data);
+        if (memcmp(header->magic, CookedMagic, sizeof(CookedMagic)) != 0 ||
+            header->version != CookedVersion ||
+            header->fileSize != size ||
+            header->vertexFormat > uint32_t(VertexFormat::Quantized))
+        {
+            return nullptr;
+        }
+        return header;
+    }
+
+    const CookedTextureHeader* readTextureHeader(const uint8_t* data, size_t size)
+    {
+        if (data == nullptr || size < sizeof(CookedTextureHeader))
+        {
+            return nullptr;
+        }
+        auto header = reinterpret_cast<const CookedTextureHeader*>(data);
+        if (memcmp(header->magic, CookedTextureMagic, sizeof(CookedTextureMagic)) != 0 ||
+            header->version != CookedVersion ||
+            header->fileSize != size)
+        {
+            return nullptr;
+        }
+        return header;
+    }
+
+    bool readSourceStamp(const std::string& path, ModelCache::SourceStamp& stamp)
+    {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec)
+        {
+            return false;
+        }
+        auto writeTime = std::filesystem::last_write_time(path, ec);
+        if (ec)
+        {
+            return false;
+        }
+        stamp.size = uint64_t(size);
+        stamp.writeTime = int64_t(writeTime.time_since_epoch().count());
+        return true;
+    }
+}
+
+bool CookedModel::bind(const uint8_t* data, size_t size)
+{
+    auto header = readHeader(data, size);
+    if (header == nullptr)
+    {
+        return false;
+    }
+
+    uint64_t tableEnd = alignUp(sizeof(CookedHeader)) + uint64_t(header->primitiveCount) * sizeof(CookedPrimitive);
+    if (tableEnd > size)
+    {
+        return false;
+    }
+    auto records = reinterpret_cast<const CookedPrimitive*>(data + alignUp(sizeof(CookedHeader)));
+    const auto vertexFormat = VertexFormat(header->vertexFormat);
+    const uint32_t vertexStride = getVertexStride(vertexFormat);
+
+    //Skeleton first, skin streams are checked against its joint count
+    const uint32_t jointCount = header->jointCount;
+    m_skeleton = Skeleton();
+    if (jointCount != 0)
+    {
+        if (header->parentsOffset + uint64_t(jointCount) * sizeof(int32_t) > size ||
+            header->inverseBindOffset + uint64_t(jointCount) * 16 * sizeof(float) > size ||
+            header->restPoseOffset + uint64_t(jointCount) * sizeof(JointPose) > size)
+        {
+            return false;
+        }
+        auto parents = reinterpret_cast<const int32_t*>(data + header->parentsOffset);
+        for (uint32_t joint = 0; joint < jointCount; ++joint)
+        {
+            if (parents[joint] < -1 || parents[joint] >= int32_t(joint))
+            {
+                return false;
+            }
+        }
+        m_skeleton.jointCount = jointCount;
+        m_skeleton.parents = parents;
+        m_skeleton.inverseBindMatrices = reinterpret_cast<const float*>(data + header->inverseBindOffset);
+        m_skeleton.restPose = reinterpret_cast<const JointPose*>(data + header->restPoseOffset);
+    }
+
+    const uint32_t morphWeightCount = header->morphWeightCount;
+    if (header->morphWeightsOffset + uint64_t(morphWeightCount) * sizeof(float) > size ||
+        (morphWeightCount != 0 && vertexFormat != VertexFormat::Float))
+    {
+        return false;
+    }
+    m_morphWeights = morphWeightCount != 0 ? reinterpret_cast<const float*>(data + header->morphWeightsOffset) : nullptr;
+    m_morphWeightCount = morphWeightCount;
+
+    //Pointer fixups
+    m_primitives.clear();
+    m_primitives.reserve(header->primitiveCount);
+    for (uint32_t i = 0; i < header->primitiveCount; ++i)
+    {
+        const auto& record = records[i];
+        if ((record.indexSize != sizeof(uint16_t) && record.indexSize != sizeof(uint32_t)) ||
+            record.vertexOffset + uint64_t(record.vertexCount) * vertexStride > size ||
+            record.indexOffset + uint64_t(record.indexCount) * record.indexSize > size ||
+            record.clusterOffset + uint64_t(record.clusterCount) * sizeof(MeshCluster) > size ||
+            (record.skinOffset != 0 && (jointCount == 0 || vertexFormat != VertexFormat::Float || record.skinOffset + uint64_t(record.vertexCount) * sizeof(SkinInfluence) > size)) ||
+            (record.morphTargetCount != 0 && (uint64_t(record.morphWeightOffset) + record.morphTargetCount > morphWeightCount ||
+                record.morphTargetOffset + (uint64_t(record.morphTargetCount) + 1) * sizeof(uint32_t) > size)) ||
+            record.lodCount == 0 || record.lodCount > MaxLodCount)
+        {
+            m_primitives.clear();
+            return false;
+        }
+        for (uint32_t lod = 0; lod < record.lodCount; ++lod)
+        {
+            if (uint64_t(record.lods[lod].indexOffset) + record.lods[lod].indexCount > record.indexCount ||
+                uint64_t(record.lods[lod].clusterOffset) + record.lods[lod].clusterCount > record.clusterCount)
+            {
+                m_primitives.clear();
+                return false;
+            }
+        }
+
+        Primitive primitive;
+        primitive.vertices = data + record.vertexOffset;
+        primitive.vertexCount = record.vertexCount;
+        primitive.vertexStride = vertexStride;
+        primitive.indices = data + record.indexOffset;
+        primitive.indexCount = record.indexCount;
+        primitive.indexSize = record.indexSize;
+        primitive.materialIndex = record.materialIndex;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            primitive.dequantization.offset[axis] = record.positionOffset[axis];
+            primitive.dequantization.scale[axis] = record.positionScale[axis];
+        }
+        primitive.lodCount = record.lodCount;
+        std::copy(record.lods, record.lods + MaxLodCount, primitive.lods);
+        primitive.clusters = reinterpret_cast<const MeshCluster*>(data + record.clusterOffset);
+        primitive.clusterCount = record.clusterCount;
+        primitive.bounds = record.bounds;
+        primitive.skin = nullptr;
+        if (record.skinOffset != 0)
+        {
+            //Joint indices drive matrix palette lookups, never trust them blindly
+            auto skin = reinterpret_cast<const SkinInfluence*>(data + record.skinOffset);
+            for (uint32_t v = 0; v < record.vertexCount; ++v)
+            {
+                for (int k = 0; k < 4; ++k)
+                {
+                    if (skin[v].joints[k] >= jointCount)
+                    {
+                        m_primitives.clear();
+                        return false;
+                    }
+                }
+            }
+            primitive.skin = skin;
+        }
+        primitive.morphDeltas = nullptr;
+        primitive.morphTargetOffsets = nullptr;
+        primitive.morphTargetCount = 0;
+        primitive.morphWeightOffset = record.morphWeightOffset;
+        if (record.morphTargetCount != 0)
+        {
+            //Ranges must be ordered and deltas must stay inside the vertex stream
+            auto offsets = reinterpret_cast<const uint32_t*>(data + record.morphTargetOffset);
+            auto deltas = reinterpret_cast<const MorphDelta*>(data + record.morphDeltaOffset);
+            bool valid = offsets[0] == 0 && record.morphDeltaOffset + uint64_t(offsets[record.morphTargetCount]) * sizeof(MorphDelta) <= size;
+            for (uint32_t t = 0; valid && t < record.morphTargetCount; ++t)
+            {
+                valid = offsets[t] <= offsets[t + 1];
+            }
+            for (uint32_t d = 0; valid && d < offsets[record.morphTargetCount]; ++d)
+            {
+                valid = deltas[d].vertex < record.vertexCount;
+            }
+            if (!valid)
+            {
+                m_primitives.clear();
+                return false;
+            }
+            primitive.morphDeltas = deltas;
+            primitive.morphTargetOffsets = offsets;
+            primitive.morphTargetCount = record.morphTargetCount;
+        }
+        primitive.vertexHash = record.vertexHash;
+        primitive.indexHash = record.indexHash;
+        m_primitives.push_back(primitive);
+    }
+
+    //Texture source table follows the primitive table
+    const uint64_t textureTable = tableEnd;
+    if (textureTable + uint64_t(header->textureCount) * sizeof(CookedTextureSource) > size)
+    {
+        m_primitives.clear();
+        return false;
+    }
+    auto textureRecords = reinterpret_cast<const CookedTextureSource*>(data + textureTable);
+    m_textureSources.clear();
+    m_textureSources.reserve(header->textureCount);
+    for (uint32_t i = 0; i < header->textureCount; ++i)
+    {
+        const auto& record = textureRecords[i];
+        if (record.role > uint32_t(TextureRole::OcclusionRoughnessMetallic) ||
+            record.materialOffset + uint64_t(record.materialCount) * sizeof(uint32_t) > size)
+        {
+            m_primitives.clear();
+            m_textureSources.clear();
+            return false;
+        }
+
+        TextureSource source;
+        source.imageIndex = record.imageIndex;
+        source.role = TextureRole(record.role);
+        source.materialIndices = reinterpret_cast<const uint32_t*>(data + record.materialOffset);
+        source.materialCount = record.materialCount;
+        m_textureSources.push_back(source);
+    }
+
+    //Animation table follows the texture source table
+    const uint64_t animationTable = textureTable + uint64_t(header->textureCount) * sizeof(CookedTextureSource);
+    if (animationTable + uint64_t(header->animationCount) * sizeof(CookedAnimation) > size ||
+        (header->animationCount != 0 && jointCount == 0 && morphWeightCount == 0))
+    {
+        m_primitives.clear();
+        m_textureSources.clear();
+        return false;
+    }
+    auto animationRecords = reinterpret_cast<const CookedAnimation*>(data + animationTable);
+    m_animations.clear();
+    m_animations.reserve(header->animationCount);
+    for (uint32_t i = 0; i < header->animationCount; ++i)
+    {
+        const auto& record = animationRecords[i];
+        if (record.frameCount == 0 || !(record.frameRate > 0.0f) || record.name[sizeof(record.name) - 1] != '\0' ||
+            record.keysOffset + uint64_t(record.frameCount) * jointCount * sizeof(JointPose) > size ||
+            record.weightsOffset + uint64_t(record.frameCount) * morphWeightCount * sizeof(float) > size)
+        {
+            m_primitives.clear();
+            m_textureSources.clear();
+            m_animations.clear();
+            return false;
+        }
+        Animation animation;
+        animation.name = record.name;
+        animation.duration = record.duration;
+        animation.frameRate = record.frameRate;
+        animation.frameCount = record.frameCount;
+        animation.keys = reinterpret_cast<const JointPose*>(data + record.keysOffset);
+        animation.weights = morphWeightCount != 0 ? reinterpret_cast<const float*>(data + record.weightsOffset) : nullptr;
+        m_animations.push_back(animation);
+    }
+
+    m_materialCount = header->materialCount;
+    m_vertexFormat = vertexFormat;
+    m_sourceHash = header->sourceHash;
+    return true;
+}
+
+bool CookedTexture::bind(const uint8_t* data, size_t size)
+{
+    auto header = readTextureHeader(data, size);
+    if (header == nullptr)
+    {
+        return false;
+    }
+    const uint64_t dataOffset = alignUp(sizeof(CookedTextureHeader));
+    bool valid = header->format <= uint32_t(TextureFormat::BC7Srgb) &&
+        header->role <= uint32_t(TextureRole::OcclusionRoughnessMetallic) &&
+        header->levelCount != 0 && header->levelCount <= MaxTextureLevels &&
+        dataOffset + header->dataSize <= size;
+    for (uint32_t level = 0; valid && level < header->levelCount; ++level)
+    {
+        valid = uint64_t(header->levels[level].offset) + header->levels[level].size <= header->dataSize;
+    }
+    if (!valid)
+    {
+        return false;
+    }
+
+    m_texture = CookedModel::Texture{};
+    m_texture.data = data + dataOffset;
+    m_texture.dataSize = header->dataSize;
+    m_texture.format = TextureFormat(header->format);
+    m_texture.role = TextureRole(header->role);
+    m_texture.levelCount = header->levelCount;
+    std::copy(header->levels, header->levels + MaxTextureLevels, m_texture.levels);
+    return true;
+}
+
+std::string ModelCache::getCachePath(const std::string& sourcePath, const std::string& cacheDirectory)
+{
+    if (cacheDirectory.empty())
+    {
+        return sourcePath + ".cooked";
+    }
+    //Sources with the same file name in different directories get their own file
+    const std::string canonical = canonicalizePath(sourcePath);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.cooked", (unsigned long long)hashBytes(canonical.data(), canonical.size()));
+    const auto fileName = std::filesystem::path(sourcePath).filename().generic_string() + suffix;
+    return (std::filesystem::path(cacheDirectory) / fileName).generic_string();
+}
+
+std::string ModelCache::getTextureCachePath(const std::string& modelCachePath, uint32_t imageIndex, TextureRole role)
+{
+    return modelCachePath + "." + std::to_string(imageIndex) + "-" + std::to_string(uint32_t(role)) + ".texture";
+}
+
+std::string ModelCache::canonicalizePath(const std::string& path)
+{
+    std::error_code ec;
+    auto canonical = std::filesystem::weakly_canonical(path, ec);
+    if (ec)
+    {
+        canonical = std::filesystem::absolute(path, ec).lexically_normal();
+    }
+    return canonical.generic_string();
+}
+
+std::shared_ptr<CookedModel> ModelCache::load(const std::string& sourcePath, const ImportSettings& settings, const std::string& cacheDirectory)
+{
+    auto cooked = std::make_shared<CookedModel>();
+    const auto cachePath = getCachePath(sourcePath, cacheDirectory);
+    if (!cacheDirectory.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDirectory, ec);
+    }
+
+    SourceStamp stamp;
+    stamp.settingsHash = hashSettings(settings);
+    bool hasSource = readSourceStamp(sourcePath, stamp);
+
+    //Fast path: cache is up to date when size and timestamp still match
+    const CookedHeader* cachedHeader = nullptr;
+    if (cooked->m_file.open(cachePath))
+    {
+        cachedHeader = readHeader(cooked->m_file.data(), cooked->m_file.size());
+        if (cachedHeader != nullptr && cachedHeader->settingsHash != stamp.settingsHash)
+        {
+            cachedHeader = nullptr;
+        }
+        if (cachedHeader != nullptr &&
+            (!hasSource || (cachedHeader->sourceSize == stamp.size && cachedHeader->sourceWriteTime == stamp.writeTime)))
+        {
+            if (cooked->bind(cooked->m_file.data(), cooked->m_file.size()))
+            {
+                return cooked;
+            }
+            cachedHeader = nullptr;
+        }
+    }
+
+    if (!hasSource)
+    {
+        throw std::runtime_error("Model not found: " + sourcePath);
+    }
+
+    //Timestamp changed: only re-import when the content hash differs
+    {
+        MappedFile source;
+        if (!source.open(sourcePath))
+        {
+            throw std::runtime_error("Failed to open model: " + sourcePath);
+        }
+        stamp.hash = hashBytes(source.data(), source.size());
+    }
+    if (cachedHeader != nullptr && cachedHeader->sourceHash == stamp.hash)
+    {
+        if (cooked->bind(cooked->m_file.data(), cooked->m_file.size()))
+        {
+            return cooked;
+        }
+    }
+    cooked->m_file.close();
+
+    auto blob = cook(ModelImporter::importFile(sourcePath, settings), stamp);
+    if (writeCache(cachePath, blob) && cooked->m_file.open(cachePath) &&
+        cooked->bind(cooked->m_file.data(), cooked->m_file.size()))
+    {
+        return cooked;
+    }
+
+    //Cache directory not writable, keep the blob in memory instead
+    cooked->m_file.close();
+    cooked->m_memory = std::move(blob);
+    if (!cooked->bind(cooked->m_memory.data(), cooked->m_memory.size()))
+    {
+        throw std::runtime_error("Failed to cook model: " + sourcePath);
+    }
+    return cooked;
+}
+
+std::shared_ptr<CookedTexture> ModelCache::loadTexture(const std::string& sourcePath, std::shared_ptr<const CookedModel> model,
+    size_t sourceIndex, const ImportSettings& settings, const std::string& cacheDirectory)
+{
+    const auto& source = model->getTextureSources().at(sourceIndex);
+    auto cooked = std::make_shared<CookedTexture>();
+    const auto cachePath = getTextureCachePath(getCachePath(sourcePath, cacheDirectory), source.imageIndex, source.role);
+    SourceStamp stamp;
+    stamp.hash = model->getSourceHash();
+    stamp.settingsHash = hashSettings(settings);
+
+    //Valid as long as it was cooked from the same source content and settings
+    if (cooked->m_file.open(cachePath))
+    {
+        auto header = readTextureHeader(cooked->m_file.data(), cooked->m_file.size());
+        if (header != nullptr && header->sourceHash == stamp.hash && header->settingsHash == stamp.settingsHash &&
+            header->imageIndex == source.imageIndex && header->role == uint32_t(source.role) &&
+            cooked->bind(cooked->m_file.data(), cooked->m_file.size()))
+        {
+            cooked->m_texture.materialIndices = source.materialIndices;
+            cooked->m_texture.materialCount = source.materialCount;
+            cooked->m_model = std::move(model);
+            return cooked;
+        }
+        cooked->m_file.close();
+    }
+
+    std::vector<uint8_t> blob;
+    {
+        GlbReader reader;
+        reader.open(sourcePath);
+        //A reload in progress must not mix images of the new file into the old model
+        if (hashBytes(reader.getFileData(), reader.getFileSize()) != stamp.hash)
+        {
+            throw std::runtime_error("Model changed since it was cooked: " + sourcePath);
+        }
+        blob = cookTexture(ModelImporter::importTexture(sourcePath, reader, source.imageIndex, source.role, settings), stamp);
+    }
+    if (!(writeCache(cachePath, blob) && cooked->m_file.open(cachePath) &&
+        cooked->bind(cooked->m_file.data(), cooked->m_file.size())))
+    {
+        //Cache directory not writable, keep the blob in memory instead
+        cooked->m_file.close();
+        cooked->m_memory = std::move(blob);
+        if (!cooked->bind(cooked->m_memory.data(), cooked->m_memory.size()))
+        {
+            throw std::runtime_error("Failed to cook texture: " + sourcePath);
+        }
+    }
+    cooked->m_texture.materialIndices = source.materialIndices;
+    cooked->m_texture.materialCount = source.materialCount;
+    cooked->m_model = std::move(model);
+    return cooked;
+}
+
+std::vector<uint8_t> ModelCache::cook(const ImportedModel& model, const SourceStamp& stamp)
+{
+    //Compute layout
+    std::vector<CookedPrimitive> records(model.primitives.size());
+    const bool quantized = model.vertexFormat == VertexFormat::Quantized;
+    const uint32_t vertexStride = getVertexStride(model.vertexFormat);
+    std::vector<CookedTextureSource> textureRecords(model.textures.size());
+    std::vector<CookedAnimation> animationRecords(model.animations.size());
+    const uint64_t textureTable = alignUp(sizeof(CookedHeader)) + records.size() * sizeof(CookedPrimitive);
+    const uint64_t animationTable = textureTable + textureRecords.size() * sizeof(CookedTextureSource);
+    uint64_t offset = alignUp(animationTable + animationRecords.size() * sizeof(CookedAnimation));
+
+    const auto& skeleton = model.skeleton;
+    const uint64_t jointCount = skeleton.parents.size();
+    const uint64_t parentsOffset = offset;
+    offset = alignUp(offset + jointCount * sizeof(int32_t));
+    const uint64_t inverseBindOffset = offset;
+    offset = alignUp(offset + jointCount * 16 * sizeof(float));
+    const uint64_t restPoseOffset = offset;
+    offset = alignUp(offset + jointCount * sizeof(JointPose));
+    const uint64_t morphWeightCount = model.morphWeights.size();
+    const uint64_t morphWeightsOffset = offset;
+    offset = alignUp(offset + morphWeightCount * sizeof(float));
+    for (size_t i = 0; i < model.primitives.size(); ++i)
+    {
+        const auto& primitive = model.primitives[i];
+        auto& record = records[i];
+        record.vertexCount = uint32_t(primitive.vertices.size());
+        record.indexCount = uint32_t(primitive.indices.size());
+        record.materialIndex = primitive.materialIndex;
+        record.bounds = primitive.bounds;
+        record.indexSize = selectIndexSize(primitive.vertices.size());
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            record.positionOffset[axis] = primitive.dequantization.offset[axis];
+            record.positionScale[axis] = primitive.dequantization.scale[axis];
+        }
+        //Primitives without a LOD chain draw their whole index stream
+        record.lodCount = std::min(uint32_t(primitive.lods.size()), MaxLodCount);
+        std::copy(primitive.lods.begin(), primitive.lods.begin() + record.lodCount, record.lods);
+        if (record.lodCount == 0)
+        {
+            record.lodCount = 1;
+            record.lods[0] = MeshLod{ 0, record.indexCount, 0.0f };
+        }
+        record.vertexOffset = offset;
+        offset = alignUp(offset + uint64_t(record.vertexCount) * vertexStride);
+        record.indexOffset = offset;
+        offset = alignUp(offset + uint64_t(record.indexCount) * record.indexSize);
+        record.clusterCount = uint32_t(primitive.clusters.size());
+        record.clusterOffset = offset;
+        offset = alignUp(offset + uint64_t(record.clusterCount) * sizeof(MeshCluster));
+        record.skinOffset = 0;
+        if (!primitive.skin.empty() && jointCount != 0)
+        {
+            record.skinOffset = offset;
+            offset = alignUp(offset + uint64_t(record.vertexCount) * sizeof(SkinInfluence));
+        }
+        record.morphTargetCount = primitive.morphTargetOffsets.empty() ? 0 : uint32_t(primitive.morphTargetOffsets.size() - 1);
+        record.morphWeightOffset = primitive.morphWeightOffset;
+        record.morphTargetOffset = 0;
+        record.morphDeltaOffset = 0;
+        if (record.morphTargetCount != 0)
+        {
+            record.morphTargetOffset = offset;
+            offset = alignUp(offset + primitive.morphTargetOffsets.size() * sizeof(uint32_t));
+            record.morphDeltaOffset = offset;
+            offset = alignUp(offset + primitive.morphDeltas.size() * sizeof(MorphDelta));
+        }
+    }
+    for (size_t i = 0; i < model.textures.size(); ++i)
+    {
+        const auto& texture = model.textures[i];
+        auto& record = textureRecords[i];
+        record.role = uint32_t(texture.role);
+        record.imageIndex = texture.imageIndex;
+        record.materialCount = uint32_t(texture.materialIndices.size());
+        record.materialOffset = offset;
+        offset = alignUp(offset + uint64_t(record.materialCount) * sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < model.animations.size(); ++i)
+    {
+        const auto& animation = model.animations[i];
+        auto& record = animationRecords[i];
+        record.duration = animation.duration;
+        record.frameRate = animation.frameRate;
+        record.frameCount = animation.frameCount;
+        const size_t nameLength = std::min(animation.name.size(), sizeof(record.name) - 1);
+        memcpy(record.name, animation.name.data(), nameLength);
+        record.keysOffset = offset;
+        offset = alignUp(offset + uint64_t(animation.keys.size()) * sizeof(JointPose));
+        record.weightsOffset = offset;
+        offset = alignUp(offset + uint64_t(animation.weights.size()) * sizeof(float));
+    }
+
+    std::vector<uint8_t> blob(size_t(offset), 0);
+
+    CookedHeader header{};
+    memcpy(header.magic, CookedMagic, sizeof(CookedMagic));
+    header.version = CookedVersion;
+    header.fileSize = offset;
+    header.sourceSize = stamp.size;
+    header.sourceWriteTime = stamp.writeTime;
+    header.sourceHash = stamp.hash;
+    header.settingsHash = stamp.settingsHash;
+    header.materialCount = model.materialCount;
+    header.primitiveCount = uint32_t(records.size());
+    header.vertexFormat = uint32_t(model.vertexFormat);
+    header.textureCount = uint32_t(textureRecords.size());
+    header.jointCount = uint32_t(jointCount);
+    header.animationCount = uint32_t(animationRecords.size());
+    header.parentsOffset = parentsOffset;
+    header.inverseBindOffset = inverseBindOffset;
+    header.restPoseOffset = restPoseOffset;
+    header.morphWeightCount = uint32_t(morphWeightCount);
+    header.morphWeightsOffset = morphWeightsOffset;
+    memcpy(blob.data(), &header, sizeof(header));
+    if (!records.empty())
+    {
+        memcpy(blob.data() + alignUp(sizeof(CookedHeader)), records.data(), records.size() * sizeof(CookedPrimitive));
+    }
+    if (!textureRecords.empty())
+    {
+        memcpy(blob.data() + textureTable, textureRecords.data(), textureRecords.size() * sizeof(CookedTextureSource));
+    }
+    if (!animationRecords.empty())
+    {
+        memcpy(blob.data() + animationTable, animationRecords.data(), animationRecords.size() * sizeof(CookedAnimation));
+    }
+    if (jointCount != 0)
+    {
+        memcpy(blob.data() + parentsOffset, skeleton.parents.data(), jointCount * sizeof(int32_t));
+        memcpy(blob.data() + inverseBindOffset, skeleton.inverseBindMatrices.data(), jointCount * 16 * sizeof(float));
+        memcpy(blob.data() + restPoseOffset, skeleton.restPose.data(), jointCount * sizeof(JointPose));
+    }
+    if (morphWeightCount != 0)
+    {
+        memcpy(blob.data() + morphWeightsOffset, model.morphWeights.data(), morphWeightCount * sizeof(float));
+    }
+    for (size_t i = 0; i < model.animations.size(); ++i)
+    {
+        const auto& keys = model.animations[i].keys;
+        if (!keys.empty())
+        {
+            memcpy(blob.data() + animationRecords[i].keysOffset, keys.data(), keys.size() * sizeof(JointPose));
+        }
+        const auto& weights = model.animations[i].weights;
+        if (!weights.empty())
+        {
+            memcpy(blob.data() + animationRecords[i].weightsOffset, weights.data(), weights.size() * sizeof(float));
+        }
+    }
+
+    //Materials of every texture source
+    for (size_t i = 0; i < model.textures.size(); ++i)
+    {
+        const auto& texture = model.textures[i];
+        const auto& record = textureRecords[i];
+        if (!texture.materialIndices.empty())
+        {
+            memcpy(blob.data() + record.materialOffset, texture.materialIndices.data(), texture.materialIndices.size() * sizeof(uint32_t));
+        }
+    }
+
+    //Vertex, index and cluster streams in upload-ready layout
+    for (size_t i = 0; i < model.primitives.size(); ++i)
+    {
+        const auto& primitive = model.primitives[i];
+        const auto& record = records[i];
+        if (quantized && !primitive.quantizedVertices.empty())
+        {
+            memcpy(blob.data() + record.vertexOffset, primitive.quantizedVertices.data(), primitive.quantizedVertices.size() * sizeof(QuantizedVertex));
+        }
+        else if (!quantized && !primitive.vertices.empty())
+        {
+            memcpy(blob.data() + record.vertexOffset, primitive.vertices.data(), primitive.vertices.size() * sizeof(ModelVertex));
+        }
+        if (!primitive.clusters.empty())
+        {
+            memcpy(blob.data() + record.clusterOffset, primitive.clusters.data(), primitive.clusters.size() * sizeof(MeshCluster));
+        }
+        if (record.skinOffset != 0)
+        {
+            memcpy(blob.data() + record.skinOffset, primitive.skin.data(), primitive.skin.size() * sizeof(SkinInfluence));
+        }
+        if (record.morphTargetCount != 0)
+        {
+            memcpy(blob.data() + record.morphTargetOffset, primitive.morphTargetOffsets.data(), primitive.morphTargetOffsets.size() * sizeof(uint32_t));
+            if (!primitive.morphDeltas.empty())
+            {
+                memcpy(blob.data() + record.morphDeltaOffset, primitive.morphDeltas.data(), primitive.morphDeltas.size() * sizeof(MorphDelta));
+            }
+        }
+        if (primitive.indices.empty())
+        {
+            continue;
+        }
+        if (record.indexSize == sizeof(uint16_t))
+        {
+            narrowIndices(primitive.indices.data(), primitive.indices.size(), reinterpret_cast<uint16_t*>(blob.data() + record.indexOffset));
+        }
+        else
+        {
+            memcpy(blob.data() + record.indexOffset, primitive.indices.data(), primitive.indices.size() * sizeof(uint32_t));
+        }
+    }
+
+    //Stream hashes over the final bytes, patched into the written records
+    auto cookedRecords = reinterpret_cast<CookedPrimitive*>(blob.data() + alignUp(sizeof(CookedHeader)));
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        auto& record = cookedRecords[i];
+        record.vertexHash = hashBytes(blob.data() + record.vertexOffset, size_t(record.vertexCount) * vertexStride);
+        record.indexHash = hashBytes(blob.data() + record.indexOffset, size_t(record.indexCount) * record.indexSize);
+    }
+
+    return blob;
+}
+
+std::vector<uint8_t> ModelCache::cookTexture(const ImportedTexture& texture, const SourceStamp& stamp)
+{
+    const uint64_t dataOffset = alignUp(sizeof(CookedTextureHeader));
+    CookedTextureHeader header{};
+    memcpy(header.magic, CookedTextureMagic, sizeof(CookedTextureMagic));
+    header.version = CookedVersion;
+    header.fileSize = dataOffset + texture.data.size();
+    header.sourceHash = stamp.hash;
+    header.settingsHash = stamp.settingsHash;
+    header.imageIndex = texture.imageIndex;
+    header.role = uint32_t(texture.role);
+    header.format = uint32_t(texture.format);
+    header.levelCount = std::min(uint32_t(texture.levels.size()), MaxTextureLevels);
+    std::copy(texture.levels.begin(), texture.levels.begin() + header.levelCount, header.levels);
+    header.dataSize = uint32_t(texture.data.size());
+
+    //Levels as uploaded, one subresource after another
+    std::vector<uint8_t> blob(size_t(header.fileSize), 0);
+    memcpy(blob.data(), &header, sizeof(header));
+    if (!texture.data.empty())
+    {
+        memcpy(blob.data() + dataOffset, texture.data.data(), texture.data.size());
+    }
+    return blob;
+}
+
+uint64_t ModelCache::hashSettings(const ImportSettings& settings)
+{
+    //Hash fields one by one, the struct itself has padding
+    float values[] = {
+        settings.optimizeVertexCache ? 1.0f : 0.0f,
+        settings.optimizeOverdraw ? 1.0f : 0.0f,
+        settings.overdrawThreshold,
+        settings.quantizeVertices ? 1.0f : 0.0f,
+        float(settings.lodCount),
+        settings.lodReduction,
+        settings.lodMaxError,
+        settings.generateMips ? 1.0f : 0.0f,
+        float(settings.mipFilter),
+        settings.compressTextures ? 1.0f : 0.0f,
+        settings.generateTangents ? 1.0f : 0.0f,
+        settings.animationFrameRate,
+    };
+    return hashBytes(values, sizeof(values));
+}
+
+bool ModelCache::writeCache(const std::string& cachePath, const std::vector<uint8_t>& blob)
+{
+    //Write to a temporary file first so a crash never leaves a torn cache behind
+    const auto tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(blob.data()), std::streamsize(blob.size()));
+        if (!out)
+        {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
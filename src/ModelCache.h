@@ -0,0 +1,184 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelData.h"
+#include "MappedFile.h"
+
+//Read-only view over a cooked model blob (memory mapped cache file or in-memory blob)
+class CookedModel
+{
+public:
+    struct Primitive
+    {
+        //ModelVertex or QuantizedVertex stream depending on the model vertex format
+        const void* vertices;
+        uint32_t vertexCount;
+        uint32_t vertexStride;
+        //uint16_t or uint32_t stream depending on indexSize
+        const void* indices;
+        uint32_t indexCount;
+        uint32_t indexSize;
+        int materialIndex;
+        PositionDequantization dequantization;
+        //Detail levels as ranges of the index stream, finest first
+        uint32_t lodCount;
+        MeshLod lods[MaxLodCount];
+        //Culling clusters, ranges referenced by lods
+        const MeshCluster* clusters;
+        uint32_t clusterCount;
+        //One per vertex for skinned primitives, nullptr for static ones
+        const SkinInfluence* skin;
+        //Sparse morph targets, deltas of target t are morphDeltas[morphTargetOffsets[t],
+        //morphTargetOffsets[t + 1]) sorted by vertex; null without targets
+        const MorphDelta* morphDeltas;
+        const uint32_t* morphTargetOffsets;
+        uint32_t morphTargetCount;
+        //Model morph weight of the first target
+        uint32_t morphWeightOffset;
+        //Model space box and sphere of the full detail mesh
+        BoundingVolume bounds;
+        //Content hashes of the cooked vertex and index streams, for sharing identical buffers
+        uint64_t vertexHash;
+        uint64_t indexHash;
+
+        //Byte sizes of the upload buffers for the two streams
+        uint32_t getVertexBufferSize() const { return vertexStride * vertexCount; }
+        uint32_t getIndexBufferSize() const { return indexSize * indexCount; }
+    };
+
+    //Image a material samples, cooked into its own CookedTexture
+    struct TextureSource
+    {
+        //glTF image index
+        uint32_t imageIndex;
+        TextureRole role;
+        //Materials using the image in role
+        const uint32_t* materialIndices;
+        uint32_t materialCount;
+    };
+
+    //Cooked levels of a texture source
+    struct Texture
+    {
+        //Every level back to back, described by levels
+        const uint8_t* data;
+        uint32_t dataSize;
+        TextureFormat format;
+        TextureRole role;
+        uint32_t levelCount;
+        TextureLevel levels[MaxTextureLevels];
+        //Materials using the texture in role
+        const uint32_t* materialIndices;
+        uint32_t materialCount;
+    };
+
+    struct Skeleton
+    {
+        //0 for models without a skin
+        uint32_t jointCount = 0;
+        //Parents come before their children, -1 for roots
+        const int32_t* parents = nullptr;
+        //Column-major, 16 floats per joint
+        const float* inverseBindMatrices = nullptr;
+        const JointPose* restPose = nullptr;
+    };
+
+    struct Animation
+    {
+        const char* name;
+        float duration;
+        float frameRate;
+        uint32_t frameCount;
+        //frameCount blocks of one pose per skeleton joint
+        const JointPose* keys;
+        //frameCount blocks of getMorphWeightCount() weights, null without morph targets
+        const float* weights;
+    };
+
+    const std::vector<Primitive>& getPrimitives() const { return m_primitives; }
+    const std::vector<TextureSource>& getTextureSources() const { return m_textureSources; }
+    const Skeleton& getSkeleton() const { return m_skeleton; }
+    const std::vector<Animation>& getAnimations() const { return m_animations; }
+    //Default morph target weights of the whole model, primitives index them by morphWeightOffset
+    const float* getMorphWeights() const { return m_morphWeights; }
+    uint32_t getMorphWeightCount() const { return m_morphWeightCount; }
+    uint32_t getMaterialCount() const { return m_materialCount; }
+    VertexFormat getVertexFormat() const { return m_vertexFormat; }
+    uint64_t getSourceHash() const { return m_sourceHash; }
+
+private:
+    friend class ModelCache;
+
+    //Validate blob and resolve offsets into pointers
+    bool bind(const uint8_t* data, size_t size);
+
+    MappedFile m_file;
+    std::vector<uint8_t> m_memory;
+    std::vector<Primitive> m_primitives;
+    std::vector<TextureSource> m_textureSources;
+    Skeleton m_skeleton;
+    std::vector<Animation> m_animations;
+    const float* m_morphWeights = nullptr;
+    uint32_t m_morphWeightCount = 0;
+    uint32_t m_materialCount = 0;
+    VertexFormat m_vertexFormat = VertexFormat::Float;
+    uint64_t m_sourceHash = 0;
+};
+
+//Read-only view over one cooked texture blob. Textures are cooked apart from
+//their model, so the geometry never waits for image decoding and compression.
+class CookedTexture
+{
+public:
+    //Material list points into the model the texture was loaded for
+    const CookedModel::Texture& getTexture() const { return m_texture; }
+
+private:
+    friend class ModelCache;
+
+    //Validate blob and resolve the level data
+    bool bind(const uint8_t* data, size_t size);
+
+    MappedFile m_file;
+    std::vector<uint8_t> m_memory;
+    //Owner of the material list
+    std::shared_ptr<const CookedModel> m_model;
+    CookedModel::Texture m_texture{};
+};
+
+//Cooks glTF models into versioned binary blobs stored next to the source file,
+//or in a cache directory, and maps them back on later launches. The glTF path is only taken when the
+//source content hash no longer matches the cache.
+class ModelCache
+{
+public:
+    struct SourceStamp
+    {
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+        uint64_t hash = 0;
+        uint64_t settingsHash = 0;
+    };
+
+    //cacheDirectory empty keeps the cooked file next to the source
+    static std::shared_ptr<CookedModel> load(const std::string& sourcePath, const ImportSettings& settings = ImportSettings(),
+        const std::string& cacheDirectory = std::string());
+    static std::vector<uint8_t> cook(const ImportedModel& model, const SourceStamp& stamp);
+    static std::string getCachePath(const std::string& sourcePath, const std::string& cacheDirectory = std::string());
+
+    //Levels of texture source sourceIndex of model, cooked into a cache file next
+    //to the model's on first use. Throws std::runtime_error when the image is
+    //broken or the source changed since model was cooked.
+    static std::shared_ptr<CookedTexture> loadTexture(const std::string& sourcePath, std::shared_ptr<const CookedModel> model,
+        size_t sourceIndex, const ImportSettings& settings = ImportSettings(), const std::string& cacheDirectory = std::string());
+    //stamp.hash is the content hash of the model source
+    static std::vector<uint8_t> cookTexture(const ImportedTexture& texture, const SourceStamp& stamp);
+    static std::string getTextureCachePath(const std::string& modelCachePath, uint32_t imageIndex, TextureRole role);
+    //Absolute, normalized form so different spellings of one file compare equal
+    static std::string canonicalizePath(const std::string& path);
+
+private:
+    static uint64_t hashSettings(const ImportSettings& settings);
+    static bool writeCache(const std::string& cachePath, const std::vector<uint8_t>& blob);
+};
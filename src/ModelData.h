@@ -0,0 +1,254 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Vertex layout uploaded to the GPU; Pos must stay first, bounds load it as four floats
+struct ModelVertex
+{
+    float Pos[3];
+    float Normal[3];
+    //xyz along increasing u, w the bitangent sign
+    float Tangent[4];
+    float UV[2];
+};
+
+//Compressed vertex layout: positions as 16-bit unorm relative to the primitive
+//AABB, normal and tangent octahedral encoded to 2x16-bit snorm and UVs as
+//half floats so tiling coordinates survive (20 bytes instead of 48)
+struct QuantizedVertex
+{
+    //w holds the bitangent sign, 0 for -1 and 65535 for +1
+    uint16_t Pos[4];
+    int16_t Normal[2];
+    int16_t Tangent[2];
+    uint16_t UV[2];
+};
+
+enum class VertexFormat : uint32_t
+{
+    Float = 0,
+    Quantized = 1,
+};
+
+//Maps unorm positions back to model space: pos = offset + unorm * scale
+struct PositionDequantization
+{
+    float offset[3] = { 0.0f, 0.0f, 0.0f };
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+//Axis aligned box and enclosing sphere in model space
+struct BoundingVolume
+{
+    float min[3] = { 0.0f, 0.0f, 0.0f };
+    float max[3] = { 0.0f, 0.0f, 0.0f };
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+};
+
+//Joint influences of one skinned vertex, kept beside the vertex stream so
+//static primitives do not pay for them. Weights sum to one.
+struct SkinInfluence
+{
+    uint16_t joints[4];
+    float weights[4];
+};
+
+//Offset of one vertex under a morph target at full weight. The vectors line
+//up with the first nine floats of ModelVertex, so blending is one multiply-add.
+struct MorphDelta
+{
+    float position[3];
+    float normal[3];
+    float tangent[3];
+    uint32_t vertex;
+};
+
+//Local joint transform; every vector is padded to 16 bytes for SIMD loads
+struct JointPose
+{
+    float translation[4];
+    //Unit quaternion x, y, z, w
+    float rotation[4];
+    float scale[4];
+};
+
+//Joints of the model's skin ordered parents first, so one forward pass
+//resolves the hierarchy
+struct ImportedSkeleton
+{
+    //-1 for root joints
+    std::vector<int32_t> parents;
+    //Column-major, 16 floats per joint
+    std::vector<float> inverseBindMatrices;
+    std::vector<JointPose> restPose;
+};
+
+//Animation resampled at a fixed frame rate. Keys are frame major with every
+//joint of a frame adjacent, so sampling reads two contiguous blocks.
+struct ImportedAnimation
+{
+    std::string name;
+    float duration = 0.0f;
+    float frameRate = 0.0f;
+    uint32_t frameCount = 0;
+    std::vector<JointPose> keys;
+    //Every morph weight of the model per frame, frame major like keys
+    std::vector<float> weights;
+};
+
+//Largest number of detail levels per primitive, including the full mesh
+constexpr uint32_t MaxLodCount = 4;
+
+//Range of the primitive index buffer drawn at one detail level
+struct MeshLod
+{
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    //Maximum surface deviation from the full mesh in model units
+    float error = 0.0f;
+    //Range of the primitive cluster list covering this level
+    uint32_t clusterOffset = 0;
+    uint32_t clusterCount = 0;
+};
+
+//Cluster size limits, matching common mesh shader meshlet sizes
+constexpr uint32_t MaxClusterVertices = 64;
+constexpr uint32_t MaxClusterTriangles = 124;
+
+//Small run of triangles with bounds, culled as a unit
+struct MeshCluster
+{
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    //Bounding sphere in model space
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+    //Normal cone: every triangle faces away from cameras inside the cone
+    //around coneAxis. coneCutoff is the sine of the spread, 1 disables the test
+    float coneAxis[3] = { 0.0f, 0.0f, 0.0f };
+    float coneCutoff = 1.0f;
+};
+
+//Texel layout of a cooked texture
+enum class TextureFormat : uint32_t
+{
+    RGBA8 = 0,
+    RGBA8Srgb = 1,
+    //4x4 texel blocks
+    BC1 = 2,
+    BC1Srgb = 3,
+    BC3 = 4,
+    BC3Srgb = 5,
+    BC5 = 6,
+    BC7 = 7,
+    BC7Srgb = 8,
+};
+
+//What a material samples a texture for, decides color space and block format
+enum class TextureRole : uint32_t
+{
+    BaseColor = 0,
+    Normal = 1,
+    //glTF occlusion (R), roughness (G) and metallic (B), usually one packed image
+    OcclusionRoughnessMetallic = 2,
+};
+
+//Downsampling filter of the mip chain generator
+enum class MipFilter : uint32_t
+{
+    Box = 0,
+    //Kaiser windowed sinc, sharper than box without visible ringing
+    Kaiser = 1,
+};
+
+//Enough levels for a 32768x32768 texture
+constexpr uint32_t MaxTextureLevels = 16;
+
+//One mip level inside the texture data, rows (of blocks for BC formats) tightly packed
+struct TextureLevel
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    uint32_t rowPitch = 0;
+};
+
+//Material texture with its full mip chain. Model imports only list the image,
+//role and materials; the levels are built by ModelImporter::importTexture.
+struct ImportedTexture
+{
+    //glTF image the levels are decoded from
+    uint32_t imageIndex = 0;
+    //Materials using the image in role
+    std::vector<uint32_t> materialIndices;
+    TextureRole role = TextureRole::BaseColor;
+    TextureFormat format = TextureFormat::RGBA8Srgb;
+    std::vector<TextureLevel> levels;
+    std::vector<uint8_t> data;
+};
+
+//CPU side geometry of one glTF primitive, produced by the importer
+struct ImportedPrimitive
+{
+    std::vector<ModelVertex> vertices;
+    //All detail levels back to back, described by lods
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    //Clusters of all detail levels, each level refers to its own range
+    std::vector<MeshCluster> clusters;
+    int materialIndex = -1;
+    BoundingVolume bounds;
+    //Source had a TANGENT attribute; otherwise tangents are generated after import
+    bool hasTangents = false;
+    //One per vertex for skinned primitives, empty for static ones
+    std::vector<SkinInfluence> skin;
+    //Sparse morph targets: target t owns morphDeltas[morphTargetOffsets[t],
+    //morphTargetOffsets[t + 1]), sorted by vertex. Empty without targets
+    std::vector<MorphDelta> morphDeltas;
+    std::vector<uint32_t> morphTargetOffsets;
+    //First model morph weight driving these targets, shared by the mesh's primitives
+    uint32_t morphWeightOffset = 0;
+    //Filled when ImportSettings::quantizeVertices is set
+    std::vector<QuantizedVertex> quantizedVertices;
+    PositionDequantization dequantization;
+};
+
+//Import pipeline options, part of the cooked cache key
+struct ImportSettings
+{
+    bool optimizeVertexCache = true;
+    bool optimizeOverdraw = true;
+    //Maximum ACMR increase accepted by the overdraw pass
+    float overdrawThreshold = 1.05f;
+    //Cook QuantizedVertex streams instead of ModelVertex
+    bool quantizeVertices = false;
+    //Detail levels to generate, each aiming for lodReduction of the previous
+    //triangle count while staying within lodMaxError of the primitive extent
+    uint32_t lodCount = MaxLodCount;
+    float lodReduction = 0.5f;
+    float lodMaxError = 0.02f;
+    //Cook full mip chains for material textures
+    bool generateMips = true;
+    MipFilter mipFilter = MipFilter::Kaiser;
+    //Encode textures to the BC format of their role
+    bool compressTextures = true;
+    //Build tangents for primitives without a TANGENT attribute
+    bool generateTangents = true;
+    //Sample rate animations are baked at
+    float animationFrameRate = 30.0f;
+};
+
+struct ImportedModel
+{
+    std::vector<ImportedPrimitive> primitives;
+    std::vector<ImportedTexture> textures;
+    uint32_t materialCount = 0;
+    VertexFormat vertexFormat = VertexFormat::Float;
+    ImportedSkeleton skeleton;
+    std::vector<ImportedAnimation> animations;
+    //Default weights of every mesh's morph targets back to back
+    std::vector<float> morphWeights;
+};
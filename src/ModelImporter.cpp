@@ -0,0 +1,1291 @@
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "ModelImporter.h"
+#include "MeshBounds.h"
+#include "MeshClusters.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MipGenerator.h"
+#include "MorphTargets.h"
+#include "TangentGenerator.h"
+#include "TextureCompressor.h"
+#include "ThreadPool.h"
+#include "VertexQuantizer.h"
+#include "Log.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include "ThirdPartyHeaders/stb_image.h"
+
+namespace
+{
+    //glTF primitive topology TRIANGLES
+    constexpr uint64_t ModeTriangles = 4;
+
+    int getComponentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    //Fixed-size number array property, false when missing or malformed
+    bool readNumbers(const nlohmann::json& object, const char* key, float* values, size_t count)
+    {
+        auto found = object.find(key);
+        if (found == object.end() || !found->is_array() || found->size() != count)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!(*found)[i].is_number())
+            {
+                return false;
+            }
+            values[i] = (*found)[i].get<float>();
+        }
+        return true;
+    }
+
+    void normalizeQuaternion(float q[4])
+    {
+        const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        if (length > 0.0f)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                q[i] /= length;
+            }
+        }
+        else
+        {
+            q[0] = q[1] = q[2] = 0.0f;
+            q[3] = 1.0f;
+        }
+    }
+
+    void slerp(const float a[4], const float b[4], float t, float result[4])
+    {
+        float d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        //Take the short way around
+        const float sign = d < 0.0f ? -1.0f : 1.0f;
+        d *= sign;
+        float wa = 1.0f - t;
+        float wb = t * sign;
+        //Nearly parallel: lerp is exact enough and avoids dividing by sin(0)
+        if (d < 0.9995f)
+        {
+            const float angle = std::acos(d);
+            const float s = std::sin(angle);
+            wa = std::sin(wa * angle) / s;
+            wb = std::sin(t * angle) / s * sign;
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            result[i] = a[i] * wa + b[i] * wb;
+        }
+        normalizeQuaternion(result);
+    }
+
+    //Rotation of an orthonormal column-major 3x3 (columns 0, 4, 8 of m) as a quaternion
+    void matrixToQuaternion(const float c0[3], const float c1[3], const float c2[3], float q[4])
+    {
+        const float trace = c0[0] + c1[1] + c2[2];
+        if (trace > 0.0f)
+        {
+            const float s = std::sqrt(trace + 1.0f) * 2.0f;
+            q[3] = 0.25f * s;
+            q[0] = (c1[2] - c2[1]) / s;
+            q[1] = (c2[0] - c0[2]) / s;
+            q[2] = (c0[1] - c1[0]) / s;
+        }
+        else if (c0[0] > c1[1] && c0[0] > c2[2])
+        {
+            const float s = std::sqrt(1.0f + c0[0] - c1[1] - c2[2]) * 2.0f;
+            q[3] = (c1[2] - c2[1]) / s;
+            q[0] = 0.25f * s;
+            q[1] = (c1[0] + c0[1]) / s;
+            q[2] = (c2[0] + c0[2]) / s;
+        }
+        else if (c1[1] > c2[2])
+        {
+            const float s = std::sqrt(1.0f + c1[1] - c0[0] - c2[2]) * 2.0f;
+            q[3] = (c2[0] - c0[2]) / s;
+            q[0] = (c1[0] + c0[1]) / s;
+            q[1] = 0.25f * s;
+            q[2] = (c2[1] + c1[2]) / s;
+        }
+        else
+        {
+            const float s = std::sqrt(1.0f + c2[2] - c0[0] - c1[1]) * 2.0f;
+            q[3] = (c0[1] - c1[0]) / s;
+            q[0] = (c2[0] + c0[2]) / s;
+            q[1] = (c2[1] + c1[2]) / s;
+            q[2] = 0.25f * s;
+        }
+        normalizeQuaternion(q);
+    }
+
+    //Local transform of a glTF node; matrix nodes are decomposed, shear is lost
+    //TRS of a column-major affine matrix; shear, e.g. from a rotated child of a
+    //non-uniformly scaled parent, has no TRS form and is dropped
+    JointPose matrixToPose(const float m[16])
+    {
+        JointPose pose = { { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } };
+        float columns[3][3];
+        for (int c = 0; c < 3; ++c)
+        {
+            const float length = std::sqrt(m[c * 4] * m[c * 4] + m[c * 4 + 1] * m[c * 4 + 1] + m[c * 4 + 2] * m[c * 4 + 2]);
+            pose.scale[c] = length;
+            for (int r = 0; r < 3; ++r)
+            {
+                columns[c][r] = length > 0.0f ? m[c * 4 + r] / length : (r == c ? 1.0f : 0.0f);
+            }
+            pose.translation[c] = m[12 + c];
+        }
+        //Mirroring shows up as a negative determinant, fold it into one scale axis
+        const float det = columns[0][0] * (columns[1][1] * columns[2][2] - columns[2][1] * columns[1][2]) -
+            columns[1][0] * (columns[0][1] * columns[2][2] - columns[2][1] * columns[0][2]) +
+            columns[2][0] * (columns[0][1] * columns[1][2] - columns[1][1] * columns[0][2]);
+        if (det < 0.0f)
+        {
+            pose.scale[0] = -pose.scale[0];
+            for (int r = 0; r < 3; ++r)
+            {
+                columns[0][r] = -columns[0][r];
+            }
+        }
+        matrixToQuaternion(columns[0], columns[1], columns[2], pose.rotation);
+        return pose;
+    }
+
+    //Column-major T * R * S
+    void poseToMatrix(const JointPose& pose, float m[16])
+    {
+        const float x = pose.rotation[0], y = pose.rotation[1], z = pose.rotation[2], w = pose.rotation[3];
+        const float rotation[3][3] = {
+            { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w) },
+            { 2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w) },
+            { 2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y) } };
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                m[c * 4 + r] = rotation[c][r] * pose.scale[c];
+            }
+            m[c * 4 + 3] = 0.0f;
+            m[12 + c] = pose.translation[c];
+        }
+        m[15] = 1.0f;
+    }
+
+    //result = a * b, column-major; result may alias b
+    void multiplyMatrices(const float a[16], const float b[16], float result[16])
+    {
+        float product[16];
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                product[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] + a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+            }
+        }
+        std::copy(product, product + 16, result);
+    }
+
+    //Joint pose with the non-joint nodes above it folded in
+    JointPose applyOffset(const float offset[16], const JointPose& pose)
+    {
+        float m[16];
+        poseToMatrix(pose, m);
+        multiplyMatrices(offset, m, m);
+        return matrixToPose(m);
+    }
+
+    JointPose readNodePose(const nlohmann::json& node)
+    {
+        JointPose pose = { { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } };
+        float m[16];
+        if (readNumbers(node, "matrix", m, 16))
+        {
+            return matrixToPose(m);
+        }
+        readNumbers(node, "translation", pose.translation, 3);
+        if (readNumbers(node, "rotation", pose.rotation, 4))
+        {
+            normalizeQuaternion(pose.rotation);
+        }
+        readNumbers(node, "scale", pose.scale, 3);
+        return pose;
+    }
+
+    //One animation channel decoded from its sampler
+    struct AnimationTrack
+    {
+        enum Path { Translation, Rotation, Scale, Weights };
+        enum Interpolation { Linear, Step, CubicSpline };
+        //Joint, or first model morph weight for weight tracks
+        uint32_t target;
+        Path path;
+        Interpolation interpolation;
+        int components;
+        std::vector<float> times;
+        //components per key, three times that for cubic splines (in tangent, value, out tangent)
+        std::vector<float> values;
+    };
+
+    //Track value at time; cursor is the key the previous call ended at, times only grow
+    void evaluateTrack(const AnimationTrack& track, float time, size_t& cursor, float* result)
+    {
+        const size_t keyCount = track.times.size();
+        const int n = track.components;
+        const size_t keyStride = track.interpolation == AnimationTrack::CubicSpline ? size_t(n) * 3 : size_t(n);
+        const size_t valueOffset = track.interpolation == AnimationTrack::CubicSpline ? size_t(n) : 0;
+        auto value = [&](size_t key) { return &track.values[key * keyStride + valueOffset]; };
+
+        while (cursor + 1 < keyCount && track.times[cursor + 1] <= time)
+        {
+            ++cursor;
+        }
+        if (cursor + 1 >= keyCount || time <= track.times[cursor])
+        {
+            //Before the first or after the last key the track holds its end values
+            const float* v = value(time <= track.times[0] ? 0 : cursor);
+            std::copy(v, v + n, result);
+            return;
+        }
+
+        const float span = track.times[cursor + 1] - track.times[cursor];
+        const float t = span > 0.0f ? (time - track.times[cursor]) / span : 0.0f;
+        const float* a = value(cursor);
+        const float* b = value(cursor + 1);
+        switch (track.interpolation)
+        {
+        case AnimationTrack::Step:
+            std::copy(a, a + n, result);
+            break;
+        case AnimationTrack::Linear:
+            if (track.path == AnimationTrack::Rotation)
+            {
+                slerp(a, b, t, result);
+                return;
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                result[i] = a[i] + (b[i] - a[i]) * t;
+            }
+            break;
+        case AnimationTrack::CubicSpline:
+        {
+            //Hermite basis with the tangents scaled by the key spacing
+            const float* outTangent = a + n;
+            const float* inTangent = b - n;
+            const float t2 = t * t;
+            const float t3 = t2 * t;
+            const float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+            const float h10 = t3 - 2.0f * t2 + t;
+            const float h01 = -2.0f * t3 + 3.0f * t2;
+            const float h11 = t3 - t2;
+            for (int i = 0; i < n; ++i)
+            {
+                result[i] = h00 * a[i] + h10 * span * outTangent[i] + h01 * b[i] + h11 * span * inTangent[i];
+            }
+            break;
+        }
+        }
+        if (track.path == AnimationTrack::Rotation)
+        {
+            normalizeQuaternion(result);
+        }
+    }
+}
+
+ImportedModel ModelImporter::importFile(const std::string& path, const ImportSettings& settings)
+{
+    //Accessors are decoded straight out of the mapped BIN chunk, no intermediate buffer copies
+    GlbReader reader;
+    reader.open(path);
+
+    ImportedModel imported;
+    auto materials = reader.getDocument().find("materials");
+    imported.materialCount = materials != reader.getDocument().end() && materials->is_array() ? uint32_t(materials->size()) : 0;
+    const auto meshWeights = importGeometry(reader, imported);
+    const auto jointNodes = importSkeleton(path, reader, imported);
+    importAnimations(path, reader, jointNodes, meshWeights, imported, settings);
+    if (settings.generateTangents)
+    {
+        generateTangents(path, imported);
+    }
+    optimizeGeometry(path, imported, settings);
+    //Skinned and morphed vertices are deformed on the CPU every frame from the float stream
+    if (settings.quantizeVertices && imported.skeleton.parents.empty() && imported.morphWeights.empty())
+    {
+        quantizeGeometry(path, imported);
+    }
+    collectTextures(path, reader, imported);
+    return imported;
+}
+
+void ModelImporter::collectTextures(const std::string& path, const GlbReader& reader, ImportedModel& imported)
+{
+    const auto& document = reader.getDocument();
+    auto materials = document.find("materials");
+    if (materials == document.end() || !materials->is_array())
+    {
+        return;
+    }
+
+    //(image, role) to the materials using it, each pair is decoded and encoded once
+    std::map<std::pair<int64_t, TextureRole>, std::vector<uint32_t>> images;
+    auto addTexture = [&](const nlohmann::json& owner, const char* key, TextureRole role, uint32_t materialIndex) {
+        auto info = owner.find(key);
+        if (info == owner.end())
+        {
+            return;
+        }
+        const auto textureIndex = GlbReader::getIndex(*info, "index");
+        const auto source = GlbReader::getIndex(reader.getElement("textures", textureIndex), "source");
+        if (source >= 0)
+        {
+            auto& users = images[{ source, role }];
+            //Occlusion and metallic-roughness usually share one packed image
+            if (std::find(users.begin(), users.end(), materialIndex) == users.end())
+            {
+                users.push_back(materialIndex);
+            }
+        }
+    };
+    for (size_t i = 0; i < materials->size(); ++i)
+    {
+        const auto& material = (*materials)[i];
+        auto pbr = material.find("pbrMetallicRoughness");
+        if (pbr != material.end())
+        {
+            addTexture(*pbr, "baseColorTexture", TextureRole::BaseColor, uint32_t(i));
+            addTexture(*pbr, "metallicRoughnessTexture", TextureRole::OcclusionRoughnessMetallic, uint32_t(i));
+        }
+        addTexture(material, "normalTexture", TextureRole::Normal, uint32_t(i));
+        addTexture(material, "occlusionTexture", TextureRole::OcclusionRoughnessMetallic, uint32_t(i));
+    }
+
+    for (const auto& image : images)
+    {
+        const auto imageIndex = image.first.first;
+        try
+        {
+            if (GlbReader::getIndex(reader.getElement("images", imageIndex), "bufferView") < 0)
+            {
+                throw std::runtime_error("External image URIs are not supported");
+            }
+            ImportedTexture texture;
+            texture.imageIndex = uint32_t(imageIndex);
+            texture.role = image.first.second;
+            texture.materialIndices = image.second;
+            imported.textures.push_back(std::move(texture));
+        }
+        catch (const std::exception& e)
+        {
+            logMessage(path + ": image " + std::to_string(imageIndex) + ": " + e.what());
+        }
+    }
+}
+
+ImportedTexture ModelImporter::importTexture(const std::string& path, const GlbReader& reader, uint32_t imageIndex, TextureRole role,
+    const ImportSettings& settings)
+{
+    const auto bufferView = GlbReader::getIndex(reader.getElement("images", imageIndex), "bufferView");
+    if (bufferView < 0)
+    {
+        throw std::runtime_error("External image URIs are not supported");
+    }
+    const auto span = reader.getBufferView(bufferView);
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const auto pixels = decodeImage(span.data, span.size, width, height);
+
+    //Only base color is authored in sRGB, the other roles hold data
+    const bool srgb = role == TextureRole::BaseColor;
+    ImportedTexture texture;
+    texture.imageIndex = imageIndex;
+    texture.role = role;
+    texture.format = srgb ? TextureFormat::RGBA8Srgb : TextureFormat::RGBA8;
+    if (settings.generateMips)
+    {
+        MipGenerator::generate(pixels.data(), width, height, srgb, settings.mipFilter, texture.levels, texture.data);
+    }
+    else
+    {
+        texture.levels.push_back({ width, height, 0, uint32_t(pixels.size()), width * 4 });
+        texture.data = pixels;
+    }
+
+    if (settings.compressTextures && TextureCompressor::canCompress(width, height))
+    {
+        bool hasAlpha = false;
+        for (size_t i = 3; i < pixels.size() && !hasAlpha; i += 4)
+        {
+            hasAlpha = pixels[i] != 0xff;
+        }
+        const auto format = TextureCompressor::selectFormat(role, hasAlpha);
+        const auto uncompressedSize = texture.data.size();
+        TextureCompressor::compress(texture, format);
+
+        char line[256];
+        snprintf(line, sizeof(line), "%s image %u: %ux%u, %u levels, format %u, %zu -> %zu bytes",
+            path.c_str(), imageIndex, width, height, uint32_t(texture.levels.size()),
+            uint32_t(format), uncompressedSize, texture.data.size());
+        logMessage(line);
+    }
+    else if (settings.compressTextures)
+    {
+        logMessage(path + ": image " + std::to_string(imageIndex) + ": size not a multiple of 4, kept uncompressed");
+    }
+    return texture;
+}
+
+std::vector<uint8_t> ModelImporter::decodeImage(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height)
+{
+    if (size > size_t(INT32_MAX))
+    {
+        throw std::runtime_error("Image too large");
+    }
+    int imageWidth = 0;
+    int imageHeight = 0;
+    int channels = 0;
+    stbi_uc* pixels = stbi_load_from_memory(data, int(size), &imageWidth, &imageHeight, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        throw std::runtime_error(std::string("Image decode failed: ") + stbi_failure_reason());
+    }
+    //Every level must stay addressable by the 32-bit offsets of the cooked texture
+    if (uint64_t(imageWidth) * uint64_t(imageHeight) * 4 * 2 > uint64_t(UINT32_MAX))
+    {
+        stbi_image_free(pixels);
+        throw std::runtime_error("Image too large");
+    }
+    width = uint32_t(imageWidth);
+    height = uint32_t(imageHeight);
+    std::vector<uint8_t> decoded(pixels, pixels + size_t(width) * height * 4);
+    stbi_image_free(pixels);
+    return decoded;
+}
+
+void ModelImporter::generateLods(const std::string& path, size_t primitiveIndex, ImportedPrimitive& primitive, const ImportSettings& settings)
+{
+    const auto& vertices = primitive.vertices;
+    float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (const auto& vertex : vertices)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = std::min(minimum[axis], vertex.Pos[axis]);
+            maximum[axis] = std::max(maximum[axis], vertex.Pos[axis]);
+        }
+    }
+    float extent = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        extent = std::max(extent, maximum[axis] - minimum[axis]);
+    }
+    const float maxError = extent * settings.lodMaxError;
+
+    std::vector<uint32_t> source(primitive.indices);
+    const uint32_t lodCount = std::min(settings.lodCount, MaxLodCount);
+    while (primitive.lods.size() < lodCount)
+    {
+        size_t target = size_t(float(source.size() / 3) * settings.lodReduction) * 3;
+        float error = 0.0f;
+        auto simplified = MeshSimplifier::simplify(source, vertices, target, maxError, error);
+        //Levels that barely shrink cost memory without saving vertex work
+        if (simplified.empty() || simplified.size() > source.size() * 9 / 10)
+        {
+            break;
+        }
+        if (settings.optimizeVertexCache)
+        {
+            MeshOptimizer::optimizeVertexCache(simplified, vertices.size());
+        }
+
+        //Errors accumulate along the chain since each level simplifies the previous one
+        MeshLod lod;
+        lod.indexOffset = uint32_t(primitive.indices.size());
+        lod.indexCount = uint32_t(simplified.size());
+        lod.error = primitive.lods.back().error + error;
+        primitive.lods.push_back(lod);
+        primitive.indices.insert(primitive.indices.end(), simplified.begin(), simplified.end());
+
+        char line[256];
+        snprintf(line, sizeof(line), "%s primitive %zu: LOD %zu %zu triangles, error %g",
+            path.c_str(), primitiveIndex, primitive.lods.size() - 1, simplified.size() / 3, lod.error);
+        logMessage(line);
+        source = std::move(simplified);
+    }
+}
+
+std::vector<ModelImporter::JointNode> ModelImporter::importSkeleton(const std::string& path, const GlbReader& reader, ImportedModel& imported)
+{
+    const auto& document = reader.getDocument();
+    auto skins = document.find("skins");
+    const bool skinned = std::any_of(imported.primitives.begin(), imported.primitives.end(),
+        [](const ImportedPrimitive& primitive) { return !primitive.skin.empty(); });
+    if (!skinned || skins == document.end() || !skins->is_array() || skins->empty())
+    {
+        //Joint influences without a skin have nothing to bind to
+        for (auto& primitive : imported.primitives)
+        {
+            primitive.skin.clear();
+        }
+        return {};
+    }
+
+    //One skeleton per model: the first skin. The skinned mesh's own node
+    //transform is ignored as glTF requires, but nodes that are not joints
+    //themselves, such as an armature above the root joints, move the joints
+    //and are folded into the joint below them.
+    const auto& skin = (*skins)[0];
+    auto joints = skin.find("joints");
+    if (joints == skin.end() || !joints->is_array() || joints->empty() || joints->size() > 0xFFFF)
+    {
+        throw std::runtime_error("glTF skin without a usable joint list");
+    }
+    const auto& nodes = document["nodes"];
+    const size_t nodeCount = nodes.size();
+    const size_t jointCount = joints->size();
+    std::vector<int32_t> nodeJoints(nodeCount, -1);
+    std::vector<int64_t> sourceNodes(jointCount);
+    for (size_t i = 0; i < jointCount; ++i)
+    {
+        const auto& joint = (*joints)[i];
+        if (!joint.is_number_unsigned() || joint.get<uint64_t>() >= nodeCount || nodeJoints[joint.get<size_t>()] >= 0)
+        {
+            throw std::runtime_error("Invalid glTF skin joint");
+        }
+        sourceNodes[i] = joint.get<int64_t>();
+        nodeJoints[sourceNodes[i]] = int32_t(i);
+    }
+
+    //Node parents from the children lists, then the nearest joint above each
+    //joint and the transform of the nodes skipped on the way
+    std::vector<int64_t> nodeParents(nodeCount, -1);
+    for (size_t n = 0; n < nodeCount; ++n)
+    {
+        auto children = nodes[n].find("children");
+        if (children == nodes[n].end() || !children->is_array())
+        {
+            continue;
+        }
+        for (const auto& child : *children)
+        {
+            if (!child.is_number_unsigned() || child.get<uint64_t>() >= nodeCount)
+            {
+                throw std::runtime_error("Invalid glTF node child");
+            }
+            nodeParents[child.get<size_t>()] = int64_t(n);
+        }
+    }
+    std::vector<int32_t> sourceParents(jointCount, -1);
+    std::vector<JointNode> sourceJoints(jointCount);
+    for (size_t i = 0; i < jointCount; ++i)
+    {
+        auto& joint = sourceJoints[i];
+        joint.node = sourceNodes[i];
+        joint.hasOffset = false;
+        for (int d = 0; d < 16; ++d)
+        {
+            joint.offset[d] = d % 5 == 0 ? 1.0f : 0.0f;
+        }
+        int64_t node = nodeParents[sourceNodes[i]];
+        for (size_t steps = 0; node >= 0 && nodeJoints[node] < 0; ++steps)
+        {
+            if (steps > nodeCount)
+            {
+                throw std::runtime_error("Cycle in glTF node hierarchy");
+            }
+            //Walking up, so each node's transform applies before the ones below it
+            const auto pose = readNodePose(nodes[node]);
+            const bool identity = pose.translation[0] == 0.0f && pose.translation[1] == 0.0f && pose.translation[2] == 0.0f &&
+                pose.rotation[0] == 0.0f && pose.rotation[1] == 0.0f && pose.rotation[2] == 0.0f &&
+                pose.scale[0] == 1.0f && pose.scale[1] == 1.0f && pose.scale[2] == 1.0f;
+            if (!identity)
+            {
+                float m[16];
+                poseToMatrix(pose, m);
+                multiplyMatrices(m, joint.offset, joint.offset);
+                joint.hasOffset = true;
+            }
+            node = nodeParents[node];
+        }
+        sourceParents[i] = node >= 0 ? nodeJoints[node] : -1;
+    }
+    std::vector<uint32_t> depths(jointCount, 0);
+    for (size_t i = 0; i < jointCount; ++i)
+    {
+        for (int32_t parent = sourceParents[i]; parent >= 0; parent = sourceParents[parent])
+        {
+            if (++depths[i] > jointCount)
+            {
+                throw std::runtime_error("Cycle in glTF skin joints");
+            }
+        }
+    }
+
+    //Parents first: stable order by depth keeps siblings in source order
+    std::vector<uint32_t> order(jointCount);
+    for (uint32_t i = 0; i < uint32_t(jointCount); ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&depths](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+    std::vector<uint16_t> remap(jointCount);
+    for (size_t k = 0; k < jointCount; ++k)
+    {
+        remap[order[k]] = uint16_t(k);
+    }
+
+    //Missing inverse bind matrices are identity
+    std::vector<float> sourceInverseBinds(jointCount * 16, 0.0f);
+    for (size_t i = 0; i < jointCount; ++i)
+    {
+        for (int d = 0; d < 4; ++d)
+        {
+            sourceInverseBinds[i * 16 + d * 5] = 1.0f;
+        }
+    }
+    const auto inverseBindIndex = GlbReader::getIndex(skin, "inverseBindMatrices");
+    if (inverseBindIndex >= 0)
+    {
+        const auto accInverseBind = resolveAccessor(reader, inverseBindIndex);
+        if (accInverseBind.count < jointCount || accInverseBind.componentCount != 16)
+        {
+            throw std::runtime_error("glTF inverseBindMatrices must be a MAT4 per joint");
+        }
+        AccessorDecoder::readFloats(accInverseBind, sourceInverseBinds.data(), 16 * sizeof(float), 16);
+    }
+
+    auto& skeleton = imported.skeleton;
+    skeleton.parents.resize(jointCount);
+    skeleton.inverseBindMatrices.resize(jointCount * 16);
+    skeleton.restPose.resize(jointCount);
+    std::vector<JointNode> jointNodes(jointCount);
+    for (size_t k = 0; k < jointCount; ++k)
+    {
+        const uint32_t source = order[k];
+        skeleton.parents[k] = sourceParents[source] < 0 ? -1 : int32_t(remap[sourceParents[source]]);
+        std::copy(&sourceInverseBinds[source * 16], &sourceInverseBinds[source * 16] + 16, &skeleton.inverseBindMatrices[k * 16]);
+        jointNodes[k] = sourceJoints[source];
+        const auto pose = readNodePose(nodes[sourceNodes[source]]);
+        skeleton.restPose[k] = jointNodes[k].hasOffset ? applyOffset(jointNodes[k].offset, pose) : pose;
+    }
+
+    for (auto& primitive : imported.primitives)
+    {
+        for (auto& influence : primitive.skin)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                //Unweighted slots may hold any index, point them at the root
+                if (influence.weights[k] == 0.0f)
+                {
+                    influence.joints[k] = 0;
+                    continue;
+                }
+                if (influence.joints[k] >= jointCount)
+                {
+                    throw std::runtime_error("JOINTS_0 index outside the skin");
+                }
+                influence.joints[k] = remap[influence.joints[k]];
+            }
+        }
+    }
+
+    char line[256];
+    snprintf(line, sizeof(line), "%s: skeleton with %zu joints", path.c_str(), jointCount);
+    logMessage(line);
+    return jointNodes;
+}
+
+void ModelImporter::importAnimations(const std::string& path, const GlbReader& reader, const std::vector<JointNode>& jointNodes,
+    const std::vector<MorphWeightRange>& meshWeights, ImportedModel& imported, const ImportSettings& settings)
+{
+    const auto& document = reader.getDocument();
+    auto animations = document.find("animations");
+    if ((jointNodes.empty() && imported.morphWeights.empty()) ||
+        animations == document.end() || !animations->is_array() || !(settings.animationFrameRate > 0.0f))
+    {
+        return;
+    }
+
+    const uint32_t jointCount = uint32_t(jointNodes.size());
+    const uint32_t weightCount = uint32_t(imported.morphWeights.size());
+    auto nodes = document.find("nodes");
+    std::unordered_map<int64_t, uint32_t> nodeJoints;
+    //Channels animate the node's own transform, the skipped nodes above it are applied after sampling
+    std::vector<JointPose> localPose(jointCount);
+    for (uint32_t k = 0; k < jointCount; ++k)
+    {
+        nodeJoints[jointNodes[k].node] = k;
+        localPose[k] = readNodePose((*nodes)[size_t(jointNodes[k].node)]);
+    }
+
+    for (size_t a = 0; a < animations->size(); ++a)
+    {
+        const auto& animation = (*animations)[a];
+        auto channels = animation.find("channels");
+        auto samplers = animation.find("samplers");
+        if (channels == animation.end() || !channels->is_array() || samplers == animation.end() || !samplers->is_array())
+        {
+            continue;
+        }
+
+        std::vector<AnimationTrack> tracks;
+        float duration = 0.0f;
+        for (const auto& channel : *channels)
+        {
+            auto target = channel.find("target");
+            if (target == channel.end() || !target->is_object())
+            {
+                continue;
+            }
+            const auto node = GlbReader::getIndex(*target, "node");
+            auto pathName = target->find("path");
+            if (pathName == target->end() || !pathName->is_string())
+            {
+                continue;
+            }
+            AnimationTrack track;
+            const auto& property = pathName->get_ref<const std::string&>();
+            if (property == "weights")
+            {
+                //Weights belong to the node's mesh; nodes instancing one mesh share them
+                const int64_t mesh = nodes != document.end() && nodes->is_array() && node >= 0 && size_t(node) < nodes->size() ?
+                    GlbReader::getIndex((*nodes)[size_t(node)], "mesh") : -1;
+                if (mesh < 0 || size_t(mesh) >= meshWeights.size() || meshWeights[size_t(mesh)].count == 0)
+                {
+                    continue;
+                }
+                track.path = AnimationTrack::Weights;
+                track.target = meshWeights[size_t(mesh)].offset;
+                track.components = int(meshWeights[size_t(mesh)].count);
+            }
+            else
+            {
+                auto joint = nodeJoints.find(node);
+                if (joint == nodeJoints.end())
+                {
+                    continue;
+                }
+                track.target = joint->second;
+                if (property == "translation")
+                {
+                    track.path = AnimationTrack::Translation;
+                }
+                else if (property == "rotation")
+                {
+                    track.path = AnimationTrack::Rotation;
+                }
+                else if (property == "scale")
+                {
+                    track.path = AnimationTrack::Scale;
+                }
+                else
+                {
+                    continue;
+                }
+                track.components = track.path == AnimationTrack::Rotation ? 4 : 3;
+            }
+
+            const auto samplerIndex = GlbReader::getIndex(channel, "sampler");
+            if (samplerIndex < 0 || size_t(samplerIndex) >= samplers->size())
+            {
+                throw std::runtime_error("Invalid glTF animation sampler");
+            }
+            const auto& sampler = (*samplers)[size_t(samplerIndex)];
+            auto interpolation = sampler.find("interpolation");
+            const std::string mode = interpolation != sampler.end() && interpolation->is_string() ? interpolation->get<std::string>() : "LINEAR";
+            track.interpolation = mode == "STEP" ? AnimationTrack::Step : mode == "CUBICSPLINE" ? AnimationTrack::CubicSpline : AnimationTrack::Linear;
+
+            const auto accInput = resolveAccessor(reader, GlbReader::getIndex(sampler, "input"));
+            const auto accOutput = resolveAccessor(reader, GlbReader::getIndex(sampler, "output"));
+            //Weight outputs are scalars, one per target and key
+            const size_t valuesPerKey = track.interpolation == AnimationTrack::CubicSpline ? 3 : 1;
+            const int outputComponents = track.path == AnimationTrack::Weights ? 1 : track.components;
+            if (accInput.count == 0 || accInput.componentCount != 1 || accOutput.componentCount != outputComponents ||
+                accOutput.count * size_t(outputComponents) != accInput.count * valuesPerKey * size_t(track.components))
+            {
+                throw std::runtime_error("glTF animation sampler input and output do not match");
+            }
+            track.times.resize(accInput.count);
+            AccessorDecoder::readFloats(accInput, track.times.data(), sizeof(float), 1);
+            track.values.resize(accOutput.count * size_t(outputComponents));
+            AccessorDecoder::readFloats(accOutput, track.values.data(), size_t(outputComponents) * sizeof(float), outputComponents);
+            duration = std::max(duration, track.times.back());
+            tracks.push_back(std::move(track));
+        }
+        if (tracks.empty())
+        {
+            continue;
+        }
+
+        //Every frame starts from the rest pose and default weights, targets without a channel keep them
+        ImportedAnimation clip;
+        auto name = animation.find("name");
+        clip.name = name != animation.end() && name->is_string() ? name->get<std::string>() : "animation " + std::to_string(a);
+        clip.duration = duration;
+        clip.frameRate = settings.animationFrameRate;
+        clip.frameCount = uint32_t(std::ceil(duration * clip.frameRate - 1e-3f)) + 1;
+        clip.keys.resize(size_t(clip.frameCount) * jointCount);
+        clip.weights.resize(size_t(clip.frameCount) * weightCount);
+        for (uint32_t frame = 0; frame < clip.frameCount; ++frame)
+        {
+            std::copy(localPose.begin(), localPose.end(), clip.keys.begin() + size_t(frame) * jointCount);
+            std::copy(imported.morphWeights.begin(), imported.morphWeights.end(), clip.weights.begin() + size_t(frame) * weightCount);
+        }
+        for (const auto& track : tracks)
+        {
+            size_t cursor = 0;
+            for (uint32_t frame = 0; frame < clip.frameCount; ++frame)
+            {
+                float* destination;
+                if (track.path == AnimationTrack::Weights)
+                {
+                    destination = &clip.weights[size_t(frame) * weightCount + track.target];
+                }
+                else
+                {
+                    auto& pose = clip.keys[size_t(frame) * jointCount + track.target];
+                    destination = track.path == AnimationTrack::Translation ? pose.translation :
+                        track.path == AnimationTrack::Rotation ? pose.rotation : pose.scale;
+                }
+                evaluateTrack(track, std::min(float(frame) / clip.frameRate, duration), cursor, destination);
+            }
+        }
+        for (uint32_t k = 0; k < jointCount; ++k)
+        {
+            if (!jointNodes[k].hasOffset)
+            {
+                continue;
+            }
+            for (uint32_t frame = 0; frame < clip.frameCount; ++frame)
+            {
+                auto& pose = clip.keys[size_t(frame) * jointCount + k];
+                pose = applyOffset(jointNodes[k].offset, pose);
+            }
+        }
+
+        char line[256];
+        snprintf(line, sizeof(line), "%s animation '%s': %zu channels baked to %u frames at %g Hz",
+            path.c_str(), clip.name.c_str(), tracks.size(), clip.frameCount, clip.frameRate);
+        logMessage(line);
+        imported.animations.push_back(std::move(clip));
+    }
+}
+
+void ModelImporter::generateTangents(const std::string& path, ImportedModel& imported)
+{
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < imported.primitives.size(); ++i)
+    {
+        if (!imported.primitives[i].hasTangents)
+        {
+            pending.push_back(i);
+        }
+    }
+
+    //Primitives are independent, one task each; split counts are logged afterwards in order
+    std::vector<size_t> splits(pending.size());
+    ThreadPool::getInstance().parallelFor(pending.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& primitive = imported.primitives[pending[i]];
+            const auto sources = TangentGenerator::generate(primitive.indices, primitive.vertices);
+            if (!primitive.skin.empty())
+            {
+                for (uint32_t source : sources)
+                {
+                    primitive.skin.push_back(primitive.skin[source]);
+                }
+            }
+            MorphTargets::appendCopies(primitive, primitive.vertices.size() - sources.size(), sources);
+            splits[i] = sources.size();
+            primitive.hasTangents = true;
+        }
+    });
+
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "%s primitive %zu: generated tangents, %zu vertices split at mirrored UVs",
+            path.c_str(), pending[i], splits[i]);
+        logMessage(line);
+    }
+}
+
+void ModelImporter::quantizeGeometry(const std::string& path, ImportedModel& imported)
+{
+    for (size_t i = 0; i < imported.primitives.size(); ++i)
+    {
+        auto& primitive = imported.primitives[i];
+        auto error = VertexQuantizer::quantize(primitive.vertices, primitive.quantizedVertices, primitive.dequantization);
+
+        char line[256];
+        snprintf(line, sizeof(line), "%s primitive %zu: quantized position error max %g mean %g (%.4f%% of extent), normal error max %.3f deg, tangent %.3f deg, uv %g",
+            path.c_str(), i, error.maxPositionError, error.meanPositionError,
+            error.extent > 0.0f ? error.maxPositionError / error.extent * 100.0f : 0.0f, error.maxNormalError,
+            error.maxTangentError, error.maxUVError);
+        logMessage(line);
+    }
+    imported.vertexFormat = VertexFormat::Quantized;
+}
+
+void ModelImporter::optimizeGeometry(const std::string& path, ImportedModel& imported, const ImportSettings& settings)
+{
+    for (size_t i = 0; i < imported.primitives.size(); ++i)
+    {
+        auto& primitive = imported.primitives[i];
+        auto before = MeshOptimizer::analyzeVertexCache(primitive.indices, primitive.vertices.size());
+
+        if (settings.optimizeVertexCache)
+        {
+            MeshOptimizer::optimizeVertexCache(primitive.indices, primitive.vertices.size());
+        }
+        if (settings.optimizeOverdraw)
+        {
+            MeshOptimizer::optimizeOverdraw(primitive.indices, primitive.vertices, settings.overdrawThreshold);
+        }
+        auto after = MeshOptimizer::analyzeVertexCache(primitive.indices, primitive.vertices.size());
+        char line[256];
+        snprintf(line, sizeof(line), "%s primitive %zu: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+            path.c_str(), i, before.acmr, after.acmr, before.atvr, after.atvr);
+        logMessage(line);
+
+        primitive.lods.assign(1, MeshLod{ 0, uint32_t(primitive.indices.size()), 0.0f });
+        generateLods(path, i, primitive, settings);
+        primitive.clusters.clear();
+        for (auto& lod : primitive.lods)
+        {
+            MeshClusters::build(primitive.indices, primitive.vertices, lod, primitive.clusters);
+        }
+        //All levels share the vertex buffer, order it by first use over the whole chain
+        const auto remap = MeshOptimizer::optimizeVertexFetch(primitive.indices, primitive.vertices);
+        if (!primitive.skin.empty())
+        {
+            std::vector<SkinInfluence> skin(primitive.vertices.size());
+            for (size_t v = 0; v < remap.size(); ++v)
+            {
+                if (remap[v] != ~0u)
+                {
+                    skin[remap[v]] = primitive.skin[v];
+                }
+            }
+            primitive.skin = std::move(skin);
+        }
+        MorphTargets::remapVertices(primitive, remap);
+    }
+}
+
+std::vector<ModelImporter::MorphWeightRange> ModelImporter::importGeometry(const GlbReader& reader, ImportedModel& imported)
+{
+    std::vector<MorphWeightRange> meshWeights;
+    auto meshes = reader.getDocument().find("meshes");
+    if (meshes == reader.getDocument().end() || !meshes->is_array())
+    {
+        return meshWeights;
+    }
+
+    for (const auto &mesh : *meshes)
+    {
+        MorphWeightRange weights{ uint32_t(imported.morphWeights.size()), 0 };
+        auto meshPrimitives = mesh.find("primitives");
+        if (meshPrimitives == mesh.end() || !meshPrimitives->is_array())
+        {
+            meshWeights.push_back(weights);
+            continue;
+        }
+        //Every primitive of a mesh has the same targets, all driven by the mesh weights
+        if (!meshPrimitives->empty())
+        {
+            auto targets = meshPrimitives->front().find("targets");
+            weights.count = targets != meshPrimitives->front().end() && targets->is_array() ? uint32_t(targets->size()) : 0;
+        }
+        if (weights.count != 0)
+        {
+            imported.morphWeights.resize(size_t(weights.offset) + weights.count, 0.0f);
+            if (!readNumbers(mesh, "weights", &imported.morphWeights[weights.offset], weights.count))
+            {
+                std::fill(imported.morphWeights.begin() + weights.offset, imported.morphWeights.end(), 0.0f);
+            }
+        }
+        meshWeights.push_back(weights);
+
+        for (const auto &meshPrimitive : *meshPrimitives)
+        {
+            //Strips, fans, lines and points cannot be drawn as a triangle list
+            if (GlbReader::getUnsigned(meshPrimitive, "mode", ModeTriangles) != ModeTriangles)
+            {
+                continue;
+            }
+
+            auto attributes = meshPrimitive.find("attributes");
+            if (attributes == meshPrimitive.end() || !attributes->is_object())
+            {
+                continue;
+            }
+            const auto positionIndex = GlbReader::getIndex(*attributes, "POSITION");
+            if (positionIndex < 0)
+            {
+                continue;
+            }
+
+            ImportedPrimitive primitive;
+            auto& vertices = primitive.vertices;
+            auto& indices = primitive.indices;
+
+            //Decode vertex attributes straight into the vertex layout
+            const auto accPos = resolveAccessor(reader, positionIndex);
+            vertices.resize(accPos.count, ModelVertex{});
+            AccessorDecoder::readFloats(accPos, vertices[0].Pos, sizeof(ModelVertex), 3);
+
+            const auto normalIndex = GlbReader::getIndex(*attributes, "NORMAL");
+            if (normalIndex >= 0)
+            {
+                const auto accNrm = resolveAccessor(reader, normalIndex);
+                if (accNrm.count != accPos.count)
+                {
+                    throw std::runtime_error("NORMAL count does not match POSITION count");
+                }
+                AccessorDecoder::readFloats(accNrm, vertices[0].Normal, sizeof(ModelVertex), 3);
+            }
+
+            //Normalized integer UVs are expanded to [0, 1] by the decoder
+            const auto texCoordIndex = GlbReader::getIndex(*attributes, "TEXCOORD_0");
+            if (texCoordIndex >= 0)
+            {
+                const auto accUV = resolveAccessor(reader, texCoordIndex);
+                if (accUV.count != accPos.count)
+                {
+                    throw std::runtime_error("TEXCOORD_0 count does not match POSITION count");
+                }
+                AccessorDecoder::readFloats(accUV, vertices[0].UV, sizeof(ModelVertex), 2);
+            }
+
+            const auto tangentIndex = GlbReader::getIndex(*attributes, "TANGENT");
+            if (tangentIndex >= 0)
+            {
+                const auto accTan = resolveAccessor(reader, tangentIndex);
+                if (accTan.count != accPos.count || accTan.componentCount != 4)
+                {
+                    throw std::runtime_error("TANGENT must be a VEC4 per POSITION");
+                }
+                AccessorDecoder::readFloats(accTan, vertices[0].Tangent, sizeof(ModelVertex), 4);
+                primitive.hasTangents = true;
+            }
+
+            //Joint indices are resolved against the skin once the skeleton is known
+            const auto jointsIndex = GlbReader::getIndex(*attributes, "JOINTS_0");
+            const auto weightsIndex = GlbReader::getIndex(*attributes, "WEIGHTS_0");
+            if (jointsIndex >= 0 && weightsIndex >= 0)
+            {
+                const auto accJoints = resolveAccessor(reader, jointsIndex);
+                const auto accWeights = resolveAccessor(reader, weightsIndex);
+                if (accJoints.count != accPos.count || accWeights.count != accPos.count)
+                {
+                    throw std::runtime_error("JOINTS_0/WEIGHTS_0 count does not match POSITION count");
+                }
+                std::vector<float> joints(accPos.count * 4, 0.0f);
+                std::vector<float> weights(accPos.count * 4, 0.0f);
+                AccessorDecoder::readFloats(accJoints, joints.data(), 4 * sizeof(float), 4);
+                AccessorDecoder::readFloats(accWeights, weights.data(), 4 * sizeof(float), 4);
+                primitive.skin.resize(accPos.count);
+                for (size_t v = 0; v < accPos.count; ++v)
+                {
+                    auto& influence = primitive.skin[v];
+                    const float* w = &weights[v * 4];
+                    const float sum = w[0] + w[1] + w[2] + w[3];
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        const float joint = joints[v * 4 + k];
+                        if (!(joint >= 0.0f && joint <= 65535.0f))
+                        {
+                            throw std::runtime_error("JOINTS_0 index out of range");
+                        }
+                        influence.joints[k] = uint16_t(joint);
+                        //Exporters do not always normalize; unweighted vertices follow their first joint
+                        influence.weights[k] = sum > 0.0f ? w[k] / sum : (k == 0 ? 1.0f : 0.0f);
+                    }
+                }
+            }
+
+            //Morph targets are decoded dense, then only moving vertices are kept
+            auto targets = meshPrimitive.find("targets");
+            const size_t targetCount = targets != meshPrimitive.end() && targets->is_array() ? targets->size() : 0;
+            if (targetCount != weights.count)
+            {
+                throw std::runtime_error("glTF primitives of one mesh must have the same morph targets");
+            }
+            for (size_t t = 0; t < targetCount; ++t)
+            {
+                const auto& target = (*targets)[t];
+                if (!target.is_object())
+                {
+                    throw std::runtime_error("Invalid glTF morph target");
+                }
+                std::vector<float> streams[3];
+                const char* names[3] = { "POSITION", "NORMAL", "TANGENT" };
+                for (int k = 0; k < 3; ++k)
+                {
+                    const auto attributeIndex = GlbReader::getIndex(target, names[k]);
+                    if (attributeIndex < 0)
+                    {
+                        continue;
+                    }
+                    const auto accDelta = resolveAccessor(reader, attributeIndex);
+                    if (accDelta.count != accPos.count || accDelta.componentCount != 3)
+                    {
+                        throw std::runtime_error("Morph target attributes must be a VEC3 per POSITION");
+                    }
+                    streams[k].resize(accPos.count * 3);
+                    AccessorDecoder::readFloats(accDelta, streams[k].data(), 3 * sizeof(float), 3);
+                }
+                MorphTargets::appendTarget(primitive, streams[0].empty() ? nullptr : streams[0].data(),
+                    streams[1].empty() ? nullptr : streams[1].data(), streams[2].empty() ? nullptr : streams[2].data());
+            }
+            primitive.morphWeightOffset = weights.offset;
+
+            //Non-indexed primitives draw vertices in order
+            const auto indicesIndex = GlbReader::getIndex(meshPrimitive, "indices");
+            if (indicesIndex >= 0)
+            {
+                const auto accIdx = resolveAccessor(reader, indicesIndex);
+                indices.resize(accIdx.count);
+                AccessorDecoder::readIndices(accIdx, indices.data());
+            }
+            else
+            {
+                indices.resize(accPos.count);
+                for (uint32_t i = 0; i < uint32_t(accPos.count); ++i)
+                {
+                    indices[i] = i;
+                }
+            }
+
+            for (auto index : indices)
+            {
+                if (index >= vertices.size())
+                {
+                    throw std::runtime_error("Index out of range in glTF primitive");
+                }
+            }
+
+            //glTF requires POSITION min/max, so the decoded data only needs scanning for files that omit them
+            float minimum[3];
+            float maximum[3];
+            primitive.bounds = readAccessorBounds(reader, positionIndex, minimum, maximum) ?
+                MeshBounds::fromMinMax(minimum, maximum) : MeshBounds::compute(vertices.data(), vertices.size());
+
+            primitive.materialIndex = int(GlbReader::getIndex(meshPrimitive, "material"));
+            imported.primitives.push_back(std::move(primitive));
+        }
+    }
+    return meshWeights;
+}
+
+bool ModelImporter::readAccessorBounds(const GlbReader& reader, int64_t accessorIndex, float minimum[3], float maximum[3])
+{
+    const auto& accessor = reader.getElement("accessors", accessorIndex);
+    //Integer positions store min/max unnormalized, decoding them is not worth it
+    if (GlbReader::getUnsigned(accessor, "componentType", 0) != AccessorView::Float)
+    {
+        return false;
+    }
+    if (!readNumbers(accessor, "min", minimum, 3) || !readNumbers(accessor, "max", maximum, 3))
+    {
+        return false;
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (!(minimum[axis] <= maximum[axis]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+AccessorView ModelImporter::resolveAccessor(const GlbReader& reader, int64_t accessorIndex)
+{
+    const auto& accessor = reader.getElement("accessors", accessorIndex);
+
+    AccessorView view;
+    view.count = size_t(GlbReader::getUnsigned(accessor, "count", 0));
+    view.componentType = int(GlbReader::getUnsigned(accessor, "componentType", 0));
+    auto type = accessor.find("type");
+    view.componentCount = type != accessor.end() && type->is_string() ? getComponentCount(type->get<std::string>()) : 0;
+    auto normalized = accessor.find("normalized");
+    view.normalized = normalized != accessor.end() && normalized->is_boolean() && normalized->get<bool>();
+    if (view.componentCount <= 0)
+    {
+        throw std::runtime_error("Unsupported accessor type in glTF");
+    }
+    const size_t elementSize = AccessorDecoder::getElementSize(view);
+    view.byteStride = elementSize;
+
+    const auto bufferViewIndex = GlbReader::getIndex(accessor, "bufferView");
+    if (bufferViewIndex >= 0)
+    {
+        auto range = reader.getBufferView(bufferViewIndex);
+        if (range.byteStride != 0)
+        {
+            view.byteStride = range.byteStride;
+        }
+        const uint64_t byteOffset = GlbReader::getUnsigned(accessor, "byteOffset", 0);
+        if (byteOffset > range.size ||
+            (view.count > 0 && (view.count - 1) > (range.size - byteOffset) / view.byteStride) ||
+            (view.count > 0 && byteOffset + view.byteStride * (view.count - 1) + elementSize > range.size))
+        {
+            throw std::runtime_error("Accessor exceeds bufferView size in glTF");
+        }
+        view.data = range.data + byteOffset;
+        view.available = range.size - size_t(byteOffset);
+    }
+
+    auto sparseIt = accessor.find("sparse");
+    if (sparseIt != accessor.end() && sparseIt->is_object() && GlbReader::getUnsigned(*sparseIt, "count", 0) > 0)
+    {
+        auto sparseIndices = sparseIt->find("indices");
+        auto sparseValues = sparseIt->find("values");
+        if (sparseIndices == sparseIt->end() || sparseValues == sparseIt->end())
+        {
+            throw std::runtime_error("Sparse accessor without indices or values in glTF");
+        }
+
+        auto& sparse = view.sparse;
+        sparse.count = size_t(GlbReader::getUnsigned(*sparseIt, "count", 0));
+        sparse.indexComponentType = int(GlbReader::getUnsigned(*sparseIndices, "componentType", 0));
+
+        auto indexRange = reader.getBufferView(GlbReader::getIndex(*sparseIndices, "bufferView"));
+        auto valueRange = reader.getBufferView(GlbReader::getIndex(*sparseValues, "bufferView"));
+        const uint64_t indexOffset = GlbReader::getUnsigned(*sparseIndices, "byteOffset", 0);
+        const uint64_t valueOffset = GlbReader::getUnsigned(*sparseValues, "byteOffset", 0);
+        if (sparse.count > view.count ||
+            indexOffset + sparse.count * AccessorDecoder::getComponentSize(sparse.indexComponentType) > indexRange.size ||
+            valueOffset + sparse.count * elementSize > valueRange.size)
+        {
+            throw std::runtime_error("Sparse accessor exceeds bufferView size in glTF");
+        }
+        sparse.indices = indexRange.data + indexOffset;
+        sparse.values = valueRange.data + valueOffset;
+    }
+
+    return view;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include "ModelData.h"
+#include "AccessorDecoder.h"
+#include "GlbReader.h"
+
+//Converts glTF files to ImportedModel
+class ModelImporter
+{
+public:
+    //Parse .glb file and build CPU side geometry. Textures are only listed,
+    //their levels are built separately by importTexture.
+    static ImportedModel importFile(const std::string& path, const ImportSettings& settings);
+    //Decode one image of reader, build its mip chain and block compress it for
+    //role; throws std::runtime_error on a broken image. materialIndices stays empty.
+    static ImportedTexture importTexture(const std::string& path, const GlbReader& reader, uint32_t imageIndex, TextureRole role,
+        const ImportSettings& settings);
+
+private:
+    //Range of ImportedModel::morphWeights owned by one glTF mesh, count 0 without targets
+    struct MorphWeightRange
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    //glTF node of a joint and the transform of the non-joint nodes between it and
+    //its parent joint, or the scene root for root joints
+    struct JointNode
+    {
+        int64_t node;
+        //Column-major, only meaningful when hasOffset
+        float offset[16];
+        bool hasOffset;
+    };
+
+    //Decode every triangle primitive; returns the morph weights of every glTF mesh
+    static std::vector<MorphWeightRange> importGeometry(const GlbReader& reader, ImportedModel& imported);
+    //Reorder triangles and vertices between decode and cook
+    static void optimizeGeometry(const std::string& path, ImportedModel& imported, const ImportSettings& settings);
+    //Append simplified index ranges after the full detail triangles
+    static void generateLods(const std::string& path, size_t primitiveIndex, ImportedPrimitive& primitive, const ImportSettings& settings);
+    //List every (image, role) pair used by the materials; images outside the
+    //file are logged and skipped so the material falls back at runtime
+    static void collectTextures(const std::string& path, const GlbReader& reader, ImportedModel& imported);
+    //Decode PNG/JPEG bytes to RGBA8, throws std::runtime_error on failure
+    static std::vector<uint8_t> decodeImage(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height);
+    //Skeleton of the first skin with joints sorted parents first and the skin
+    //streams remapped to that order; returns the glTF node of every joint
+    static std::vector<JointNode> importSkeleton(const std::string& path, const GlbReader& reader, ImportedModel& imported);
+    //Bake the joint and morph weight channels of every animation into fixed rate clips
+    static void importAnimations(const std::string& path, const GlbReader& reader, const std::vector<JointNode>& jointNodes,
+        const std::vector<MorphWeightRange>& meshWeights, ImportedModel& imported, const ImportSettings& settings);
+    //MikkTSpace tangents for primitives without a TANGENT attribute, primitives in parallel
+    static void generateTangents(const std::string& path, ImportedModel& imported);
+    //Build QuantizedVertex streams and report the error per primitive
+    static void quantizeGeometry(const std::string& path, ImportedModel& imported);
+    //Bounds checked lookup from a glTF accessor index into the mapped BIN chunk
+    static AccessorView resolveAccessor(const GlbReader& reader, int64_t accessorIndex);
+    //Float accessor min/max when the file provides both, false otherwise
+    static bool readAccessorBounds(const GlbReader& reader, int64_t accessorIndex, float minimum[3], float maximum[3]);
+};
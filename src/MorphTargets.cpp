@@ -0,0 +1,174 @@
+#include "MorphTargets.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MORPH_TARGETS_SSE2 1
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MORPH_TARGETS_AVX2 1
+#endif
+
+namespace
+{
+    //Deltas below this in every component are export noise, not movement
+    constexpr float DeltaEpsilon = 1e-6f;
+    //Weights this small have no visible effect, e.g. the tail of a fade
+    constexpr float WeightEpsilon = 1e-5f;
+
+    //Position, normal and tangent xyz are the first nine floats of both structs
+    static_assert(offsetof(ModelVertex, Normal) == offsetof(MorphDelta, normal), "MorphDelta must mirror ModelVertex");
+    static_assert(offsetof(ModelVertex, Tangent) == offsetof(MorphDelta, tangent), "MorphDelta must mirror ModelVertex");
+    static_assert(sizeof(ModelVertex) >= 12 * sizeof(float), "Vector loads read up to float 8 of the vertex");
+
+    bool lessVertex(const MorphDelta& a, const MorphDelta& b)
+    {
+        return a.vertex < b.vertex;
+    }
+}
+
+void MorphTargets::apply(const MorphDelta* deltas, const uint32_t* targetOffsets, uint32_t targetCount, const float* weights,
+    size_t begin, size_t end, ModelVertex* vertices)
+{
+    for (uint32_t target = 0; target < targetCount; ++target)
+    {
+        const float weight = weights[target];
+        if (std::fabs(weight) < WeightEpsilon)
+        {
+            continue;
+        }
+        //Binary search the task range inside the sorted target
+        MorphDelta key{};
+        key.vertex = uint32_t(begin);
+        const MorphDelta* first = std::lower_bound(deltas + targetOffsets[target], deltas + targetOffsets[target + 1], key, lessVertex);
+        key.vertex = uint32_t(std::min(end, size_t(UINT32_MAX)));
+        const MorphDelta* last = std::lower_bound(first, deltas + targetOffsets[target + 1], key, lessVertex);
+
+#if MORPH_TARGETS_AVX2
+        const __m256 w = _mm256_set1_ps(weight);
+        for (const MorphDelta* delta = first; delta != last; ++delta)
+        {
+            float* v = reinterpret_cast<float*>(&vertices[delta->vertex]);
+            _mm256_storeu_ps(v, _mm256_add_ps(_mm256_loadu_ps(v), _mm256_mul_ps(_mm256_loadu_ps(delta->position), w)));
+            v[8] += delta->tangent[2] * weight;
+        }
+#elif MORPH_TARGETS_SSE2
+        const __m128 w = _mm_set1_ps(weight);
+        for (const MorphDelta* delta = first; delta != last; ++delta)
+        {
+            float* v = reinterpret_cast<float*>(&vertices[delta->vertex]);
+            const float* d = delta->position;
+            _mm_storeu_ps(v, _mm_add_ps(_mm_loadu_ps(v), _mm_mul_ps(_mm_loadu_ps(d), w)));
+            _mm_storeu_ps(v + 4, _mm_add_ps(_mm_loadu_ps(v + 4), _mm_mul_ps(_mm_loadu_ps(d + 4), w)));
+            v[8] += d[8] * weight;
+        }
+#else
+        for (const MorphDelta* delta = first; delta != last; ++delta)
+        {
+            float* v = reinterpret_cast<float*>(&vertices[delta->vertex]);
+            const float* d = delta->position;
+            for (int i = 0; i < 9; ++i)
+            {
+                v[i] += d[i] * weight;
+            }
+        }
+#endif
+    }
+}
+
+void MorphTargets::appendTarget(ImportedPrimitive& primitive, const float* positions, const float* normals, const float* tangents)
+{
+    auto& deltas = primitive.morphDeltas;
+    auto& offsets = primitive.morphTargetOffsets;
+    if (offsets.empty())
+    {
+        offsets.push_back(0);
+    }
+    const size_t vertexCount = primitive.vertices.size();
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        MorphDelta delta{};
+        delta.vertex = uint32_t(v);
+        bool moves = false;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            delta.position[axis] = positions != nullptr ? positions[v * 3 + axis] : 0.0f;
+            delta.normal[axis] = normals != nullptr ? normals[v * 3 + axis] : 0.0f;
+            delta.tangent[axis] = tangents != nullptr ? tangents[v * 3 + axis] : 0.0f;
+            moves = moves || std::fabs(delta.position[axis]) > DeltaEpsilon ||
+                std::fabs(delta.normal[axis]) > DeltaEpsilon || std::fabs(delta.tangent[axis]) > DeltaEpsilon;
+        }
+        if (moves)
+        {
+            deltas.push_back(delta);
+        }
+    }
+    offsets.push_back(uint32_t(deltas.size()));
+}
+
+void MorphTargets::appendCopies(ImportedPrimitive& primitive, size_t firstCopy, const std::vector<uint32_t>& sources)
+{
+    auto& offsets = primitive.morphTargetOffsets;
+    if (offsets.size() < 2 || sources.empty())
+    {
+        return;
+    }
+    //Copies are numbered after every original, appending keeps each target sorted
+    std::vector<MorphDelta> deltas;
+    deltas.reserve(primitive.morphDeltas.size());
+    uint32_t begin = 0;
+    for (size_t target = 0; target + 1 < offsets.size(); ++target)
+    {
+        const MorphDelta* first = primitive.morphDeltas.data() + offsets[target];
+        const MorphDelta* last = primitive.morphDeltas.data() + offsets[target + 1];
+        deltas.insert(deltas.end(), first, last);
+        for (size_t k = 0; k < sources.size(); ++k)
+        {
+            MorphDelta key{};
+            key.vertex = sources[k];
+            const MorphDelta* found = std::lower_bound(first, last, key, lessVertex);
+            if (found != last && found->vertex == sources[k])
+            {
+                deltas.push_back(*found);
+                deltas.back().vertex = uint32_t(firstCopy + k);
+            }
+        }
+        offsets[target] = begin;
+        begin = uint32_t(deltas.size());
+    }
+    offsets.back() = begin;
+    primitive.morphDeltas = std::move(deltas);
+}
+
+void MorphTargets::remapVertices(ImportedPrimitive& primitive, const std::vector<uint32_t>& remap)
+{
+    auto& offsets = primitive.morphTargetOffsets;
+    if (offsets.size() < 2)
+    {
+        return;
+    }
+    std::vector<MorphDelta> deltas;
+    deltas.reserve(primitive.morphDeltas.size());
+    uint32_t begin = 0;
+    for (size_t target = 0; target + 1 < offsets.size(); ++target)
+    {
+        const size_t targetBegin = deltas.size();
+        for (uint32_t i = offsets[target]; i < offsets[target + 1]; ++i)
+        {
+            const uint32_t vertex = remap[primitive.morphDeltas[i].vertex];
+            if (vertex != ~0u)
+            {
+                deltas.push_back(primitive.morphDeltas[i]);
+                deltas.back().vertex = vertex;
+            }
+        }
+        std::sort(deltas.begin() + targetBegin, deltas.end(), lessVertex);
+        offsets[target] = begin;
+        begin = uint32_t(deltas.size());
+    }
+    offsets.back() = begin;
+    primitive.morphDeltas = std::move(deltas);
+}
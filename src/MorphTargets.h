@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+//Sparse morph targets (blend shapes). Each target only stores the vertices it
+//moves, sorted by vertex, so evaluation costs the deltas of active targets.
+class MorphTargets
+{
+public:
+    //Add every target with a non-zero weight to vertices [begin, end). deltas of
+    //target t are deltas[targetOffsets[t], targetOffsets[t + 1])
+    static void apply(const MorphDelta* deltas, const uint32_t* targetOffsets, uint32_t targetCount, const float* weights,
+        size_t begin, size_t end, ModelVertex* vertices);
+
+    //Append a target from dense per-vertex deltas, nullptr for missing attributes;
+    //vertices that do not move are left out
+    static void appendTarget(ImportedPrimitive& primitive, const float* positions, const float* normals, const float* tangents);
+
+    //Vertices appended from firstCopy on, copies of sources, get the deltas of their source
+    static void appendCopies(ImportedPrimitive& primitive, size_t firstCopy, const std::vector<uint32_t>& sources);
+
+    //Follow a vertex reorder, remap[old] = new; vertices mapped to ~0u are dropped
+    static void remapVertices(ImportedPrimitive& primitive, const std::vector<uint32_t>& remap);
+};
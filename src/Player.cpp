@@ -1,11 +1,19 @@
 #include "Player.h"
 
-Player::Player()
+Entity Player::create(World& world, TransformHierarchy& transforms)
 {
-    m_modelID = 1;
+    Entity entity = world.create();
+    world.add<Transform>(entity, transforms.create());
+    world.add<SpatialComponent>(entity);
+    world.add<RenderComponent>(entity, 1u);
+    world.add<PlayerControl>(entity);
+    return entity;
 }
 
-void Player::update()
+void Player::update(const SystemContext& context)
 {
-    m_renderer->delta -= 0.1;
+    context.world.each<PlayerControl, RenderComponent>([](Entity, PlayerControl& control, RenderComponent& render)
+    {
+        render.renderer->delta -= control.cameraSpin;
+    });
 }
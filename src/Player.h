@@ -1,10 +1,12 @@
 #pragma once
-#include "GameObject.h"
-class Player :
-    public GameObject
+#include "SystemScheduler.h"
+#include "Components.h"
+
+//Player entity: prefab and per frame system
+class Player
 {
 public:
-    Player();
-    void update() override;
+    static Entity create(World& world, TransformHierarchy& transforms);
+    static void update(const SystemContext& context);
 };
 
@@ -1,4 +1,9 @@
 #include "Renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include "ContentHash.h"
+#include "Log.h"
 #include <fstream>
 #include <filesystem>
 #include <dxcapi.h>
@@ -20,6 +25,8 @@ void Renderer::initialize(HWND hwnd)
 #else
     m_modelPathList = { "Resources/Field.glb", "Resources/Player.glb", "Resources/Enemy.glb" };
 #endif
+    //Models load on worker threads while the device is being created
+    auto modelLoads = loadModelsAsync();
 
 //Enable debugLayer
 #ifdef _DEBUG
@@ -137,9 +144,16 @@ void Renderer::initialize(HWND hwnd)
     m_viewport = CD3DX12_VIEWPORT(0.0f, 0.0f, float(width), float(height));
     m_scissorRect = CD3DX12_RECT(0, 0, LONG(width), LONG(height));
 
-    for (std::string i : m_modelPathList)
+    createTextureUploader();
+
+    //Join model loading before the first prepare()
+    for (auto& load : modelLoads)
+    {
+        load.get();
+    }
+    for (const auto& path : m_modelPathList)
     {
-        loadModel(i);
+        m_assetWatcher.watch(path);
     }
 
 }
@@ -152,20 +166,18 @@ void Renderer::terminate()
 void Renderer::prepare(UINT modelID)
 {
     //Fetch model from list
-    const std::shared_ptr<tinygltf::Model> model = m_modelList[m_modelPathList[modelID]];
+    const std::shared_ptr<CookedModel> model = getModel(m_modelPathList[modelID]);
     
-    createIndividualDescriptorHeaps(model->materials.size());
+    createIndividualDescriptorHeaps(model->getMaterialCount());
     
-    makeModelGeometry(model);
-    //makeModelMaterial(model);
+    m_model = acquireModelGeometry(modelID);
+    m_modelPath = ModelCache::canonicalizePath(m_modelPathList[modelID]);
+    //Descriptors are written on first use by bindMaterialTextures
+    m_boundTextures.assign(m_frameBufferCount * m_materialSlotCount, nullptr);
+    createAnimation(m_model->geometry);
 
     HRESULT hr;
     ComPtr<ID3DBlob> errBlob;
-    hr = compileShaderFromFile(L"shaderVS.hlsl", L"vs_6_0", m_vs, errBlob);
-    if (FAILED(hr))
-    {
-        OutputDebugStringA((const char*)errBlob->GetBufferPointer());
-    }
     hr = compileShaderFromFile(L"shaderPS.hlsl", L"ps_6_0", m_ps, errBlob);
     if (FAILED(hr))
     {
@@ -179,9 +191,13 @@ void Renderer::prepare(UINT modelID)
     srv.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
     sampler.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 1, 0);
 
-    CD3DX12_ROOT_PARAMETER rootParams[2];
+    CD3DX12_ROOT_PARAMETER rootParams[4];
     rootParams[0].InitAsDescriptorTable(1, &cbv, D3D12_SHADER_VISIBILITY_VERTEX);
     rootParams[1].InitAsDescriptorTable(1, &sampler, D3D12_SHADER_VISIBILITY_PIXEL);
+    //Per mesh dequantization offset/scale, padded to two float4 registers
+    rootParams[2].InitAsConstants(8, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+    //Base color texture of the mesh material
+    rootParams[3].InitAsDescriptorTable(1, &srv, D3D12_SHADER_VISIBILITY_PIXEL);
 
     CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc{};
     rootSigDesc.Init(
@@ -207,7 +223,7 @@ void Renderer::prepare(UINT modelID)
         throw std::runtime_error("CrateRootSignature failed.");
     }
 
-    m_pipelineState = createPipelineState();
+    createVertexPipeline(m_model->geometry->vertexFormat);
 
 
     // 萔obt@/萔obt@r[̐
@@ -310,14 +326,29 @@ void Renderer::render()
 void Renderer::setCommands()
 {
     ShaderParameters shaderParams;
-    XMStoreFloat4x4(&shaderParams.mtxWorld, DirectX::XMMatrixRotationAxis(DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), DirectX::XMConvertToRadians(0.0f)));
+    const auto mtxWorld = DirectX::XMLoadFloat4x4(&m_worldMatrix);
+    XMStoreFloat4x4(&shaderParams.mtxWorld, XMMatrixTranspose(mtxWorld));
     auto eye = DirectX::XMVectorSet(-4.0, 5.0f, -5.0f, 0.0f);
     eye = DirectX::XMVector4Transform(eye, DirectX::XMMatrixRotationY(DirectX::XM_PIDIV4 * delta));
     auto mtxView = DirectX::XMMatrixLookAtLH(
         eye,
         DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
         DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
-    auto mtxProj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(45.0f), m_viewport.Width / m_viewport.Height, 0.1f, 100.0f);
+    const float fovY = DirectX::XMConvertToRadians(45.0f);
+    auto mtxProj = DirectX::XMMatrixPerspectiveFovLH(fovY, m_viewport.Width / m_viewport.Height, 0.1f, 100.0f);
+    //Model space error to pixels at the object's distance, scaled by the largest world axis
+    const auto objectPosition = DirectX::XMVectorSet(m_worldMatrix._41, m_worldMatrix._42, m_worldMatrix._43, 1.0f);
+    const float distance = (std::max)(DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(eye, objectPosition))), 0.1f);
+    const float worldScale = (std::max)(DirectX::XMVectorGetX(DirectX::XMVector3Length(mtxWorld.r[0])),
+        (std::max)(DirectX::XMVectorGetX(DirectX::XMVector3Length(mtxWorld.r[1])), DirectX::XMVectorGetX(DirectX::XMVector3Length(mtxWorld.r[2]))));
+    const float pixelsPerUnit = worldScale * m_viewport.Height / (2.0f * std::tan(fovY * 0.5f) * distance);
+    //Frustum and camera in model space for cluster culling
+    DirectX::XMFLOAT4X4 worldViewProj;
+    DirectX::XMStoreFloat4x4(&worldViewProj, mtxWorld * mtxView * mtxProj);
+    float frustumPlanes[6][4];
+    MeshClusters::extractFrustumPlanes(&worldViewProj.m[0][0], frustumPlanes);
+    DirectX::XMFLOAT3 cameraPosition;
+    DirectX::XMStoreFloat3(&cameraPosition, DirectX::XMVector3Transform(eye, DirectX::XMMatrixInverse(nullptr, mtxWorld)));
     XMStoreFloat4x4(&shaderParams.mtxView, XMMatrixTranspose(mtxView));
     XMStoreFloat4x4(&shaderParams.mtxProj, XMMatrixTranspose(mtxProj));
 
@@ -343,19 +374,90 @@ void Renderer::setCommands()
     };
     m_commandList->SetDescriptorHeaps(_countof(heaps), heaps);
 
-    for (const auto& mesh : m_model.meshes)
+    bindMaterialTextures();
+
+    //Read once so a hot reload never changes geometry in the middle of a frame
+    const ModelHandle geometry = m_model->geometry;
+    if (geometry != m_animatedGeometry)
+    {
+        createAnimation(geometry);
+    }
+    //A reload that adds or drops skins or morph targets switches between float
+    //and quantized vertices; swapModel already waited for the GPU to release the old PSO
+    if (geometry->vertexFormat != m_pipelineFormat)
+    {
+        createVertexPipeline(geometry->vertexFormat);
+    }
+    //Import bounds only hold the bind pose, animated models are never rejected by them
+    if (!m_animation && !MeshBounds::isVisible(geometry->bounds, frustumPlanes))
+    {
+        return;
+    }
+    const size_t meshCount = geometry->meshes.size();
+    for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
     {
+        const auto& mesh = geometry->meshes[meshIndex];
+        const bool deformed = m_animation && mesh.deformed;
+        //Whole meshes outside the frustum skip LOD selection and cluster culling
+        if (!deformed && !MeshBounds::isVisible(mesh.bounds, frustumPlanes))
+        {
+            continue;
+        }
+        D3D12_VERTEX_BUFFER_VIEW vertexView = mesh.vertexView;
+        if (deformed)
+        {
+            //Copy the last animation update into this frame's buffer
+            const size_t slot = m_frameIndex * meshCount + meshIndex;
+            const auto& vertices = m_animation->deformedVertices[meshIndex];
+            void* p;
+            CD3DX12_RANGE range(0, 0);
+            if (SUCCEEDED(m_deformedBuffers[slot]->Map(0, &range, &p)))
+            {
+                memcpy(p, vertices.data(), vertices.size() * sizeof(Vertex));
+                m_deformedBuffers[slot]->Unmap(0, nullptr);
+            }
+            vertexView = m_deformedViews[slot];
+        }
         m_commandList->SetPipelineState(m_pipelineState.Get());
 
         m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        m_commandList->IASetVertexBuffers(0, 1, &mesh.vertexBuffer.vertexView);
-        m_commandList->IASetIndexBuffer(&mesh.indexBuffer.indexView);
+        m_commandList->IASetVertexBuffers(0, 1, &vertexView);
+        m_commandList->IASetIndexBuffer(&mesh.indexView);
 
         m_commandList->SetGraphicsRootDescriptorTable(0, m_cbViews[m_frameIndex]);
         m_commandList->SetGraphicsRootDescriptorTable(1, m_sampler);
+        if (geometry->vertexFormat == VertexFormat::Quantized)
+        {
+            const auto& dq = mesh.dequantization;
+            const float dequantization[8] = {
+                dq.offset[0], dq.offset[1], dq.offset[2], 0.0f,
+                dq.scale[0], dq.scale[1], dq.scale[2], 0.0f,
+            };
+            m_commandList->SetGraphicsRoot32BitConstants(2, _countof(dequantization), dequantization, 0);
+        }
+        //Meshes without a valid material use the last slot, which always holds the fallback
+        const UINT lastSlot = m_materialSlotCount - 1;
+        const UINT materialSlot = mesh.materialIndex >= 0 && UINT(mesh.materialIndex) < lastSlot ? UINT(mesh.materialIndex) : lastSlot;
+        m_commandList->SetGraphicsRootDescriptorTable(3, CD3DX12_GPU_DESCRIPTOR_HANDLE(
+            m_heapSRVCBV->GetGPUDescriptorHandleForHeapStart(),
+            m_srvDescriptorBase + m_frameIndex * m_materialSlotCount + materialSlot,
+            m_srvCBVDescriptorSize));
 
         // ̃bV`
-        m_commandList->DrawIndexedInstanced(mesh.indexCount, 1, 0, 0, 0);
+        const auto& lod = selectLod(mesh, pixelsPerUnit);
+        //Cluster cones and bounds are bind pose, deformed meshes draw the whole level
+        if (lod.clusterCount == 0 || deformed)
+        {
+            m_commandList->DrawIndexedInstanced(lod.indexCount, 1, lod.indexOffset, 0, 0);
+            continue;
+        }
+        //Only clusters inside the frustum and facing the camera are drawn
+        m_drawRanges.clear();
+        MeshClusters::cull(mesh.clusters.data() + lod.clusterOffset, lod.clusterCount, frustumPlanes, &cameraPosition.x, m_drawRanges);
+        for (const auto& range : m_drawRanges)
+        {
+            m_commandList->DrawIndexedInstanced(range.indexCount, 1, range.indexOffset, 0, 0);
+        }
         
     }
 
@@ -395,7 +497,9 @@ ComPtr<ID3D12Resource1> Renderer::createBuffer(UINT bufferSize, const void* init
 void Renderer::createIndividualDescriptorHeaps(UINT materialCount)
 {
     m_srvDescriptorBase = m_frameBufferCount;
-    UINT countCBVSRVDescriptors = materialCount + m_frameBufferCount;
+    //Material SRVs are per frame so one can be rewritten while the GPU reads the other
+    m_materialSlotCount = materialCount + 1;
+    UINT countCBVSRVDescriptors = m_frameBufferCount + m_frameBufferCount * m_materialSlotCount;
 
     //Create descriptor heap for CBV and SRV
     D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc{
@@ -611,205 +715,356 @@ HRESULT Renderer::compileShaderFromFile(const std::wstring& fileName, const std:
 
 }
 
-void Renderer::makeModelGeometry(const std::shared_ptr<tinygltf::Model> model)
+std::shared_ptr<Renderer::ModelSlot> Renderer::acquireModelGeometry(UINT modelID)
 {
-    for (const auto &mesh : model->meshes)
+    const auto& path = m_modelPathList[modelID];
+    auto& entry = m_modelSlots[ModelCache::canonicalizePath(path)];
+    auto slot = entry.lock();
+    if (!slot)
     {
-        for (const auto &meshPrimitive : mesh.primitives)
-        {
-            std::vector<Vertex> vertices;
-            std::vector<uint32_t> indices;
-            
-            //Fetch accessors
-            const auto& accPos = model->accessors[meshPrimitive.attributes.at("POSITION")];
-            const auto& accNrm = model->accessors[meshPrimitive.attributes.at("NORMAL")];
-            const auto& accIdx = model->accessors[meshPrimitive.indices];
-            
-            //Fetch buffer views
-            const auto& bvPos = model->bufferViews[accPos.bufferView];
-            const auto& bvNrm = model->bufferViews[accNrm.bufferView];
-            const auto& bvIdx = model->bufferViews[accIdx.bufferView];
-
-            //Fetch buffers
-            const auto& bPos = model->buffers[bvPos.buffer];
-            const auto& bNrm = model->buffers[bvNrm.buffer];
-            const auto& bIdx = model->buffers[bvIdx.buffer];
-            
-            //Fetch vertex data
-            const float* vertPos = reinterpret_cast<const float*>(&bPos.data[bvPos.byteOffset + accPos.byteOffset]);
-            const float* vertNrm = reinterpret_cast<const float*>(&bNrm.data[bvNrm.byteOffset + accPos.byteOffset]);
-
-            //Assemble vertex data
-            auto vertCount = accPos.count;
-            for (uint32_t i = 0; i < vertCount; ++i)
-            {
-                int vid0 = 3 * i, vid1 = 3 * i + 1, vid2 = 3 * i + 2;
-                vertices.emplace_back(
-                    Vertex
-                    {
-                      DirectX::XMFLOAT3(vertPos[vid0], vertPos[vid1],vertPos[vid2]),
-                      DirectX::XMFLOAT3(vertNrm[vid0], vertNrm[vid1],vertNrm[vid2]),
-                    }
-                );
-            }
-
-            //Fetch index data
-            const uint16_t* idc = reinterpret_cast<const uint16_t*>(&bIdx.data[bvIdx.byteOffset + accPos.byteOffset]);
-            for (size_t i = 0; i < accIdx.count; ++i)
-            {
-                indices.emplace_back(idc[i]);
-            }
-
-            auto vbSize = UINT(sizeof(Vertex) * vertices.size());
-            auto ibSize = UINT(sizeof(uint32_t) * indices.size());
-            ModelMesh modelMesh;
-            auto vb = createBuffer(vbSize, vertices.data());
-            D3D12_VERTEX_BUFFER_VIEW vbView;
-            vbView.BufferLocation = vb->GetGPUVirtualAddress();
-            vbView.SizeInBytes = vbSize;
-            vbView.StrideInBytes = sizeof(Vertex);
-            modelMesh.vertexBuffer.buffer = vb;
-            modelMesh.vertexBuffer.vertexView = vbView;
-
-            auto ib = createBuffer(ibSize, indices.data());
-            D3D12_INDEX_BUFFER_VIEW ibView;
-            ibView.BufferLocation = ib->GetGPUVirtualAddress();
-            ibView.Format = DXGI_FORMAT_R32_UINT;
-            ibView.SizeInBytes = ibSize;
-            modelMesh.indexBuffer.buffer = ib;
-            modelMesh.indexBuffer.indexView = ibView;
-
-            modelMesh.vertexCount = UINT(vertices.size());
-            modelMesh.indexCount = UINT(indices.size());
-            modelMesh.materialIndex = meshPrimitive.material;
-            m_model.meshes.push_back(modelMesh);
-        }
+        slot = std::make_shared<ModelSlot>();
+        slot->geometry = acquireGeometry(getModel(path));
+        entry = slot;
     }
+    return slot;
 }
 
-/*
-void Renderer::makeModelMaterial(const std::shared_ptr<tinygltf::Model> model)
+Renderer::ModelHandle Renderer::acquireGeometry(const std::shared_ptr<CookedModel>& model)
 {
-    int texIdx = 0;
-    for (auto& mat: model->materials)
+    auto& entry = m_geometryRegistry[model->getSourceHash()];
+    auto geometry = entry.lock();
+    if (!geometry)
     {
+        geometry = makeModelGeometry(model);
+        entry = geometry;
+    }
+    return geometry;
+}
 
-        tinygltf::Accessor accTex = model->accessors[mat.pbrMetallicRoughness.baseColorTexture.index];
-        if (accTex.count == 0)
-        {
-            accTex = model->accessors[mat.normalTexture.index];
-        }
-
-        const auto& bvTex = model->bufferViews[accTex.bufferView];
-        const auto& bTex = model->buffers[bvTex.buffer];
-        const unsigned char* texData = reinterpret_cast<const unsigned char*>(&bTex.data[bvTex.byteOffset + accTex.byteOffset]);
-        std::vector<const unsigned char> texture(texData, texData + sizeof(unsigned char*) * (accTex.count - 1));
-
-        Material material{};
-        material.alphaMode = mat.alphaMode;
-        auto texObj = createTextureFromMemory(texture);
-        material.texture = texObj.texture;
-
-        auto descriptorIndex = m_srvDescriptorBase + texIdx;
-        auto srvHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
-            m_heapSRVCBV->GetCPUDescriptorHandleForHeapStart(),
-            descriptorIndex,
-            m_srvCBVDescriptorSize);
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-        srvDesc.Texture2D.MipLevels = 1;
-        srvDesc.Format = texObj.format;
-        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        m_device->CreateShaderResourceView(
-            texObj.texture.Get(), &srvDesc, srvHandle);
-        material.shaderResourceView =
-            CD3DX12_GPU_DESCRIPTOR_HANDLE(
-                m_heapSRVCBV->GetGPUDescriptorHandleForHeapStart(),
-                descriptorIndex,
-                m_srvCBVDescriptorSize);
-
-        m_model.materials.push_back(material);
+Renderer::BufferHandle Renderer::acquireBuffer(uint64_t contentHash, UINT layout, UINT size, const void* data)
+{
+    //Same bytes viewed with another stride/format get their own entry
+    const uint64_t key = hashBytes(&layout, sizeof(layout), contentHash);
+    auto& entry = m_bufferRegistry[key];
+    auto buffer = entry.lock();
+    if (!buffer)
+    {
+        auto created = std::make_shared<BufferObject>();
+        created->buffer = createBuffer(size, data);
+        buffer = created;
+        entry = buffer;
+    }
+    return buffer;
+}
 
-        texIdx++;
+std::shared_ptr<Renderer::Model> Renderer::makeModelGeometry(const std::shared_ptr<CookedModel> model)
+{
+    auto geometry = std::make_shared<Model>();
+    geometry->vertexFormat = model->getVertexFormat();
+    //Cooked streams are already in upload layout, copy them straight into upload heaps
+    for (const auto &primitive : model->getPrimitives())
+    {
+        auto vbSize = UINT(primitive.getVertexBufferSize());
+        auto ibSize = UINT(primitive.getIndexBufferSize());
+        ModelMesh modelMesh;
+        //Identical streams across files and models share one upload heap
+        auto vb = acquireBuffer(primitive.vertexHash, primitive.vertexStride, vbSize, primitive.vertices);
+        D3D12_VERTEX_BUFFER_VIEW vbView;
+        vbView.BufferLocation = vb->buffer->GetGPUVirtualAddress();
+        vbView.SizeInBytes = vbSize;
+        vbView.StrideInBytes = primitive.vertexStride;
+        modelMesh.vertexBuffer = vb;
+        modelMesh.vertexView = vbView;
+
+        auto ib = acquireBuffer(primitive.indexHash, primitive.indexSize, ibSize, primitive.indices);
+        D3D12_INDEX_BUFFER_VIEW ibView;
+        ibView.BufferLocation = ib->buffer->GetGPUVirtualAddress();
+        ibView.Format = primitive.indexSize == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+        ibView.SizeInBytes = ibSize;
+        modelMesh.indexBuffer = ib;
+        modelMesh.indexView = ibView;
+
+        modelMesh.vertexCount = primitive.vertexCount;
+        modelMesh.indexCount = primitive.indexCount;
+        modelMesh.indexFormat = ibView.Format;
+        modelMesh.materialIndex = primitive.materialIndex;
+        modelMesh.dequantization = primitive.dequantization;
+        modelMesh.lods.assign(primitive.lods, primitive.lods + primitive.lodCount);
+        modelMesh.clusters.assign(primitive.clusters, primitive.clusters + primitive.clusterCount);
+        modelMesh.bounds = primitive.bounds;
+        modelMesh.deformed = primitive.skin != nullptr || primitive.morphTargetCount != 0;
+        geometry->bounds = geometry->meshes.empty() ? primitive.bounds : MeshBounds::merge(geometry->bounds, primitive.bounds);
+        geometry->meshes.push_back(modelMesh);
     }
+    return geometry;
 }
 
-Renderer::TextureObject Renderer::createTextureFromMemory(const std::vector<const unsigned char>& imageData)
+void Renderer::createTextureUploader()
 {
-    ComPtr<ID3D12Resource1> staging;
     HRESULT hr;
-    DirectX::ScratchImage image;
-    hr = LoadFromWICMemory(
-        imageData.data(),
-        imageData.size(),
-        DirectX::WIC_FLAGS_NONE,
-        nullptr,
-        image);
+    hr = m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_textureUploadAllocator));
     if (FAILED(hr))
     {
-        throw std::runtime_error("Failed LoadFromWICMemory");
+        throw std::runtime_error("Failed CreateCommandAllocator(texture upload)");
+    }
+    hr = m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_textureUploadAllocator.Get(), nullptr, IID_PPV_ARGS(&m_textureUploadList));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed CreateCommandList(texture upload)");
+    }
+    hr = m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_textureUploadFence));
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed CreateFence(texture upload)");
     }
-    const auto& metadata = image.GetMetadata();
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-
-    DirectX::PrepareUpload(
-        m_device.Get(), image.GetImages(), image.GetImageCount(),
-        metadata, subresources);
 
-    ComPtr<ID3D12Resource> texture;
-    DirectX::CreateTexture(m_device.Get(), metadata, &texture);
+    //1x1 white, neutral for base color until the real texture is resident
+    const uint8_t whiteTexel[4] = { 0xff, 0xff, 0xff, 0xff };
+    CookedModel::Texture white{};
+    white.data = whiteTexel;
+    white.dataSize = sizeof(whiteTexel);
+    white.format = TextureFormat::RGBA8Srgb;
+    white.levelCount = 1;
+    white.levels[0] = { 1, 1, 0, sizeof(whiteTexel), sizeof(whiteTexel) };
+    ComPtr<ID3D12Resource1> staging;
+    m_fallbackTexture = createTexture(white, staging);
+    submitTextureUploads();
+    //Only wait of the upload path, a single texel before the first frame
+    m_textureUploadFence->SetEventOnCompletion(m_textureUploadFenceValue, m_fenceWaitEvent);
+    WaitForSingleObject(m_fenceWaitEvent, m_gpuWaitTimeout);
+}
 
-    const auto totalBytes = GetRequiredIntermediateSize(texture.Get(), 0, UINT(subresources.size()));
-    const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-    const auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(totalBytes);
-    m_device->CreateCommittedResource(
+Renderer::TextureHandle Renderer::createTexture(const CookedModel::Texture& image, ComPtr<ID3D12Resource1>& staging)
+{
+    auto texture = std::make_shared<TextureObject>();
+    texture->format = getTextureFormat(image.format);
+    texture->mipLevels = image.levelCount;
+    const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    const auto resDesc = CD3DX12_RESOURCE_DESC::Tex2D(texture->format, image.levels[0].width, image.levels[0].height, 1, UINT16(image.levelCount));
+    HRESULT hr = m_device->CreateCommittedResource(
         &heapProps,
         D3D12_HEAP_FLAG_NONE,
         &resDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
+        D3D12_RESOURCE_STATE_COPY_DEST,
         nullptr,
-        IID_PPV_ARGS(&staging)
+        IID_PPV_ARGS(&texture->texture)
     );
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed CreateCommittedResource(texture)");
+    }
 
-    ComPtr<ID3D12GraphicsCommandList> command;
-    m_device->CreateCommandList(
-        0, D3D12_COMMAND_LIST_TYPE_DIRECT,
-        m_commandAllocators[m_frameIndex].Get(),
-        nullptr, IID_PPV_ARGS(&command));
+    const auto stagingSize = GetRequiredIntermediateSize(texture->texture.Get(), 0, image.levelCount);
+    staging = createBuffer(UINT(stagingSize), nullptr);
+    if (!staging)
+    {
+        throw std::runtime_error("Failed to create texture staging buffer");
+    }
 
-    UpdateSubresources(
-        command.Get(),
-        texture.Get(), staging.Get(),
-        0, 0, uint32_t(subresources.size()), subresources.data()
-    );
+    //Cooked levels map one to one onto subresources
+    D3D12_SUBRESOURCE_DATA subresources[MaxTextureLevels];
+    for (uint32_t level = 0; level < image.levelCount; ++level)
+    {
+        subresources[level].pData = image.data + image.levels[level].offset;
+        subresources[level].RowPitch = LONG_PTR(image.levels[level].rowPitch);
+        subresources[level].SlicePitch = LONG_PTR(image.levels[level].size);
+    }
+    //Copies the levels into staging right away, nothing refers to the cooked data after this
+    UpdateSubresources(m_textureUploadList.Get(), texture->texture.Get(), staging.Get(), 0, 0, image.levelCount, subresources);
 
     auto barrierTex = CD3DX12_RESOURCE_BARRIER::Transition(
-        texture.Get(),
+        texture->texture.Get(),
         D3D12_RESOURCE_STATE_COPY_DEST,
         D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
     );
-    command->ResourceBarrier(1, &barrierTex);
+    m_textureUploadList->ResourceBarrier(1, &barrierTex);
+    return texture;
+}
 
-    command->Close();
-    ID3D12CommandList* cmds[] = { command.Get() };
-    m_commandQueue->ExecuteCommandLists(1, cmds);
-    m_frameFenceValues[m_frameIndex]++;
-    waitGPU();
+void Renderer::submitTextureUploads()
+{
+    m_textureUploadList->Close();
+    ID3D12CommandList* lists[] = { m_textureUploadList.Get() };
+    m_commandQueue->ExecuteCommandLists(1, lists);
+    m_commandQueue->Signal(m_textureUploadFence.Get(), ++m_textureUploadFenceValue);
+}
 
-    TextureObject ret;
-    texture.As(&ret.texture);
-    ret.format = metadata.format;
+void Renderer::updateTextures()
+{
+    //One batch in flight at a time; publish it once the GPU has copied it
+    if (!m_textureUploads.empty())
+    {
+        if (m_textureUploadFence->GetCompletedValue() < m_textureUploadFenceValue)
+        {
+            return;
+        }
+        for (const auto& upload : m_textureUploads)
+        {
+            auto& textures = m_materialTextures[upload.path];
+            for (auto materialIndex : upload.materialIndices)
+            {
+                if (textures.size() <= materialIndex)
+                {
+                    textures.resize(materialIndex + 1);
+                }
+                textures[materialIndex] = upload.texture;
+            }
+        }
+        m_textureUploads.clear();
+    }
 
-    return ret;
+    auto images = m_textureStreamer.takeReady(TextureUploadBudget);
+    if (images.empty())
+    {
+        return;
+    }
+    m_textureUploadAllocator->Reset();
+    m_textureUploadList->Reset(m_textureUploadAllocator.Get(), nullptr);
+    for (auto& image : images)
+    {
+        TextureUpload upload;
+        upload.texture = createTexture(*image.texture, upload.staging);
+        upload.path = std::move(image.path);
+        upload.materialIndices.assign(image.texture->materialIndices, image.texture->materialIndices + image.texture->materialCount);
+        m_textureUploads.push_back(std::move(upload));
+    }
+    submitTextureUploads();
 }
-*/
 
-ComPtr<ID3D12PipelineState> Renderer::createPipelineState()
+void Renderer::bindMaterialTextures()
+{
+    //Descriptors of this frame are no longer read by the GPU after waitPreviousFrame
+    const auto resident = m_materialTextures.find(m_modelPath);
+    for (UINT slot = 0; slot < m_materialSlotCount; ++slot)
+    {
+        TextureHandle texture = m_fallbackTexture;
+        if (resident != m_materialTextures.end() && slot < resident->second.size() && resident->second[slot])
+        {
+            texture = resident->second[slot];
+        }
+        auto& bound = m_boundTextures[m_frameIndex * m_materialSlotCount + slot];
+        if (bound == texture)
+        {
+            continue;
+        }
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+        srvDesc.Texture2D.MipLevels = texture->mipLevels;
+        srvDesc.Format = texture->format;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        auto srvHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
+            m_heapSRVCBV->GetCPUDescriptorHandleForHeapStart(),
+            m_srvDescriptorBase + m_frameIndex * m_materialSlotCount + slot,
+            m_srvCBVDescriptorSize);
+        m_device->CreateShaderResourceView(texture->texture.Get(), &srvDesc, srvHandle);
+        //Keeps the texture alive while this frame's descriptor points at it
+        bound = texture;
+    }
+}
+
+void Renderer::updateAnimation()
+{
+    m_animationSystem.update(AnimationTimeStep);
+}
+
+void Renderer::setWorldMatrix(const float* matrix)
+{
+    //Column-major floats read row by row are the transposed, row-vector matrix DirectXMath uses
+    memcpy(&m_worldMatrix, matrix, sizeof(m_worldMatrix));
+}
+
+void Renderer::createAnimation(const ModelHandle& geometry)
+{
+    m_animatedGeometry = geometry;
+    m_animation.reset();
+    m_deformedBuffers.clear();
+    m_deformedViews.clear();
+    const auto model = getModel(m_modelPath);
+    if (!AnimationSystem::isAnimated(*model))
+    {
+        return;
+    }
+    m_animation = m_animationSystem.create(model);
+
+    //Deformed meshes are rewritten by the CPU every frame, one buffer per frame in flight
+    const size_t meshCount = geometry->meshes.size();
+    m_deformedBuffers.resize(m_frameBufferCount * meshCount);
+    m_deformedViews.resize(m_frameBufferCount * meshCount);
+    for (UINT frame = 0; frame < m_frameBufferCount; ++frame)
+    {
+        for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+        {
+            const auto& mesh = geometry->meshes[meshIndex];
+            if (!mesh.deformed)
+            {
+                continue;
+            }
+            const size_t slot = frame * meshCount + meshIndex;
+            const UINT size = UINT(mesh.vertexCount * sizeof(Vertex));
+            m_deformedBuffers[slot] = createBuffer(size, nullptr);
+            m_deformedViews[slot].BufferLocation = m_deformedBuffers[slot]->GetGPUVirtualAddress();
+            m_deformedViews[slot].SizeInBytes = size;
+            m_deformedViews[slot].StrideInBytes = sizeof(Vertex);
+        }
+    }
+}
+
+DXGI_FORMAT Renderer::getTextureFormat(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::RGBA8Srgb: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    case TextureFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+    case TextureFormat::BC1Srgb: return DXGI_FORMAT_BC1_UNORM_SRGB;
+    case TextureFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+    case TextureFormat::BC3Srgb: return DXGI_FORMAT_BC3_UNORM_SRGB;
+    case TextureFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+    case TextureFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+    case TextureFormat::BC7Srgb: return DXGI_FORMAT_BC7_UNORM_SRGB;
+    default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+const MeshLod& Renderer::selectLod(const ModelMesh& mesh, float pixelsPerUnit)
+{
+    size_t level = 0;
+    while (level + 1 < mesh.lods.size() && mesh.lods[level + 1].error * pixelsPerUnit <= LodPixelThreshold)
+    {
+        ++level;
+    }
+    return mesh.lods[level];
+}
+
+void Renderer::createVertexPipeline(VertexFormat format)
+{
+    //Quantized vertices are expanded in their own vertex shader
+    const auto vertexShader = format == VertexFormat::Quantized ? L"shaderQuantizedVS.hlsl" : L"shaderVS.hlsl";
+    ComPtr<ID3DBlob> errBlob;
+    HRESULT hr = compileShaderFromFile(vertexShader, L"vs_6_0", m_vs, errBlob);
+    if (FAILED(hr))
+    {
+        OutputDebugStringA((const char*)errBlob->GetBufferPointer());
+    }
+    m_pipelineState = createPipelineState(format);
+    m_pipelineFormat = format;
+}
+
+ComPtr<ID3D12PipelineState> Renderer::createPipelineState(VertexFormat format)
 {
     // CvbgCAEg
     D3D12_INPUT_ELEMENT_DESC inputElementDesc[] = {
       { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Pos), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
       { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT,0, offsetof(Vertex,Normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
+      { "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Vertex, Tangent), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
+      { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, UV), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
+    };
+    //Unorm/snorm formats hand the shader values already scaled to [0,1] and [-1,1]
+    D3D12_INPUT_ELEMENT_DESC quantizedElementDesc[] = {
+      { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(QuantizedVertex, Pos), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
+      { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(QuantizedVertex, Normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
+      { "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(QuantizedVertex, Tangent), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
+      { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, offsetof(QuantizedVertex, UV), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA},
     };
 
     // pCvCXe[gIuWFNg̐.
@@ -827,7 +1082,14 @@ ComPtr<ID3D12PipelineState> Renderer::createPipelineState()
     // fvXobt@̃tH[}bgݒ
     psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
     psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-    psoDesc.InputLayout = { inputElementDesc, _countof(inputElementDesc) };
+    if (format == VertexFormat::Quantized)
+    {
+        psoDesc.InputLayout = { quantizedElementDesc, _countof(quantizedElementDesc) };
+    }
+    else
+    {
+        psoDesc.InputLayout = { inputElementDesc, _countof(inputElementDesc) };
+    }
 
     // [gVOl`̃Zbg
     psoDesc.pRootSignature = m_rootSignature.Get();
@@ -862,30 +1124,136 @@ void Renderer::waitGPU()
 }
 
 
-tinygltf::Model* Renderer::getModel(std::string modelPath)
+std::shared_ptr<CookedModel> Renderer::getModel(std::string modelPath)
 {
-    return m_modelList[modelPath].get();
+    const auto canonicalPath = ModelCache::canonicalizePath(modelPath);
+    std::lock_guard<std::mutex> lock(m_modelListMutex);
+    auto path = m_modelPathIndex.find(canonicalPath);
+    if (path == m_modelPathIndex.end())
+    {
+        throw std::runtime_error("Model not loaded: " + modelPath);
+    }
+    return m_modelList.at(path->second);
 }
 
 void Renderer::loadModel(std::string path)
 {
-    tinygltf::TinyGLTF loader;
-    auto model = std::make_unique<tinygltf::Model>();
-    std::string err;
-    std::string warn;
-    bool ret = loader.LoadBinaryFromFile(model.get(), &err, &warn, path);
+    //Maps the cooked cache, re-importing the glTF file only when its content changed
+    auto model = ModelCache::load(path, getImportSettings());
+    const auto canonicalPath = ModelCache::canonicalizePath(path);
+    //Textures are cooked in their own tasks and stream in after startup
+    m_textureStreamer.requestModel(canonicalPath, model, getImportSettings());
+
+    //Files with identical content share the first loaded copy
+    std::lock_guard<std::mutex> lock(m_modelListMutex);
+    const uint64_t hash = model->getSourceHash();
+    m_modelPathIndex[canonicalPath] = hash;
+    m_modelList.emplace(hash, std::move(model));
+}
+
+ImportSettings Renderer::getImportSettings()
+{
+    ImportSettings settings;
+    //Halves vertex memory and fetch bandwidth
+    settings.quantizeVertices = true;
+    return settings;
+}
 
-    if (!warn.empty()) {
-        throw std::runtime_error(warn.c_str());
+void Renderer::updateHotReload()
+{
+    auto& pool = ThreadPool::getInstance();
+    for (const auto& path : m_assetWatcher.poll())
+    {
+        //One load per file at a time, they would race on its cache file
+        auto inFlight = std::find_if(m_pendingReloads.begin(), m_pendingReloads.end(),
+            [&](const PendingReload& reload) { return reload.path == path; });
+        if (inFlight != m_pendingReloads.end())
+        {
+            inFlight->stale = true;
+            continue;
+        }
+        logMessage("Reloading " + path);
+        m_pendingReloads.push_back({ path, pool.submit([path]() { return ModelCache::load(path, getImportSettings()); }) });
+    }
+
+    for (auto reload = m_pendingReloads.begin(); reload != m_pendingReloads.end();)
+    {
+        if (reload->model.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++reload;
+            continue;
+        }
+        if (reload->stale)
+        {
+            const auto path = reload->path;
+            reload->stale = false;
+            reload->model = pool.submit([path]() { return ModelCache::load(path, getImportSettings()); });
+            ++reload;
+            continue;
+        }
+        try
+        {
+            swapModel(reload->path, reload->model.get());
+        }
+        catch (const std::exception& e)
+        {
+            //Broken or half-written file: keep drawing the previous version
+            logMessage("Reload failed, keeping previous model: " + reload->path + ": " + e.what());
+        }
+        reload = m_pendingReloads.erase(reload);
     }
+}
 
-    if (!err.empty()) {
-        throw std::runtime_error(err.c_str());
+void Renderer::swapModel(const std::string& path, std::shared_ptr<CookedModel> model)
+{
+    const auto canonicalPath = ModelCache::canonicalizePath(path);
+    const uint64_t hash = model->getSourceHash();
+    uint64_t previousHash;
+    {
+        std::lock_guard<std::mutex> lock(m_modelListMutex);
+        previousHash = m_modelPathIndex.at(canonicalPath);
+    }
+    if (hash == previousHash)
+    {
+        return;
     }
 
-    if (!ret) {
-        throw std::runtime_error("Failed to parse glTF");
+    //Previous buffers may still be referenced by frames in flight
+    waitGPU();
+    {
+        std::lock_guard<std::mutex> lock(m_modelListMutex);
+        m_modelPathIndex[canonicalPath] = hash;
+        m_modelList.emplace(hash, model);
+        const bool stillUsed = std::any_of(m_modelPathIndex.begin(), m_modelPathIndex.end(),
+            [&](const auto& entry) { return entry.second == previousHash; });
+        if (!stillUsed)
+        {
+            m_modelList.erase(previousHash);
+        }
+    }
+    //Every renderer drawing this path sees the new geometry on its next frame
+    auto slot = m_modelSlots[canonicalPath].lock();
+    if (slot)
+    {
+        slot->geometry = acquireGeometry(model);
     }
+    m_textureStreamer.requestModel(canonicalPath, model, getImportSettings());
+    logMessage("Reloaded " + path);
+}
 
-    m_modelList.insert(std::make_pair(path, std::move(model)));
-}
\ No newline at end of file
+std::vector<std::future<void>> Renderer::loadModelsAsync()
+{
+    std::vector<std::future<void>> loads;
+    auto& pool = ThreadPool::getInstance();
+    std::unordered_set<std::string> submitted;
+    for (const auto& path : m_modelPathList)
+    {
+        //Same file listed twice, under any spelling, would race on its cache file
+        if (!submitted.insert(ModelCache::canonicalizePath(path)).second)
+        {
+            continue;
+        }
+        loads.push_back(pool.submit([this, path]() { loadModel(path); }));
+    }
+    return loads;
+}
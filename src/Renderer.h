@@ -7,7 +7,16 @@
 #include <DirectXTex.h>
 #include <wrl.h>
 #include <stdexcept>
-#include "ThirdPartyHeaders/tiny_gltf.h"
+#include <unordered_map>
+#include <future>
+#include <mutex>
+#include "AnimationSystem.h"
+#include "AssetWatcher.h"
+#include "MeshBounds.h"
+#include "MeshClusters.h"
+#include "ModelCache.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
 
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -24,6 +33,14 @@ public:
     void prepare(UINT modelID);
     void render();
     void terminate();
+    //Re-import changed model files in the background and swap them in; call between frames
+    void updateHotReload();
+    //Upload textures decoded since the last call as one batch; call between frames
+    void updateTextures();
+    //Advance and skin every animated model by one fixed step; call after game updates
+    void updateAnimation();
+    //Column-major world matrix of the model, identity until set
+    void setWorldMatrix(const float* matrix);
     float delta = -1.0f;
 
 private:
@@ -63,11 +80,7 @@ private:
     inline static ComPtr<ID3D12GraphicsCommandList> m_commandList;
     inline static UINT m_frameIndex;
 
-    struct Vertex
-    {
-        DirectX::XMFLOAT3 Pos;
-        DirectX::XMFLOAT3 Normal;
-    };
+    using Vertex = ModelVertex;
 
     struct ShaderParameters
     {
@@ -79,40 +92,79 @@ private:
     struct BufferObject
     {
         ComPtr<ID3D12Resource1> buffer;
-        union
-        {
-            D3D12_VERTEX_BUFFER_VIEW vertexView;
-            D3D12_INDEX_BUFFER_VIEW indexView;
-        };
     };
+    //Upload heap shared by every mesh with the same stream content
+    using BufferHandle = std::shared_ptr<const BufferObject>;
 
     struct TextureObject
     {
         ComPtr<ID3D12Resource1> texture;
         DXGI_FORMAT format;
+        UINT mipLevels;
+    };
+    using TextureHandle = std::shared_ptr<const TextureObject>;
+
+    //Texture copied by the upload batch in flight, published once the GPU is done
+    struct TextureUpload
+    {
+        std::string path;
+        std::vector<uint32_t> materialIndices;
+        TextureHandle texture;
+        ComPtr<ID3D12Resource1> staging;
     };
 
     struct ModelMesh
     {
-        BufferObject vertexBuffer;
-        BufferObject indexBuffer;
+        BufferHandle vertexBuffer;
+        BufferHandle indexBuffer;
+        D3D12_VERTEX_BUFFER_VIEW vertexView;
+        D3D12_INDEX_BUFFER_VIEW indexView;
         uint32_t vertexCount;
         uint32_t indexCount;
+        DXGI_FORMAT indexFormat;
+        PositionDequantization dequantization;
+        //Index ranges per detail level, finest first
+        std::vector<MeshLod> lods;
+        std::vector<MeshCluster> clusters;
+        //Model space box and sphere from import
+        BoundingVolume bounds;
+        //Skinned or morphed, drawn from the per-frame CPU deformed copy instead of vertexBuffer
+        bool deformed;
 
         int materialIndex;
     };
 
-    struct Material
-    {
-        ComPtr<ID3D12Resource1> texture;
-        CD3DX12_GPU_DESCRIPTOR_HANDLE shaderResourceView;
-        std::string alphaMode;
-    };
 
     struct Model
     {
         std::vector<ModelMesh> meshes;
+        VertexFormat vertexFormat = VertexFormat::Float;
+        //Union of the mesh bounds, for whole-model culling and broadphase
+        BoundingVolume bounds;
     };
+    //Shared, reference counted GPU geometry of one model
+    using ModelHandle = std::shared_ptr<const Model>;
+    //One per model path, every renderer of the path reads its geometry through
+    //it so a hot reload swaps all of them at once
+    struct ModelSlot
+    {
+        ModelHandle geometry;
+    };
+
+    struct PendingReload
+    {
+        std::string path;
+        std::future<std::shared_ptr<CookedModel>> model;
+        //File changed again while loading, load once more when done
+        bool stale = false;
+    };
+
+    //Largest on-screen error in pixels accepted when picking a detail level
+    static constexpr float LodPixelThreshold = 1.0f;
+    //Texture bytes copied per upload batch, bounds the staging memory of one frame
+    static constexpr size_t TextureUploadBudget = 32 << 20;
+    //Animation advances by a fixed step per frame, matching the presentation interval
+    static constexpr float AnimationTimeStep = 1.0f / 60.0f;
 
     enum
     {
@@ -125,12 +177,30 @@ private:
     void waitGPU();
 
     ComPtr<ID3D12Resource1> createBuffer(UINT bufferSize, const void* initialData);
-    //TextureObject createTextureFromMemory(const std::vector<char>& imageData);
+    //Record the copy of every level of image into a new texture on m_textureUploadList
+    TextureHandle createTexture(const CookedModel::Texture& image, ComPtr<ID3D12Resource1>& staging);
+    //Upload queue objects and the fallback texture bound until real ones are resident
+    void createTextureUploader();
+    void submitTextureUploads();
+    //Point this frame's material descriptors at resident textures
+    void bindMaterialTextures();
+    //Start animating geometry if its model is skinned or morphed, with per-frame vertex buffers for the deformed meshes
+    void createAnimation(const ModelHandle& geometry);
     void createIndividualDescriptorHeaps(UINT materialCount);
-    void makeModelGeometry(const std::shared_ptr<tinygltf::Model> model);
-    //void makeModelMaterial(const std::shared_ptr<tinygltf::Model> model);
-    //TextureObject createTextureFromMemory(const std::vector<const unsigned char>& imageData);
-    ComPtr<ID3D12PipelineState> createPipelineState();
+    std::shared_ptr<Model> makeModelGeometry(const std::shared_ptr<CookedModel> model);
+    //Returns the slot of the model path, creating slot and geometry on first use
+    std::shared_ptr<ModelSlot> acquireModelGeometry(UINT modelID);
+    //Returns the registered geometry for the model content, uploading it on first use
+    ModelHandle acquireGeometry(const std::shared_ptr<CookedModel>& model);
+    //Returns the registered buffer for contentHash and layout (stride or index size), creating it on first use
+    BufferHandle acquireBuffer(uint64_t contentHash, UINT layout, UINT size, const void* data);
+    ComPtr<ID3D12PipelineState> createPipelineState(VertexFormat format);
+    //Compile the vertex shader and build the PSO for format. Called again when a
+    //hot reload changes the format, e.g. by adding a skin or morph targets
+    void createVertexPipeline(VertexFormat format);
+    //Coarsest level whose error, scaled to pixels by pixelsPerUnit, stays below LodPixelThreshold
+    static const MeshLod& selectLod(const ModelMesh& mesh, float pixelsPerUnit);
+    static DXGI_FORMAT getTextureFormat(TextureFormat format);
 
     ComPtr<ID3D12DescriptorHeap> m_heapSRVCBV;
     ComPtr<ID3D12DescriptorHeap> m_heapSampler;
@@ -139,20 +209,67 @@ private:
 
     ComPtr<ID3D12RootSignature> m_rootSignature;
     ComPtr<ID3D12PipelineState> m_pipelineState;
+    //Vertex layout m_vs and m_pipelineState were built for
+    VertexFormat m_pipelineFormat = VertexFormat::Float;
     std::vector<ComPtr<ID3D12Resource1>> m_constantBuffers;
 
     D3D12_GPU_DESCRIPTOR_HANDLE m_sampler;
     std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> m_cbViews;
 
-    Model m_model;
+    std::shared_ptr<ModelSlot> m_model;
+    std::string m_modelPath;
+    //Materials of the model plus one slot for meshes without a material
+    UINT m_materialSlotCount;
+    //Texture behind each frame's material descriptors, frame major
+    std::vector<TextureHandle> m_boundTextures;
+    //Visible cluster ranges of the mesh being drawn, reused every frame
+    std::vector<DrawRange> m_drawRanges;
+    //Null for static models
+    std::shared_ptr<AnimationInstance> m_animation;
+    //Geometry the animation was created for, recreated when a hot reload swaps it
+    ModelHandle m_animatedGeometry;
+    //Deformed vertex upload buffers and views, indexed frame * meshCount + mesh
+    std::vector<ComPtr<ID3D12Resource1>> m_deformedBuffers;
+    std::vector<D3D12_VERTEX_BUFFER_VIEW> m_deformedViews;
+    //Row-vector convention like the view and projection matrices
+    DirectX::XMFLOAT4X4 m_worldMatrix = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
 
     ComPtr<ID3DBlob> m_vs;
     ComPtr<ID3DBlob> m_ps;
 
-    tinygltf::Model* getModel(std::string modelPath);
+    //Resolve any spelling of a loaded model path through the canonical path index
+    std::shared_ptr<CookedModel> getModel(std::string modelPath);
     void loadModel(std::string path);
-    inline static std::unordered_map<std::string, std::shared_ptr<tinygltf::Model>> m_modelList;
+    static ImportSettings getImportSettings();
+    //Point path at a re-imported model and update its slot
+    void swapModel(const std::string& path, std::shared_ptr<CookedModel> model);
+    //Dispatch every entry of m_modelPathList to the thread pool
+    std::vector<std::future<void>> loadModelsAsync();
+    inline static std::mutex m_modelListMutex;
+    //Models keyed by source content hash, identical files share one entry
+    inline static std::unordered_map<uint64_t, std::shared_ptr<CookedModel>> m_modelList;
+    //Canonical path to content hash
+    inline static std::unordered_map<std::string, uint64_t> m_modelPathIndex;
+    //GPU geometry keyed by content hash, released when the last handle goes away
+    inline static std::unordered_map<uint64_t, std::weak_ptr<const Model>> m_geometryRegistry;
+    inline static std::unordered_map<uint64_t, std::weak_ptr<const BufferObject>> m_bufferRegistry;
+    //Keyed by canonical path
+    inline static std::unordered_map<std::string, std::weak_ptr<ModelSlot>> m_modelSlots;
+    inline static AssetWatcher m_assetWatcher;
+    inline static std::vector<PendingReload> m_pendingReloads;
     inline static std::vector<std::string> m_modelPathList;
 
+    inline static TextureStreamer m_textureStreamer;
+    //Resident textures per canonical model path and material, null until uploaded
+    inline static std::unordered_map<std::string, std::vector<TextureHandle>> m_materialTextures;
+    inline static TextureHandle m_fallbackTexture;
+    inline static std::vector<TextureUpload> m_textureUploads;
+    inline static ComPtr<ID3D12CommandAllocator> m_textureUploadAllocator;
+    inline static ComPtr<ID3D12GraphicsCommandList> m_textureUploadList;
+    inline static ComPtr<ID3D12Fence1> m_textureUploadFence;
+    inline static UINT64 m_textureUploadFenceValue = 0;
+
+    inline static AnimationSystem m_animationSystem;
+
 };
 
@@ -2,31 +2,73 @@
 
 Scene::Scene()
 {
-
+    //Nodes of destroyed entities would otherwise stay in the hierarchy
+    m_world.onRemove<Transform>([this](Entity, Transform& transform)
+    {
+        m_transforms.destroy(transform.node);
+    });
+    m_world.onRemove<SpatialComponent>([this](Entity, SpatialComponent& spatial)
+    {
+        if (spatial.proxy != SpatialIndex::InvalidProxy)
+        {
+            m_spatialIndex.remove(spatial.proxy);
+        }
+    });
 }
 
 void
 Scene::initialize()
 {
-    for (size_t i = 0; i < m_gameObjectList.size(); ++i)
+    m_world.each<RenderComponent>([](Entity, RenderComponent& render)
     {
-        m_gameObjectList[i]->initialize();
-    }
+        render.renderer.reset(new Renderer);
+        render.renderer->prepare(render.modelID);
+    });
 }
 
 void Scene::draw()
 {
-    for (size_t i = 0; i < m_gameObjectList.size(); ++i)
+    //Only subtrees moved since the last frame are recomputed
+    m_transforms.update();
+    updateSpatialIndex();
+    m_world.each<Transform, RenderComponent>([this](Entity, Transform& transform, RenderComponent& render)
+    {
+        render.renderer->setWorldMatrix(m_transforms.getWorldMatrix(transform.node));
+    });
+    m_world.each<RenderComponent>([](Entity, RenderComponent& render)
     {
-        m_gameObjectList[i]->draw();
-    }
+        render.renderer->render();
+    });
 
 }
 
 void Scene::terminate()
 {
-    for (size_t i = 0; i < m_gameObjectList.size(); ++i)
+    m_world.each<RenderComponent>([](Entity, RenderComponent& render)
+    {
+        render.renderer->terminate();
+    });
+}
+
+void Scene::updateSpatialIndex()
+{
+    m_world.each<Transform, SpatialComponent>([this](Entity entity, Transform& transform, SpatialComponent& spatial)
     {
-        m_gameObjectList[i]->terminate();
-    }
+        //Translation column of the world matrix
+        const float* position = m_transforms.getWorldMatrix(transform.node) + 12;
+        Aabb bounds;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            bounds.min[axis] = position[axis] - spatial.radius;
+            bounds.max[axis] = position[axis] + spatial.radius;
+        }
+        if (spatial.proxy == SpatialIndex::InvalidProxy)
+        {
+            spatial.proxy = m_spatialIndex.insert(bounds, SpatialComponent::toUserData(entity));
+        }
+        else
+        {
+            m_spatialIndex.move(spatial.proxy, bounds);
+        }
+    });
 }
@@ -4,18 +4,32 @@
 #include <unordered_map>
 #include <string>
 #include <stdexcept>
-#include "GameObject.h"
+#include "World.h"
+#include "SystemScheduler.h"
+#include "Components.h"
 
 class Scene
 {
 public:
     Scene();
+    virtual ~Scene() = default;
     void initialize();
     virtual void update() = 0;
     void draw();
     void terminate();
 
 protected:
-    std::vector<std::unique_ptr<GameObject>> m_gameObjectList;
+    //Entities of the scene, set up by the derived scene's constructor
+    World m_world;
+    TransformHierarchy m_transforms;
+    //Per frame systems, registered by the derived scene with their component access
+    SystemScheduler m_systems;
+    //Entities with a SpatialComponent at their last drawn position; systems
+    //may query it concurrently, it only changes in draw and when a
+    //SpatialComponent is removed
+    SpatialIndex m_spatialIndex;
+
+private:
+    void updateSpatialIndex();
 };
 
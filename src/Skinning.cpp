@@ -0,0 +1,161 @@
+#include "Skinning.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SKINNING_SSE2 1
+#endif
+
+namespace
+{
+    //Scale, then rotate, then translate
+    void composeMatrix(const JointPose& pose, float m[16])
+    {
+        const float x = pose.rotation[0], y = pose.rotation[1], z = pose.rotation[2], w = pose.rotation[3];
+        const float sx = pose.scale[0], sy = pose.scale[1], sz = pose.scale[2];
+        m[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+        m[1] = 2.0f * (x * y + w * z) * sx;
+        m[2] = 2.0f * (x * z - w * y) * sx;
+        m[3] = 0.0f;
+        m[4] = 2.0f * (x * y - w * z) * sy;
+        m[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+        m[6] = 2.0f * (y * z + w * x) * sy;
+        m[7] = 0.0f;
+        m[8] = 2.0f * (x * z + w * y) * sz;
+        m[9] = 2.0f * (y * z - w * x) * sz;
+        m[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+        m[11] = 0.0f;
+        m[12] = pose.translation[0];
+        m[13] = pose.translation[1];
+        m[14] = pose.translation[2];
+        m[15] = 1.0f;
+    }
+
+    //result = a * b; result must not alias a or b
+    void multiply(const float a[16], const float b[16], float result[16])
+    {
+#if SKINNING_SSE2
+        const __m128 a0 = _mm_loadu_ps(a);
+        const __m128 a1 = _mm_loadu_ps(a + 4);
+        const __m128 a2 = _mm_loadu_ps(a + 8);
+        const __m128 a3 = _mm_loadu_ps(a + 12);
+        for (int c = 0; c < 4; ++c)
+        {
+            const float* column = b + c * 4;
+            __m128 r = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+            r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+            r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+            _mm_storeu_ps(result + c * 4, r);
+        }
+#else
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                result[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] + a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+            }
+        }
+#endif
+    }
+
+    void normalize3(float v[3])
+    {
+        const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0f)
+        {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+}
+
+void Skinning::computeMatrices(const CookedModel::Skeleton& skeleton, const JointPose* pose, float* jointMatrices, float* skinMatrices)
+{
+    //Parents precede children, so every parent transform is final when read
+    float local[16];
+    for (uint32_t joint = 0; joint < skeleton.jointCount; ++joint)
+    {
+        float* model = jointMatrices + size_t(joint) * 16;
+        const int32_t parent = skeleton.parents[joint];
+        if (parent < 0)
+        {
+            composeMatrix(pose[joint], model);
+        }
+        else
+        {
+            composeMatrix(pose[joint], local);
+            multiply(jointMatrices + size_t(parent) * 16, local, model);
+        }
+        multiply(model, skeleton.inverseBindMatrices + size_t(joint) * 16, skinMatrices + size_t(joint) * 16);
+    }
+}
+
+void Skinning::skinVertices(const float* skinMatrices, const ModelVertex* vertices, const SkinInfluence* skin, size_t begin, size_t end, ModelVertex* result)
+{
+    for (size_t v = begin; v < end; ++v)
+    {
+        const auto& vertex = vertices[v];
+        const auto& influence = skin[v];
+        auto& skinned = result[v];
+        float position[4];
+        float normal[4];
+        float tangent[4];
+#if SKINNING_SSE2
+        //Weighted palette matrix, unused influence slots skipped
+        __m128 c0 = _mm_setzero_ps();
+        __m128 c1 = _mm_setzero_ps();
+        __m128 c2 = _mm_setzero_ps();
+        __m128 c3 = _mm_setzero_ps();
+        for (int k = 0; k < 4; ++k)
+        {
+            if (influence.weights[k] == 0.0f)
+            {
+                continue;
+            }
+            const float* m = skinMatrices + size_t(influence.joints[k]) * 16;
+            const __m128 w = _mm_set1_ps(influence.weights[k]);
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m), w));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+        }
+        auto transform = [&](const float* v3, bool point) {
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(v3[0])), _mm_mul_ps(c1, _mm_set1_ps(v3[1]))), _mm_mul_ps(c2, _mm_set1_ps(v3[2])));
+            return point ? _mm_add_ps(r, c3) : r;
+        };
+        _mm_storeu_ps(position, transform(vertex.Pos, true));
+        _mm_storeu_ps(normal, transform(vertex.Normal, false));
+        _mm_storeu_ps(tangent, transform(vertex.Tangent, false));
+#else
+        float m[16] = {};
+        for (int k = 0; k < 4; ++k)
+        {
+            const float* joint = skinMatrices + size_t(influence.joints[k]) * 16;
+            for (int i = 0; i < 16; ++i)
+            {
+                m[i] += joint[i] * influence.weights[k];
+            }
+        }
+        for (int r = 0; r < 4; ++r)
+        {
+            position[r] = m[r] * vertex.Pos[0] + m[4 + r] * vertex.Pos[1] + m[8 + r] * vertex.Pos[2] + m[12 + r];
+            normal[r] = m[r] * vertex.Normal[0] + m[4 + r] * vertex.Normal[1] + m[8 + r] * vertex.Normal[2];
+            tangent[r] = m[r] * vertex.Tangent[0] + m[4 + r] * vertex.Tangent[1] + m[8 + r] * vertex.Tangent[2];
+        }
+#endif
+        //Non-uniform joint scale would need the inverse transpose; renormalizing covers uniform scale
+        normalize3(normal);
+        normalize3(tangent);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            skinned.Pos[axis] = position[axis];
+            skinned.Normal[axis] = normal[axis];
+            skinned.Tangent[axis] = tangent[axis];
+        }
+        skinned.Tangent[3] = vertex.Tangent[3];
+        skinned.UV[0] = vertex.UV[0];
+        skinned.UV[1] = vertex.UV[1];
+    }
+}
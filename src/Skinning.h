@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ModelCache.h"
+
+//Linear blend skinning on the CPU. Matrices are column-major 4x4, 16 floats each.
+class Skinning
+{
+public:
+    //Model space transform of every joint of pose (attachments, hitboxes) and
+    //the skinning palette: joint transform times inverse bind matrix
+    static void computeMatrices(const CookedModel::Skeleton& skeleton, const JointPose* pose, float* jointMatrices, float* skinMatrices);
+
+    //Skin vertices [begin, end): position, normal and tangent follow the
+    //weighted sum of the palette matrices, UVs and tangent sign are copied.
+    //result may be vertices itself
+    static void skinVertices(const float* skinMatrices, const ModelVertex* vertices, const SkinInfluence* skin, size_t begin, size_t end, ModelVertex* result);
+};
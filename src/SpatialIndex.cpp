@@ -0,0 +1,603 @@
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    //Traversal stack on the stack frame; balanced trees of millions of
+    //objects stay far below it, deeper ones spill to the heap
+    class NodeStack
+    {
+    public:
+        void push(int32_t node)
+        {
+            if (m_size < InlineCapacity)
+            {
+                m_inline[m_size++] = node;
+            }
+            else
+            {
+                m_spill.push_back(node);
+            }
+        }
+
+        int32_t pop()
+        {
+            if (!m_spill.empty())
+            {
+                const int32_t node = m_spill.back();
+                m_spill.pop_back();
+                return node;
+            }
+            return m_inline[--m_size];
+        }
+
+        bool empty() const { return m_size == 0 && m_spill.empty(); }
+
+    private:
+        static constexpr size_t InlineCapacity = 128;
+        int32_t m_inline[InlineCapacity];
+        size_t m_size = 0;
+        std::vector<int32_t> m_spill;
+    };
+
+    Aabb combine(const Aabb& a, const Aabb& b)
+    {
+        Aabb result;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            result.min[axis] = std::min(a.min[axis], b.min[axis]);
+            result.max[axis] = std::max(a.max[axis], b.max[axis]);
+        }
+        return result;
+    }
+
+    float surfaceArea(const Aabb& box)
+    {
+        const float x = box.max[0] - box.min[0];
+        const float y = box.max[1] - box.min[1];
+        const float z = box.max[2] - box.min[2];
+        return 2.0f * (x * y + y * z + z * x);
+    }
+
+    bool overlaps(const Aabb& a, const Aabb& b)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (a.max[axis] < b.min[axis] || b.max[axis] < a.min[axis])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool contains(const Aabb& outer, const Aabb& inner)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (inner.min[axis] < outer.min[axis] || outer.max[axis] < inner.max[axis])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    float distanceSquared(const Aabb& box, const float point[3])
+    {
+        float result = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float d = std::max({ box.min[axis] - point[axis], 0.0f, point[axis] - box.max[axis] });
+            result += d * d;
+        }
+        return result;
+    }
+
+    bool insideFrustum(const Aabb& box, const float planes[6][4])
+    {
+        for (int p = 0; p < 6; ++p)
+        {
+            const float* plane = planes[p];
+            //Box corner farthest along the plane normal
+            const float x = plane[0] >= 0.0f ? box.max[0] : box.min[0];
+            const float y = plane[1] >= 0.0f ? box.max[1] : box.min[1];
+            const float z = plane[2] >= 0.0f ? box.max[2] : box.min[2];
+            if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Slab test; entry distance, 0 when the origin is inside, or false on a miss
+    bool intersectRay(const Aabb& box, const float origin[3], const float inverseDirection[3], float maxDistance, float& entry)
+    {
+        float near = 0.0f;
+        float far = maxDistance;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+            float t1 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+            //NaN from 0 * inf (origin on a slab plane of a parallel ray) keeps the bounds
+            near = t0 > near ? t0 : near;
+            far = t1 < far ? t1 : far;
+            if (near > far)
+            {
+                return false;
+            }
+        }
+        entry = near;
+        return true;
+    }
+
+    bool closerHit(const SpatialHit& a, const SpatialHit& b)
+    {
+        return a.distance < b.distance;
+    }
+}
+
+SpatialIndex::SpatialIndex(float margin)
+    : m_margin(margin)
+{
+}
+
+int32_t SpatialIndex::allocateNode()
+{
+    if (m_freeList == Null)
+    {
+        m_nodes.emplace_back();
+        m_nodes.back().height = 0;
+        return int32_t(m_nodes.size() - 1);
+    }
+    const int32_t node = m_freeList;
+    m_freeList = m_nodes[node].parent;
+    m_nodes[node] = Node{};
+    m_nodes[node].height = 0;
+    return node;
+}
+
+void SpatialIndex::freeNode(int32_t node)
+{
+    m_nodes[node].parent = m_freeList;
+    m_nodes[node].height = -1;
+    m_freeList = node;
+}
+
+void SpatialIndex::validateProxy(uint32_t proxy) const
+{
+    if (proxy >= m_nodes.size() || m_nodes[proxy].height != 0)
+    {
+        throw std::runtime_error("Invalid spatial index proxy");
+    }
+}
+
+uint32_t SpatialIndex::insert(const Aabb& bounds, uint64_t userData)
+{
+    const int32_t leaf = allocateNode();
+    Node& node = m_nodes[leaf];
+    node.bounds = bounds;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        node.fat.min[axis] = bounds.min[axis] - m_margin;
+        node.fat.max[axis] = bounds.max[axis] + m_margin;
+    }
+    node.userData = userData;
+    insertLeaf(leaf);
+    ++m_leafCount;
+    return uint32_t(leaf);
+}
+
+void SpatialIndex::remove(uint32_t proxy)
+{
+    validateProxy(proxy);
+    removeLeaf(int32_t(proxy));
+    freeNode(int32_t(proxy));
+    --m_leafCount;
+}
+
+bool SpatialIndex::move(uint32_t proxy, const Aabb& bounds)
+{
+    validateProxy(proxy);
+    Node& node = m_nodes[proxy];
+    node.bounds = bounds;
+    if (contains(node.fat, bounds))
+    {
+        return false;
+    }
+    removeLeaf(int32_t(proxy));
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        node.fat.min[axis] = bounds.min[axis] - m_margin;
+        node.fat.max[axis] = bounds.max[axis] + m_margin;
+    }
+    insertLeaf(int32_t(proxy));
+    return true;
+}
+
+uint64_t SpatialIndex::getUserData(uint32_t proxy) const
+{
+    validateProxy(proxy);
+    return m_nodes[proxy].userData;
+}
+
+const Aabb& SpatialIndex::getBounds(uint32_t proxy) const
+{
+    validateProxy(proxy);
+    return m_nodes[proxy].bounds;
+}
+
+uint32_t SpatialIndex::getHeight() const
+{
+    return m_root == Null ? 0 : uint32_t(m_nodes[m_root].height);
+}
+
+void SpatialIndex::insertLeaf(int32_t leaf)
+{
+    if (m_root == Null)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = Null;
+        return;
+    }
+
+    //Descend toward the sibling that grows the total surface area least
+    const Aabb leafBox = m_nodes[leaf].fat;
+    int32_t index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        const Node& node = m_nodes[index];
+        const float area = surfaceArea(node.fat);
+        const float combinedArea = surfaceArea(combine(node.fat, leafBox));
+        //Pairing with this node creates a parent of combinedArea
+        const float cost = 2.0f * combinedArea;
+        //Every ancestor grows the same whichever child is taken
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+        auto childCost = [&](int32_t child) {
+            const Node& c = m_nodes[child];
+            const float grown = surfaceArea(combine(c.fat, leafBox));
+            return (c.isLeaf() ? grown : grown - surfaceArea(c.fat)) + inheritanceCost;
+        };
+        const float cost1 = childCost(node.child1);
+        const float cost2 = childCost(node.child2);
+        if (cost < cost1 && cost < cost2)
+        {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = m_nodes[sibling].parent;
+    const int32_t newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].fat = combine(leafBox, m_nodes[sibling].fat);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+    if (oldParent == Null)
+    {
+        m_root = newParent;
+    }
+    else if (m_nodes[oldParent].child1 == sibling)
+    {
+        m_nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        m_nodes[oldParent].child2 = newParent;
+    }
+
+    //Refit and rebalance on the way back up
+    for (index = m_nodes[leaf].parent; index != Null; index = m_nodes[index].parent)
+    {
+        index = balance(index);
+        Node& node = m_nodes[index];
+        node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+        node.fat = combine(m_nodes[node.child1].fat, m_nodes[node.child2].fat);
+    }
+}
+
+void SpatialIndex::removeLeaf(int32_t leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = Null;
+        return;
+    }
+
+    //The sibling takes the parent's place
+    const int32_t parent = m_nodes[leaf].parent;
+    const int32_t grandParent = m_nodes[parent].parent;
+    const int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+    freeNode(parent);
+    if (grandParent == Null)
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = Null;
+        return;
+    }
+    if (m_nodes[grandParent].child1 == parent)
+    {
+        m_nodes[grandParent].child1 = sibling;
+    }
+    else
+    {
+        m_nodes[grandParent].child2 = sibling;
+    }
+    m_nodes[sibling].parent = grandParent;
+
+    for (int32_t index = grandParent; index != Null; index = m_nodes[index].parent)
+    {
+        index = balance(index);
+        Node& node = m_nodes[index];
+        node.height = 1 + std::max(m_nodes[node.child1].height, m_nodes[node.child2].height);
+        node.fat = combine(m_nodes[node.child1].fat, m_nodes[node.child2].fat);
+    }
+}
+
+int32_t SpatialIndex::balance(int32_t iA)
+{
+    Node& A = m_nodes[iA];
+    if (A.isLeaf() || A.height < 2)
+    {
+        return iA;
+    }
+    const int32_t iB = A.child1;
+    const int32_t iC = A.child2;
+    const int32_t difference = m_nodes[iC].height - m_nodes[iB].height;
+
+    //Promote the taller child, its taller child stays below it and the
+    //shorter one moves under A
+    auto rotateUp = [&](int32_t iUp, int32_t iOther, bool upIsChild2) {
+        Node& up = m_nodes[iUp];
+        const int32_t iF = up.child1;
+        const int32_t iG = up.child2;
+        up.child1 = iA;
+        up.parent = A.parent;
+        A.parent = iUp;
+        if (up.parent == Null)
+        {
+            m_root = iUp;
+        }
+        else if (m_nodes[up.parent].child1 == iA)
+        {
+            m_nodes[up.parent].child1 = iUp;
+        }
+        else
+        {
+            m_nodes[up.parent].child2 = iUp;
+        }
+
+        const bool keepF = m_nodes[iF].height > m_nodes[iG].height;
+        const int32_t iKeep = keepF ? iF : iG;
+        const int32_t iMove = keepF ? iG : iF;
+        up.child2 = iKeep;
+        if (upIsChild2)
+        {
+            A.child2 = iMove;
+        }
+        else
+        {
+            A.child1 = iMove;
+        }
+        m_nodes[iMove].parent = iA;
+        A.fat = combine(m_nodes[iOther].fat, m_nodes[iMove].fat);
+        A.height = 1 + std::max(m_nodes[iOther].height, m_nodes[iMove].height);
+        up.fat = combine(A.fat, m_nodes[iKeep].fat);
+        up.height = 1 + std::max(A.height, m_nodes[iKeep].height);
+        return iUp;
+    };
+
+    if (difference > 1)
+    {
+        return rotateUp(iC, iB, true);
+    }
+    if (difference < -1)
+    {
+        return rotateUp(iB, iC, false);
+    }
+    return iA;
+}
+
+void SpatialIndex::queryRange(const Aabb& box, std::vector<uint64_t>& results) const
+{
+    if (m_root == Null)
+    {
+        return;
+    }
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.pop()];
+        if (!overlaps(node.fat, box))
+        {
+            continue;
+        }
+        if (node.isLeaf())
+        {
+            if (overlaps(node.bounds, box))
+            {
+                results.push_back(node.userData);
+            }
+            continue;
+        }
+        stack.push(node.child1);
+        stack.push(node.child2);
+    }
+}
+
+void SpatialIndex::querySphere(const float center[3], float radius, std::vector<uint64_t>& results) const
+{
+    if (m_root == Null)
+    {
+        return;
+    }
+    const float radiusSquared = radius * radius;
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.pop()];
+        if (distanceSquared(node.fat, center) > radiusSquared)
+        {
+            continue;
+        }
+        if (node.isLeaf())
+        {
+            if (distanceSquared(node.bounds, center) <= radiusSquared)
+            {
+                results.push_back(node.userData);
+            }
+            continue;
+        }
+        stack.push(node.child1);
+        stack.push(node.child2);
+    }
+}
+
+void SpatialIndex::queryFrustum(const float planes[6][4], std::vector<uint64_t>& results) const
+{
+    if (m_root == Null)
+    {
+        return;
+    }
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.pop()];
+        if (!insideFrustum(node.isLeaf() ? node.bounds : node.fat, planes))
+        {
+            continue;
+        }
+        if (node.isLeaf())
+        {
+            results.push_back(node.userData);
+            continue;
+        }
+        stack.push(node.child1);
+        stack.push(node.child2);
+    }
+}
+
+void SpatialIndex::queryNearest(const float point[3], size_t k, std::vector<SpatialHit>& results) const
+{
+    results.clear();
+    if (m_root == Null || k == 0)
+    {
+        return;
+    }
+    //results is a max-heap on squared distance while searching, its front is
+    //the k-th best so far and bounds the search
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.pop()];
+        const bool full = results.size() == k;
+        if (node.isLeaf())
+        {
+            const float distance = distanceSquared(node.bounds, point);
+            if (!full)
+            {
+                results.push_back({ node.userData, distance });
+                std::push_heap(results.begin(), results.end(), closerHit);
+            }
+            else if (distance < results.front().distance)
+            {
+                std::pop_heap(results.begin(), results.end(), closerHit);
+                results.back() = { node.userData, distance };
+                std::push_heap(results.begin(), results.end(), closerHit);
+            }
+            continue;
+        }
+        const float distance1 = distanceSquared(m_nodes[node.child1].fat, point);
+        const float distance2 = distanceSquared(m_nodes[node.child2].fat, point);
+        const float limit = full ? results.front().distance : INFINITY;
+        //Nearer child popped first so the bound tightens early
+        if (distance1 < distance2)
+        {
+            if (distance2 < limit)
+            {
+                stack.push(node.child2);
+            }
+            if (distance1 < limit)
+            {
+                stack.push(node.child1);
+            }
+        }
+        else
+        {
+            if (distance1 < limit)
+            {
+                stack.push(node.child1);
+            }
+            if (distance2 < limit)
+            {
+                stack.push(node.child2);
+            }
+        }
+    }
+    std::sort_heap(results.begin(), results.end(), closerHit);
+    for (auto& hit : results)
+    {
+        hit.distance = std::sqrt(hit.distance);
+    }
+}
+
+bool SpatialIndex::raycast(const float origin[3], const float direction[3], float maxDistance, SpatialHit& hit) const
+{
+    if (m_root == Null)
+    {
+        return false;
+    }
+    const float inverseDirection[3] = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+    float best = maxDistance;
+    bool found = false;
+    NodeStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.pop()];
+        float entry;
+        if (node.isLeaf())
+        {
+            if (intersectRay(node.bounds, origin, inverseDirection, best, entry))
+            {
+                best = entry;
+                hit = { node.userData, entry };
+                found = true;
+            }
+            continue;
+        }
+        //Nearer child popped first, a hit there prunes the farther one
+        float entry1, entry2;
+        const bool hit1 = intersectRay(m_nodes[node.child1].fat, origin, inverseDirection, best, entry1);
+        const bool hit2 = intersectRay(m_nodes[node.child2].fat, origin, inverseDirection, best, entry2);
+        if (hit1 && hit2)
+        {
+            stack.push(entry1 < entry2 ? node.child2 : node.child1);
+            stack.push(entry1 < entry2 ? node.child1 : node.child2);
+        }
+        else if (hit1)
+        {
+            stack.push(node.child1);
+        }
+        else if (hit2)
+        {
+            stack.push(node.child2);
+        }
+    }
+    return found;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Axis aligned box in world space
+struct Aabb
+{
+    float min[3] = { 0.0f, 0.0f, 0.0f };
+    float max[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+//Entry found by a nearest or ray query
+struct SpatialHit
+{
+    uint64_t userData = 0;
+    //Distance from the query point or ray origin to the entry's box
+    float distance = 0.0f;
+};
+
+//Dynamic AABB tree over moving objects. Leaves store a box enlarged by a
+//margin, so objects moving a little only update their own bounds and the tree
+//is restructured only when one leaves its enlarged box. Insertion picks the
+//sibling with the least surface area growth and rotations keep the tree
+//balanced, so every query stays logarithmic in the object count.
+//Queries are const and may run concurrently; changes must not overlap them.
+class SpatialIndex
+{
+public:
+    static constexpr uint32_t InvalidProxy = UINT32_MAX;
+
+    //margin is added to every side of a leaf's box
+    explicit SpatialIndex(float margin = 0.25f);
+
+    //Proxy handle for later moves and removal; userData is returned by queries
+    uint32_t insert(const Aabb& bounds, uint64_t userData);
+    void remove(uint32_t proxy);
+    //True when the object left its enlarged box and the tree was changed
+    bool move(uint32_t proxy, const Aabb& bounds);
+
+    uint64_t getUserData(uint32_t proxy) const;
+    const Aabb& getBounds(uint32_t proxy) const;
+    size_t size() const { return m_leafCount; }
+    //Longest root to leaf path, 0 when empty
+    uint32_t getHeight() const;
+
+    //userData of every object whose box overlaps box, appended to results
+    void queryRange(const Aabb& box, std::vector<uint64_t>& results) const;
+    //userData of every object whose box is within radius of center
+    void querySphere(const float center[3], float radius, std::vector<uint64_t>& results) const;
+    //userData of every object whose box is inside or crossing the inward facing
+    //planes, as produced by MeshClusters::extractFrustumPlanes
+    void queryFrustum(const float planes[6][4], std::vector<uint64_t>& results) const;
+    //Up to k objects closest to point, nearest first; replaces results
+    void queryNearest(const float point[3], size_t k, std::vector<SpatialHit>& results) const;
+    //First object box hit by the ray within maxDistance; direction need not be
+    //normalized, distances are in multiples of its length
+    bool raycast(const float origin[3], const float direction[3], float maxDistance, SpatialHit& hit) const;
+
+private:
+    static constexpr int32_t Null = -1;
+
+    struct Node
+    {
+        //Enlarged box for leaves, union of the children otherwise
+        Aabb fat;
+        //Exact box of a leaf's object
+        Aabb bounds;
+        //Parent while in the tree, next free node while on the free list
+        int32_t parent = Null;
+        int32_t child1 = Null;
+        int32_t child2 = Null;
+        //Leaf 0, free -1
+        int32_t height = -1;
+        uint64_t userData = 0;
+
+        bool isLeaf() const { return child1 == Null; }
+    };
+
+    int32_t allocateNode();
+    void freeNode(int32_t node);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    //AVL rotation at node if its children differ in height by more than one; returns the subtree root
+    int32_t balance(int32_t node);
+    void validateProxy(uint32_t proxy) const;
+
+    std::vector<Node> m_nodes;
+    int32_t m_root = Null;
+    int32_t m_freeList = Null;
+    size_t m_leafCount = 0;
+    float m_margin;
+};
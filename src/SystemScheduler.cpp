@@ -0,0 +1,85 @@
+#include "SystemScheduler.h"
+#include <algorithm>
+#include <exception>
+
+namespace
+{
+    bool intersects(const std::vector<size_t>& a, const std::vector<size_t>& b)
+    {
+        for (size_t type : a)
+        {
+            if (std::find(b.begin(), b.end(), type) != b.end())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+bool ComponentAccess::conflicts(const ComponentAccess& other) const
+{
+    return intersects(m_writes, other.m_writes) || intersects(m_writes, other.m_reads) || intersects(m_reads, other.m_writes);
+}
+
+void ComponentAccess::preparePools(World& world) const
+{
+    for (auto prepare : m_preparers)
+    {
+        prepare(world);
+    }
+}
+
+void SystemScheduler::add(ComponentAccess access, System system)
+{
+    Entry entry{ std::move(access), std::move(system), {} };
+    for (size_t i = 0; i < m_systems.size(); ++i)
+    {
+        if (m_systems[i].access.conflicts(entry.access))
+        {
+            entry.dependencies.push_back(i);
+        }
+    }
+    m_systems.push_back(std::move(entry));
+}
+
+void SystemScheduler::run(const SystemContext& context)
+{
+    for (const auto& entry : m_systems)
+    {
+        entry.access.preparePools(context.world);
+    }
+    auto& jobSystem = JobSystem::getInstance();
+    m_jobs.clear();
+    for (const auto& entry : m_systems)
+    {
+        m_dependencies.clear();
+        for (size_t dependency : entry.dependencies)
+        {
+            m_dependencies.push_back(m_jobs[dependency]);
+        }
+        m_jobs.push_back(jobSystem.schedule([&context, &entry]() { entry.system(context); }, m_dependencies));
+    }
+    m_dependencies.clear();
+    //Every system must be done before the frame moves on, even after a failure
+    std::exception_ptr error;
+    for (const auto& job : m_jobs)
+    {
+        try
+        {
+            jobSystem.wait(job);
+        }
+        catch (...)
+        {
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+    m_jobs.clear();
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "SpatialIndex.h"
+#include "TransformHierarchy.h"
+#include "World.h"
+
+//Scene state handed to every system. Access to the Transform component declared
+//to the scheduler stands for the TransformHierarchy, which holds the poses.
+struct SystemContext
+{
+    World& world;
+    TransformHierarchy& transforms;
+    //As of the last draw, unchanged while the systems run
+    const SpatialIndex& spatialIndex;
+};
+
+//Component types a system reads and writes
+class ComponentAccess
+{
+public:
+    template<class... T>
+    ComponentAccess& read()
+    {
+        (add<T>(m_reads), ...);
+        return *this;
+    }
+
+    template<class... T>
+    ComponentAccess& write()
+    {
+        (add<T>(m_writes), ...);
+        return *this;
+    }
+
+    //Either side writes a type the other one touches
+    bool conflicts(const ComponentAccess& other) const;
+    //Create every pool up front; systems running concurrently must not grow the pool table
+    void preparePools(World& world) const;
+
+private:
+    template<class T>
+    void add(std::vector<size_t>& types)
+    {
+        types.push_back(World::getTypeIndex<T>());
+        m_preparers.push_back([](World& world) { world.getPool<T>(); });
+    }
+
+    std::vector<size_t> m_reads;
+    std::vector<size_t> m_writes;
+    std::vector<void (*)(World&)> m_preparers;
+};
+
+//Runs a scene's systems once per frame on the JobSystem. A system waits for
+//every earlier system its component access conflicts with; systems touching
+//disjoint data run concurrently.
+class SystemScheduler
+{
+public:
+    using System = std::function<void(const SystemContext&)>;
+
+    void add(ComponentAccess access, System system);
+    //Returns when every system has finished, rethrowing the first failure
+    void run(const SystemContext& context);
+
+private:
+    struct Entry
+    {
+        ComponentAccess access;
+        System system;
+        //Earlier systems that must finish first
+        std::vector<size_t> dependencies;
+    };
+
+    std::vector<Entry> m_systems;
+    //Job of every system during run, kept to avoid reallocating every frame
+    std::vector<JobSystem::JobHandle> m_jobs;
+    //Jobs the system being scheduled waits for, scratch of run
+    std::vector<JobSystem::JobHandle> m_dependencies;
+};
@@ -0,0 +1,177 @@
+#include "TangentGenerator.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    //UV orientation of a triangle; degenerate ones add nothing and never split vertices
+    enum Orientation : uint8_t
+    {
+        Preserving = 0,
+        Flipping = 1,
+        Degenerate = 2,
+    };
+
+    float dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    //v minus its component along unit n, normalized; false when nothing is left
+    bool projectToPlane(const float v[3], const float n[3], float result[3])
+    {
+        const float d = dot(v, n);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            result[axis] = v[axis] - n[axis] * d;
+        }
+        const float length = std::sqrt(dot(result, result));
+        if (!(length > FLT_MIN))
+        {
+            return false;
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            result[axis] /= length;
+        }
+        return true;
+    }
+}
+
+std::vector<uint32_t> TangentGenerator::generate(std::vector<uint32_t>& indices, std::vector<ModelVertex>& vertices)
+{
+    const size_t vertexCount = vertices.size();
+    const size_t triangleCount = indices.size() / 3;
+    //Angle weighted tangent sums per vertex and orientation
+    std::vector<float> sums(vertexCount * 2 * 3, 0.0f);
+    std::vector<uint8_t> orientations(triangleCount, Degenerate);
+
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t* corner = &indices[t * 3];
+        const auto& v0 = vertices[corner[0]];
+        const auto& v1 = vertices[corner[1]];
+        const auto& v2 = vertices[corner[2]];
+        const float e1[3] = { v1.Pos[0] - v0.Pos[0], v1.Pos[1] - v0.Pos[1], v1.Pos[2] - v0.Pos[2] };
+        const float e2[3] = { v2.Pos[0] - v0.Pos[0], v2.Pos[1] - v0.Pos[1], v2.Pos[2] - v0.Pos[2] };
+        const float s1 = v1.UV[0] - v0.UV[0], t1 = v1.UV[1] - v0.UV[1];
+        const float s2 = v2.UV[0] - v0.UV[0], t2 = v2.UV[1] - v0.UV[1];
+        const float area = s1 * t2 - s2 * t1;
+        if (!(std::fabs(area) > FLT_MIN))
+        {
+            continue;
+        }
+        const uint8_t orientation = area > 0.0f ? Preserving : Flipping;
+        orientations[t] = orientation;
+        //Direction of increasing u, sign corrected so both orientations point the same way
+        const float sign = orientation == Preserving ? 1.0f : -1.0f;
+        const float tangent[3] = {
+            (e1[0] * t2 - e2[0] * t1) * sign,
+            (e1[1] * t2 - e2[1] * t1) * sign,
+            (e1[2] * t2 - e2[2] * t1) * sign,
+        };
+
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto& vertex = vertices[corner[k]];
+            const auto& next = vertices[corner[(k + 1) % 3]];
+            const auto& previous = vertices[corner[(k + 2) % 3]];
+            float projected[3];
+            if (!projectToPlane(tangent, vertex.Normal, projected))
+            {
+                continue;
+            }
+            //Corner angle between the two edges, measured in the normal plane
+            const float toNext[3] = { next.Pos[0] - vertex.Pos[0], next.Pos[1] - vertex.Pos[1], next.Pos[2] - vertex.Pos[2] };
+            const float toPrevious[3] = { previous.Pos[0] - vertex.Pos[0], previous.Pos[1] - vertex.Pos[1], previous.Pos[2] - vertex.Pos[2] };
+            float a[3];
+            float b[3];
+            if (!projectToPlane(toNext, vertex.Normal, a) || !projectToPlane(toPrevious, vertex.Normal, b))
+            {
+                continue;
+            }
+            const float angle = std::acos(std::clamp(dot(a, b), -1.0f, 1.0f));
+            float* sum = &sums[(size_t(corner[k]) * 2 + orientation) * 3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                sum[axis] += projected[axis] * angle;
+            }
+        }
+    }
+
+    //Vertices used by both orientations get a copy carrying the flipped frame
+    std::vector<uint32_t> flippedCopy(vertexCount, UINT32_MAX);
+    std::vector<uint32_t> sources;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (orientations[t] != Flipping)
+        {
+            continue;
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t& index = indices[t * 3 + k];
+            const float* positive = &sums[size_t(index) * 2 * 3];
+            if (positive[0] == 0.0f && positive[1] == 0.0f && positive[2] == 0.0f)
+            {
+                continue;
+            }
+            if (flippedCopy[index] == UINT32_MAX)
+            {
+                flippedCopy[index] = uint32_t(vertices.size());
+                sources.push_back(index);
+                vertices.push_back(vertices[index]);
+            }
+            index = flippedCopy[index];
+        }
+    }
+
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        const float* positive = &sums[v * 2 * 3];
+        const float* flipped = positive + 3;
+        const bool split = flippedCopy[v] != UINT32_MAX;
+        //A vertex only touched by flipping triangles keeps its index and takes that frame
+        const bool useFlipped = !split && (positive[0] == 0.0f && positive[1] == 0.0f && positive[2] == 0.0f);
+        auto assign = [](ModelVertex& vertex, const float* sum, float sign) {
+            float tangent[3];
+            if (projectToPlane(sum, vertex.Normal, tangent))
+            {
+                vertex.Tangent[0] = tangent[0];
+                vertex.Tangent[1] = tangent[1];
+                vertex.Tangent[2] = tangent[2];
+                vertex.Tangent[3] = sign;
+            }
+            else
+            {
+                buildFallback(vertex.Normal, vertex.Tangent);
+            }
+        };
+        assign(vertices[v], useFlipped ? flipped : positive, useFlipped ? -1.0f : 1.0f);
+        if (split)
+        {
+            assign(vertices[flippedCopy[v]], flipped, -1.0f);
+        }
+    }
+    return sources;
+}
+
+void TangentGenerator::buildFallback(const float normal[3], float tangent[4])
+{
+    //Cross with the axis least aligned with the normal
+    const float ax = std::fabs(normal[0]), ay = std::fabs(normal[1]), az = std::fabs(normal[2]);
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    axis[ax <= ay && ax <= az ? 0 : (ay <= az ? 1 : 2)] = 1.0f;
+    float result[3];
+    if (!projectToPlane(axis, normal, result))
+    {
+        result[0] = 1.0f;
+        result[1] = 0.0f;
+        result[2] = 0.0f;
+    }
+    tangent[0] = result[0];
+    tangent[1] = result[1];
+    tangent[2] = result[2];
+    tangent[3] = 1.0f;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+//Per-vertex tangent frames following the MikkTSpace conventions: per-triangle
+//UV gradients projected into each vertex normal plane, weighted by the corner
+//angle, accumulated separately for both UV orientations and orthonormalized.
+//w holds the bitangent sign, bitangent = cross(normal, tangent.xyz) * w.
+class TangentGenerator
+{
+public:
+    //Fill ModelVertex::Tangent from normals and UVs. Vertices shared by
+    //triangles of both UV orientations (mirrored UVs) are split in two, so
+    //vertices may grow and indices are rewritten. Returns the source vertex of
+    //every appended copy, so other per-vertex streams can follow.
+    static std::vector<uint32_t> generate(std::vector<uint32_t>& indices, std::vector<ModelVertex>& vertices);
+
+    //Any unit vector perpendicular to normal, for vertices without usable UVs
+    static void buildFallback(const float normal[3], float tangent[4]);
+};
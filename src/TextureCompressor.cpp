@@ -0,0 +1,571 @@
+#include "TextureCompressor.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "ThreadPool.h"
+
+namespace
+{
+    //BC7 4-bit index interpolation weights out of 64
+    constexpr int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    //Blocks per parallel task, small levels run on the calling thread
+    constexpr size_t BlocksPerTask = 256;
+
+    //Mean and dominant direction of the points; the covariance row with the
+    //largest variance seeds the power iteration so anti-correlated channels converge
+    template<int D>
+    void computePrincipalAxis(const float (*points)[D], int count, float mean[D], float axis[D])
+    {
+        for (int c = 0; c < D; ++c)
+        {
+            mean[c] = 0.0f;
+            for (int i = 0; i < count; ++i)
+            {
+                mean[c] += points[i][c];
+            }
+            mean[c] /= float(count);
+        }
+        float covariance[D][D] = {};
+        for (int i = 0; i < count; ++i)
+        {
+            for (int a = 0; a < D; ++a)
+            {
+                for (int b = 0; b < D; ++b)
+                {
+                    covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+                }
+            }
+        }
+
+        int seed = 0;
+        for (int c = 1; c < D; ++c)
+        {
+            if (covariance[c][c] > covariance[seed][seed])
+            {
+                seed = c;
+            }
+        }
+        for (int c = 0; c < D; ++c)
+        {
+            axis[c] = covariance[seed][c];
+        }
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[D] = {};
+            float length = 0.0f;
+            for (int a = 0; a < D; ++a)
+            {
+                for (int b = 0; b < D; ++b)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length += next[a] * next[a];
+            }
+            if (length < 1e-12f)
+            {
+                break;
+            }
+            length = std::sqrt(length);
+            for (int c = 0; c < D; ++c)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+        float length = 0.0f;
+        for (int c = 0; c < D; ++c)
+        {
+            length += axis[c] * axis[c];
+        }
+        //Flat block: any axis works, the endpoints collapse onto the mean
+        if (length < 1e-12f)
+        {
+            for (int c = 0; c < D; ++c)
+            {
+                axis[c] = 1.0f / std::sqrt(float(D));
+            }
+        }
+        else
+        {
+            length = std::sqrt(length);
+            for (int c = 0; c < D; ++c)
+            {
+                axis[c] /= length;
+            }
+        }
+    }
+
+    //Endpoints at the extremes of the points projected on the principal axis
+    template<int D>
+    void fitEndpoints(const float (*points)[D], float e0[D], float e1[D])
+    {
+        float mean[D];
+        float axis[D];
+        computePrincipalAxis<D>(points, 16, mean, axis);
+        float minimum = FLT_MAX;
+        float maximum = -FLT_MAX;
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < D; ++c)
+            {
+                t += (points[i][c] - mean[c]) * axis[c];
+            }
+            minimum = std::min(minimum, t);
+            maximum = std::max(maximum, t);
+        }
+        for (int c = 0; c < D; ++c)
+        {
+            e0[c] = std::clamp(mean[c] + axis[c] * minimum, 0.0f, 255.0f);
+            e1[c] = std::clamp(mean[c] + axis[c] * maximum, 0.0f, 255.0f);
+        }
+    }
+
+    //Least squares endpoints for fixed interpolation factors t (0 at e0, 1 at e1)
+    template<int D>
+    bool refineEndpoints(const float (*points)[D], const float t[16], float e0[D], float e1[D])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[D] = {};
+        float bx[D] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            const float a = 1.0f - t[i];
+            const float b = t[i];
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < D; ++c)
+            {
+                ax[c] += a * points[i][c];
+                bx[c] += b * points[i][c];
+            }
+        }
+        const float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        for (int c = 0; c < D; ++c)
+        {
+            e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+            e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    uint16_t packColor565(const float color[3])
+    {
+        const int r = std::clamp(int(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+        const int g = std::clamp(int(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+        const int b = std::clamp(int(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+        return uint16_t((r << 11) | (g << 5) | b);
+    }
+
+    void unpackColor565(uint16_t packed, float color[3])
+    {
+        const int r = (packed >> 11) & 31;
+        const int g = (packed >> 5) & 63;
+        const int b = packed & 31;
+        color[0] = float((r << 3) | (r >> 2));
+        color[1] = float((g << 2) | (g >> 4));
+        color[2] = float((b << 3) | (b >> 2));
+    }
+
+    //Quantize, order and index one BC1 endpoint pair; returns the squared error
+    float encodeBC1Endpoints(const float (*points)[3], const float e0[3], const float e1[3], uint8_t block[8], float t[16])
+    {
+        uint16_t c0 = packColor565(e0);
+        uint16_t c1 = packColor565(e1);
+        //Four color mode needs c0 > c1
+        if (c0 < c1)
+        {
+            std::swap(c0, c1);
+        }
+        float palette[4][3];
+        unpackColor565(c0, palette[0]);
+        unpackColor565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+        const float paletteT[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        //Equal endpoints select three color mode, index 0 is still c0
+        const int paletteSize = c0 == c1 ? 1 : 4;
+
+        uint32_t indices = 0;
+        float error = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            float bestError = FLT_MAX;
+            for (int p = 0; p < paletteSize; ++p)
+            {
+                float d = 0.0f;
+                for (int c = 0; c < 3; ++c)
+                {
+                    const float diff = points[i][c] - palette[p][c];
+                    d += diff * diff;
+                }
+                if (d < bestError)
+                {
+                    bestError = d;
+                    best = p;
+                }
+            }
+            indices |= uint32_t(best) << (i * 2);
+            error += bestError;
+            t[i] = paletteT[best];
+        }
+
+        block[0] = uint8_t(c0);
+        block[1] = uint8_t(c0 >> 8);
+        block[2] = uint8_t(c1);
+        block[3] = uint8_t(c1 >> 8);
+        for (int i = 0; i < 4; ++i)
+        {
+            block[4 + i] = uint8_t(indices >> (i * 8));
+        }
+        return error;
+    }
+
+    //7-bit endpoint with a p-bit shared by its channels, picked for the lower error
+    void quantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pBit)
+    {
+        float bestError = FLT_MAX;
+        for (int p = 0; p < 2; ++p)
+        {
+            int candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                candidate[c] = std::clamp(int((endpoint[c] - float(p)) * 0.5f + 0.5f), 0, 127);
+                const float diff = float((candidate[c] << 1) | p) - endpoint[c];
+                error += diff * diff;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                pBit = p;
+                std::copy(candidate, candidate + 4, quantized);
+            }
+        }
+    }
+
+    struct BitWriter
+    {
+        uint8_t* out;
+        uint32_t position = 0;
+
+        void write(uint32_t value, uint32_t bits)
+        {
+            for (uint32_t bit = 0; bit < bits; ++bit, ++position)
+            {
+                if ((value >> bit) & 1)
+                {
+                    out[position >> 3] |= uint8_t(1 << (position & 7));
+                }
+            }
+        }
+    };
+
+    //Quantize and index one BC7 mode 6 endpoint pair; returns the squared error
+    float encodeBC7Endpoints(const float (*points)[4], const float e0[4], const float e1[4], uint8_t block[16], float t[16])
+    {
+        int q[2][4];
+        int pBits[2];
+        quantizeBC7Endpoint(e0, q[0], pBits[0]);
+        quantizeBC7Endpoint(e1, q[1], pBits[1]);
+        int endpoints[2][4];
+        for (int e = 0; e < 2; ++e)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                endpoints[e][c] = (q[e][c] << 1) | pBits[e];
+            }
+        }
+        int palette[16][4];
+        for (int p = 0; p < 16; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                palette[p][c] = ((64 - Bc7Weights[p]) * endpoints[0][c] + Bc7Weights[p] * endpoints[1][c] + 32) >> 6;
+            }
+        }
+
+        int indices[16];
+        float error = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            float bestError = FLT_MAX;
+            for (int p = 0; p < 16; ++p)
+            {
+                float d = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    const float diff = points[i][c] - float(palette[p][c]);
+                    d += diff * diff;
+                }
+                if (d < bestError)
+                {
+                    bestError = d;
+                    best = p;
+                }
+            }
+            indices[i] = best;
+            error += bestError;
+            t[i] = float(Bc7Weights[best]) / 64.0f;
+        }
+
+        //The anchor index is stored without its top bit, so it must be below 8
+        if (indices[0] >= 8)
+        {
+            std::swap(q[0], q[1]);
+            std::swap(pBits[0], pBits[1]);
+            for (int i = 0; i < 16; ++i)
+            {
+                indices[i] = 15 - indices[i];
+            }
+        }
+
+        memset(block, 0, 16);
+        BitWriter writer{ block };
+        writer.write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.write(uint32_t(q[0][c]), 7);
+            writer.write(uint32_t(q[1][c]), 7);
+        }
+        writer.write(uint32_t(pBits[0]), 1);
+        writer.write(uint32_t(pBits[1]), 1);
+        writer.write(uint32_t(indices[0]), 3);
+        for (int i = 1; i < 16; ++i)
+        {
+            writer.write(uint32_t(indices[i]), 4);
+        }
+        return error;
+    }
+
+    //16 RGBA8 texels of block (x, y), edge texels repeated past the level border
+    void gatherBlock(const uint8_t* level, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t texels[64])
+    {
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+                memcpy(texels + (y * 4 + x) * 4, level + (size_t(sourceY) * width + sourceX) * 4, 4);
+            }
+        }
+    }
+
+    void encodeBlock(TextureFormat format, const uint8_t texels[64], uint8_t* block)
+    {
+        uint8_t channel[16];
+        switch (format)
+        {
+        case TextureFormat::BC1:
+        case TextureFormat::BC1Srgb:
+            TextureCompressor::encodeBC1(texels, block);
+            break;
+        case TextureFormat::BC3:
+        case TextureFormat::BC3Srgb:
+            for (int i = 0; i < 16; ++i)
+            {
+                channel[i] = texels[i * 4 + 3];
+            }
+            TextureCompressor::encodeBC4(channel, block);
+            TextureCompressor::encodeBC1(texels, block + 8);
+            break;
+        case TextureFormat::BC5:
+            for (int c = 0; c < 2; ++c)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    channel[i] = texels[i * 4 + c];
+                }
+                TextureCompressor::encodeBC4(channel, block + c * 8);
+            }
+            break;
+        case TextureFormat::BC7:
+        case TextureFormat::BC7Srgb:
+            TextureCompressor::encodeBC7(texels, block);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+TextureFormat TextureCompressor::selectFormat(TextureRole role, bool hasAlpha)
+{
+    switch (role)
+    {
+    case TextureRole::Normal:
+        return TextureFormat::BC5;
+    case TextureRole::OcclusionRoughnessMetallic:
+        return TextureFormat::BC7;
+    default:
+        return hasAlpha ? TextureFormat::BC3Srgb : TextureFormat::BC1Srgb;
+    }
+}
+
+bool TextureCompressor::canCompress(uint32_t width, uint32_t height)
+{
+    return width % 4 == 0 && height % 4 == 0;
+}
+
+uint32_t TextureCompressor::getBlockSize(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1:
+    case TextureFormat::BC1Srgb:
+        return 8;
+    case TextureFormat::BC3:
+    case TextureFormat::BC3Srgb:
+    case TextureFormat::BC5:
+    case TextureFormat::BC7:
+    case TextureFormat::BC7Srgb:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+void TextureCompressor::compress(ImportedTexture& texture, TextureFormat format)
+{
+    const uint32_t blockSize = getBlockSize(format);
+    if (blockSize == 0)
+    {
+        throw std::runtime_error("Not a block compressed format");
+    }
+
+    std::vector<TextureLevel> levels;
+    uint32_t offset = 0;
+    for (const auto& source : texture.levels)
+    {
+        TextureLevel level;
+        level.width = source.width;
+        level.height = source.height;
+        level.rowPitch = (source.width + 3) / 4 * blockSize;
+        level.size = level.rowPitch * ((source.height + 3) / 4);
+        level.offset = offset;
+        offset += level.size;
+        levels.push_back(level);
+    }
+
+    std::vector<uint8_t> data(offset);
+    auto& pool = ThreadPool::getInstance();
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        const auto& source = texture.levels[i];
+        const auto& level = levels[i];
+        const uint8_t* texels = texture.data.data() + source.offset;
+        uint8_t* blocks = data.data() + level.offset;
+        const uint32_t blocksWide = (level.width + 3) / 4;
+        const uint32_t blockCount = blocksWide * ((level.height + 3) / 4);
+        pool.parallelFor(blockCount, BlocksPerTask, [&](size_t begin, size_t end) {
+            uint8_t block[64];
+            for (size_t b = begin; b < end; ++b)
+            {
+                gatherBlock(texels, level.width, level.height, uint32_t(b % blocksWide), uint32_t(b / blocksWide), block);
+                encodeBlock(format, block, blocks + b * blockSize);
+            }
+        });
+    }
+
+    texture.format = format;
+    texture.levels = std::move(levels);
+    texture.data = std::move(data);
+}
+
+void TextureCompressor::encodeBC1(const uint8_t texels[64], uint8_t block[8])
+{
+    float points[16][3];
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            points[i][c] = float(texels[i * 4 + c]);
+        }
+    }
+    float e0[3];
+    float e1[3];
+    fitEndpoints<3>(points, e0, e1);
+    float t[16];
+    float error = encodeBC1Endpoints(points, e0, e1, block, t);
+
+    //One least squares pass on the chosen indices, kept only if it helps
+    float c0[3];
+    float c1[3];
+    unpackColor565(uint16_t(block[0] | (block[1] << 8)), c0);
+    unpackColor565(uint16_t(block[2] | (block[3] << 8)), c1);
+    if (error > 0.0f && refineEndpoints<3>(points, t, c0, c1))
+    {
+        uint8_t refined[8];
+        if (encodeBC1Endpoints(points, c0, c1, refined, t) < error)
+        {
+            memcpy(block, refined, sizeof(refined));
+        }
+    }
+}
+
+void TextureCompressor::encodeBC4(const uint8_t values[16], uint8_t block[8])
+{
+    const uint8_t maximum = *std::max_element(values, values + 16);
+    const uint8_t minimum = *std::min_element(values, values + 16);
+    memset(block, 0, 8);
+    block[0] = maximum;
+    block[1] = minimum;
+    if (maximum == minimum)
+    {
+        return;
+    }
+
+    //Eight value mode (a0 > a1): index 0 is a0, 1 is a1, 2..7 step from a0 to a1
+    uint64_t indices = 0;
+    const float range = float(maximum - minimum);
+    for (int i = 0; i < 16; ++i)
+    {
+        const int step = int((float(values[i] - minimum) / range) * 7.0f + 0.5f);
+        const uint64_t index = step == 7 ? 0 : step == 0 ? 1 : uint64_t(8 - step);
+        indices |= index << (i * 3);
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+        block[2 + i] = uint8_t(indices >> (i * 8));
+    }
+}
+
+void TextureCompressor::encodeBC7(const uint8_t texels[64], uint8_t block[16])
+{
+    float points[16][4];
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            points[i][c] = float(texels[i * 4 + c]);
+        }
+    }
+    float e0[4];
+    float e1[4];
+    fitEndpoints<4>(points, e0, e1);
+    float t[16];
+    float error = encodeBC7Endpoints(points, e0, e1, block, t);
+
+    //Refine against the unswapped endpoints the factors were measured for
+    if (error > 0.0f && refineEndpoints<4>(points, t, e0, e1))
+    {
+        uint8_t refined[16];
+        if (encodeBC7Endpoints(points, e0, e1, refined, t) < error)
+        {
+            memcpy(block, refined, sizeof(refined));
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include "ModelData.h"
+
+//CPU block compression of cooked textures. Blocks are encoded independently,
+//so every level is split across the thread pool.
+class TextureCompressor
+{
+public:
+    //BC1 for opaque base color, BC3 when it has alpha, BC5 for the two stored
+    //normal components and BC7 for the uncorrelated ORM channels
+    static TextureFormat selectFormat(TextureRole role, bool hasAlpha);
+
+    //Block formats need the top level in whole 4x4 blocks
+    static bool canCompress(uint32_t width, uint32_t height);
+
+    //Bytes per 4x4 block, 0 for uncompressed formats
+    static uint32_t getBlockSize(TextureFormat format);
+
+    //Replace the RGBA8 levels of texture with blocks of format
+    static void compress(ImportedTexture& texture, TextureFormat format);
+
+    //Single block encoders; texels are the 16 RGBA8 values of a block row by row
+    static void encodeBC1(const uint8_t texels[64], uint8_t block[8]);
+    //One channel: 16 values
+    static void encodeBC4(const uint8_t values[16], uint8_t block[8]);
+    //Mode 6: one subset, 7-bit RGBA endpoints with p-bits, 4-bit indices
+    static void encodeBC7(const uint8_t texels[64], uint8_t block[16]);
+};
@@ -0,0 +1,71 @@
+#include "TextureStreamer.h"
+#include "Log.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+
+TextureStreamer::~TextureStreamer()
+{
+    //Tasks push into this queue, so none may outlive it
+    for (auto& task : m_pending)
+    {
+        task.wait();
+    }
+}
+
+void TextureStreamer::requestModel(const std::string& path, std::shared_ptr<const CookedModel> model, const ImportSettings& settings)
+{
+    const auto& sources = model->getTextureSources();
+    for (size_t index = 0; index < sources.size(); ++index)
+    {
+        //Base color is the only material input the shaders bind so far
+        if (sources[index].role != TextureRole::BaseColor)
+        {
+            continue;
+        }
+        auto task = ThreadPool::getInstance().submit([this, path, model, index, settings]()
+        {
+            try
+            {
+                auto cooked = ModelCache::loadTexture(path, model, index, settings);
+                const auto* texture = &cooked->getTexture();
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_ready.push_back({ path, std::move(cooked), texture });
+            }
+            catch (const std::exception& e)
+            {
+                //The materials keep the fallback texture
+                char line[256];
+                snprintf(line, sizeof(line), "%s: image %u: %s", path.c_str(), model->getTextureSources()[index].imageIndex, e.what());
+                logMessage(line);
+            }
+        });
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(std::move(task));
+    }
+}
+
+std::vector<StreamedTexture> TextureStreamer::takeReady(size_t maxBytes)
+{
+    std::vector<StreamedTexture> batch;
+    size_t bytes = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [](const std::future<void>& task)
+    {
+        return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), m_pending.end());
+    while (!m_ready.empty())
+    {
+        const size_t size = m_ready.front().texture->dataSize;
+        if (!batch.empty() && bytes + size > maxBytes)
+        {
+            break;
+        }
+        bytes += size;
+        batch.push_back(std::move(m_ready.front()));
+        m_ready.pop_front();
+    }
+    return batch;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ModelCache.h"
+
+//Cooked texture waiting for upload; holding it keeps its levels mapped
+struct StreamedTexture
+{
+    //Canonical path of the model the materials belong to
+    std::string path;
+    std::shared_ptr<const CookedTexture> cooked;
+    const CookedModel::Texture* texture = nullptr;
+};
+
+//Queue between texture cooking and the renderer upload batches. Model loads
+//only list the images; each one is decoded, mipmapped and compressed (or mapped
+//from its cache file) in its own thread pool task and queued here when done.
+//The renderer takes a bounded batch per frame, so neither startup nor the frame
+//loop blocks on textures.
+class TextureStreamer
+{
+public:
+    ~TextureStreamer();
+
+    //Cook the textures of a loaded model the renderer binds, callable from any thread
+    void requestModel(const std::string& path, std::shared_ptr<const CookedModel> model, const ImportSettings& settings);
+
+    //Queued textures totalling at most maxBytes of level data; always at least
+    //one when any is queued, so a single large texture cannot block the queue
+    std::vector<StreamedTexture> takeReady(size_t maxBytes);
+
+private:
+    std::mutex m_mutex;
+    std::deque<StreamedTexture> m_ready;
+    std::vector<std::future<void>> m_pending;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads consuming a shared task queue. Used for loading
+//and cooking in the background; per frame work runs on the JobSystem.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    //Process wide pool sized to the hardware thread count
+    static ThreadPool& getInstance();
+
+    //Queue a task, the returned future rethrows any exception from the task
+    template<class F>
+    auto submit(F&& func) -> std::future<decltype(func())>
+    {
+        using Result = decltype(func());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace([task]() { (*task)(); });
+        }
+        m_condition.notify_one();
+        return future;
+    }
+
+    //Run func(begin, end) over [0, count) in chunks on the workers and the
+    //calling thread. Safe to call from a task: the caller only waits for chunks
+    //another thread is already running, never for tasks still in the queue.
+    //func must not throw.
+    template<class F>
+    void parallelFor(size_t count, size_t chunkSize, const F& func)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        chunkSize = chunkSize == 0 ? 1 : chunkSize;
+        struct State
+        {
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> done{ 0 };
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        //Helpers that start after the last chunk was taken only touch the state
+        auto state = std::make_shared<State>();
+        const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+        auto run = [state, count, chunkSize, chunkCount, &func]() {
+            for (size_t chunk = state->next.fetch_add(1); chunk < chunkCount; chunk = state->next.fetch_add(1))
+            {
+                const size_t begin = chunk * chunkSize;
+                func(begin, std::min(begin + chunkSize, count));
+                if (state->done.fetch_add(1) + 1 == chunkCount)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            }
+        };
+
+        const size_t helpers = std::min(chunkCount - 1, m_workers.size());
+        if (helpers > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (size_t i = 0; i < helpers; ++i)
+                {
+                    m_tasks.emplace(run);
+                }
+            }
+            m_condition.notify_all();
+        }
+        run();
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&]() { return state->done.load() == chunkCount; });
+    }
+
+    size_t getThreadCount() const { return m_workers.size(); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+};
@@ -0,0 +1,450 @@
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <stdexcept>
+#include "JobSystem.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TRANSFORM_HIERARCHY_SSE2 1
+#endif
+
+namespace
+{
+    //Levels with fewer dirty nodes are not worth waking the workers for
+    constexpr size_t ParallelThreshold = 2048;
+    //Multiple of the SIMD batch width
+    constexpr size_t ParallelChunkSize = 512;
+
+    const float Identity[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f,
+    };
+
+    JointPose identityPose()
+    {
+        return JointPose{ { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } };
+    }
+
+#if TRANSFORM_HIERARCHY_SSE2
+    //world = parent * (translate * rotate * scale) for four nodes at once. Poses
+    //and parent matrices are transposed so each lane holds one node, every
+    //matrix element is then one vector expression.
+    void composeWorld4(const JointPose* const local[4], const float* const parent[4], float* const world[4])
+    {
+        __m128 tx = _mm_loadu_ps(local[0]->translation), ty = _mm_loadu_ps(local[1]->translation);
+        __m128 tz = _mm_loadu_ps(local[2]->translation), tw = _mm_loadu_ps(local[3]->translation);
+        _MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+        __m128 qx = _mm_loadu_ps(local[0]->rotation), qy = _mm_loadu_ps(local[1]->rotation);
+        __m128 qz = _mm_loadu_ps(local[2]->rotation), qw = _mm_loadu_ps(local[3]->rotation);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+        __m128 sx = _mm_loadu_ps(local[0]->scale), sy = _mm_loadu_ps(local[1]->scale);
+        __m128 sz = _mm_loadu_ps(local[2]->scale), sw = _mm_loadu_ps(local[3]->scale);
+        _MM_TRANSPOSE4_PS(sx, sy, sz, sw);
+
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        const __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+        //l[column][row] of the local rotation-scale block
+        __m128 l[3][3];
+        l[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        l[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        l[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        l[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        l[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        l[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        l[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        l[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        l[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+        //p[column][row] of the parent matrices
+        __m128 p[4][4];
+        for (int c = 0; c < 4; ++c)
+        {
+            p[c][0] = _mm_loadu_ps(parent[0] + c * 4);
+            p[c][1] = _mm_loadu_ps(parent[1] + c * 4);
+            p[c][2] = _mm_loadu_ps(parent[2] + c * 4);
+            p[c][3] = _mm_loadu_ps(parent[3] + c * 4);
+            _MM_TRANSPOSE4_PS(p[c][0], p[c][1], p[c][2], p[c][3]);
+        }
+
+        for (int c = 0; c < 4; ++c)
+        {
+            __m128 column[4];
+            for (int r = 0; r < 4; ++r)
+            {
+                if (c < 3)
+                {
+                    column[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p[0][r], l[c][0]), _mm_mul_ps(p[1][r], l[c][1])), _mm_mul_ps(p[2][r], l[c][2]));
+                }
+                else
+                {
+                    column[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p[0][r], tx), _mm_mul_ps(p[1][r], ty)),
+                        _mm_add_ps(_mm_mul_ps(p[2][r], tz), p[3][r]));
+                }
+            }
+            _MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+            _mm_storeu_ps(world[0] + c * 4, column[0]);
+            _mm_storeu_ps(world[1] + c * 4, column[1]);
+            _mm_storeu_ps(world[2] + c * 4, column[2]);
+            _mm_storeu_ps(world[3] + c * 4, column[3]);
+        }
+    }
+#else
+    //Scale, then rotate, then translate
+    void composeMatrix(const JointPose& pose, float m[16])
+    {
+        const float x = pose.rotation[0], y = pose.rotation[1], z = pose.rotation[2], w = pose.rotation[3];
+        const float sx = pose.scale[0], sy = pose.scale[1], sz = pose.scale[2];
+        m[0] = (1.0f - 2.0f * (y * y + z * z)) * sx;
+        m[1] = 2.0f * (x * y + w * z) * sx;
+        m[2] = 2.0f * (x * z - w * y) * sx;
+        m[3] = 0.0f;
+        m[4] = 2.0f * (x * y - w * z) * sy;
+        m[5] = (1.0f - 2.0f * (x * x + z * z)) * sy;
+        m[6] = 2.0f * (y * z + w * x) * sy;
+        m[7] = 0.0f;
+        m[8] = 2.0f * (x * z + w * y) * sz;
+        m[9] = 2.0f * (y * z - w * x) * sz;
+        m[10] = (1.0f - 2.0f * (x * x + y * y)) * sz;
+        m[11] = 0.0f;
+        m[12] = pose.translation[0];
+        m[13] = pose.translation[1];
+        m[14] = pose.translation[2];
+        m[15] = 1.0f;
+    }
+#endif
+
+    //World matrices of slots, whose parents are already final
+    void computeWorld(const uint32_t* slots, size_t count, const JointPose* local, const uint32_t* parentSlots, float* world)
+    {
+        auto parentMatrix = [&](uint32_t slot) -> const float* {
+            const uint32_t parent = parentSlots[slot];
+            return parent == UINT32_MAX ? Identity : world + size_t(parent) * 16;
+        };
+#if TRANSFORM_HIERARCHY_SSE2
+        for (size_t i = 0; i < count; i += 4)
+        {
+            const JointPose* locals[4];
+            const float* parents[4];
+            float* results[4];
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+                //The tail repeats its last node, writing the same result twice
+                const uint32_t slot = slots[std::min(i + lane, count - 1)];
+                locals[lane] = local + slot;
+                parents[lane] = parentMatrix(slot);
+                results[lane] = world + size_t(slot) * 16;
+            }
+            composeWorld4(locals, parents, results);
+        }
+#else
+        float matrix[16];
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t slot = slots[i];
+            composeMatrix(local[slot], matrix);
+            const float* a = parentMatrix(slot);
+            float* result = world + size_t(slot) * 16;
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int r = 0; r < 4; ++r)
+                {
+                    result[c * 4 + r] = a[r] * matrix[c * 4] + a[4 + r] * matrix[c * 4 + 1] + a[8 + r] * matrix[c * 4 + 2] + a[12 + r] * matrix[c * 4 + 3];
+                }
+            }
+        }
+#endif
+    }
+}
+
+TransformNode TransformHierarchy::create(TransformNode parent)
+{
+    const uint32_t parentSlot = parent.isValid() ? getSlot(parent) : Invalid;
+    uint32_t id;
+    if (!m_freeNodes.empty())
+    {
+        id = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    else
+    {
+        id = uint32_t(m_nodeSlots.size());
+        m_nodeSlots.push_back(Invalid);
+    }
+    const uint32_t slot = uint32_t(m_local.size());
+    const uint32_t depth = parentSlot == Invalid ? 0 : m_depths[parentSlot] + 1;
+    //Appending keeps the order unless a shallower node follows deeper ones
+    if (!m_depths.empty() && depth < m_depths.back())
+    {
+        m_orderChanged = true;
+    }
+    m_local.push_back(identityPose());
+    m_world.insert(m_world.end(), Identity, Identity + 16);
+    m_parentSlots.push_back(parentSlot);
+    m_depths.push_back(depth);
+    m_dirty.push_back(1);
+    m_slotNodes.push_back(id);
+    m_nodeSlots[id] = slot;
+    m_anyDirty = true;
+    ++m_nodeCount;
+    return TransformNode{ id };
+}
+
+void TransformHierarchy::destroy(TransformNode node)
+{
+    if (!isAlive(node))
+    {
+        return;
+    }
+    //The slot is dropped and its children detached by the next sort
+    const uint32_t slot = m_nodeSlots[node.id];
+    m_slotNodes[slot] = Invalid;
+    m_nodeSlots[node.id] = Invalid;
+    m_freeNodes.push_back(node.id);
+    --m_nodeCount;
+    m_orderChanged = true;
+}
+
+bool TransformHierarchy::isAlive(TransformNode node) const
+{
+    return node.id < m_nodeSlots.size() && m_nodeSlots[node.id] != Invalid;
+}
+
+uint32_t TransformHierarchy::getSlot(TransformNode node) const
+{
+    if (!isAlive(node))
+    {
+        throw std::runtime_error("Transform node was destroyed");
+    }
+    return m_nodeSlots[node.id];
+}
+
+void TransformHierarchy::markDirty(uint32_t slot)
+{
+    m_dirty[slot] = 1;
+    //Systems setting poses of different nodes may get here at the same time
+    m_anyDirty.store(true, std::memory_order_relaxed);
+}
+
+void TransformHierarchy::setParent(TransformNode node, TransformNode parent)
+{
+    const uint32_t slot = getSlot(node);
+    const uint32_t parentSlot = parent.isValid() ? getSlot(parent) : Invalid;
+    //Walk up from the new parent; destroyed slots end the chain, their children become roots
+    for (uint32_t ancestor = parentSlot; ancestor != Invalid && m_slotNodes[ancestor] != Invalid; ancestor = m_parentSlots[ancestor])
+    {
+        if (ancestor == slot)
+        {
+            throw std::runtime_error("Transform node cannot be parented to its own subtree");
+        }
+    }
+    m_parentSlots[slot] = parentSlot;
+    markDirty(slot);
+    m_orderChanged = true;
+}
+
+TransformNode TransformHierarchy::getParent(TransformNode node) const
+{
+    const uint32_t parentSlot = m_parentSlots[getSlot(node)];
+    return parentSlot == Invalid ? TransformNode{} : TransformNode{ m_slotNodes[parentSlot] };
+}
+
+const JointPose& TransformHierarchy::getLocal(TransformNode node) const
+{
+    return m_local[getSlot(node)];
+}
+
+void TransformHierarchy::setLocal(TransformNode node, const JointPose& pose)
+{
+    const uint32_t slot = getSlot(node);
+    m_local[slot] = pose;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setTranslation(TransformNode node, float x, float y, float z)
+{
+    const uint32_t slot = getSlot(node);
+    float* translation = m_local[slot].translation;
+    translation[0] = x;
+    translation[1] = y;
+    translation[2] = z;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setRotation(TransformNode node, float x, float y, float z, float w)
+{
+    const uint32_t slot = getSlot(node);
+    float* rotation = m_local[slot].rotation;
+    rotation[0] = x;
+    rotation[1] = y;
+    rotation[2] = z;
+    rotation[3] = w;
+    markDirty(slot);
+}
+
+void TransformHierarchy::setScale(TransformNode node, float x, float y, float z)
+{
+    const uint32_t slot = getSlot(node);
+    float* scale = m_local[slot].scale;
+    scale[0] = x;
+    scale[1] = y;
+    scale[2] = z;
+    markDirty(slot);
+}
+
+const float* TransformHierarchy::getWorldMatrix(TransformNode node) const
+{
+    return m_world.data() + size_t(getSlot(node)) * 16;
+}
+
+void TransformHierarchy::sortByDepth()
+{
+    const size_t slotCount = m_local.size();
+    //Depth of every live slot; setParent may have put parents after children,
+    //so each chain is walked up to the first slot with a known depth
+    std::vector<uint32_t> depths(slotCount, Invalid);
+    std::vector<uint32_t> chain;
+    uint32_t maxDepth = 0;
+    for (uint32_t slot = 0; slot < slotCount; ++slot)
+    {
+        if (m_slotNodes[slot] == Invalid)
+        {
+            continue;
+        }
+        chain.clear();
+        uint32_t current = slot;
+        while (current != Invalid && depths[current] == Invalid)
+        {
+            chain.push_back(current);
+            uint32_t parent = m_parentSlots[current];
+            if (parent != Invalid && m_slotNodes[parent] == Invalid)
+            {
+                //Parent was destroyed, the subtree keeps its local pose as a root
+                m_parentSlots[current] = Invalid;
+                m_dirty[current] = 1;
+                parent = Invalid;
+            }
+            current = parent;
+        }
+        uint32_t depth = current == Invalid ? 0 : depths[current] + 1;
+        for (size_t i = chain.size(); i-- > 0; ++depth)
+        {
+            depths[chain[i]] = depth;
+        }
+        maxDepth = std::max(maxDepth, depth - 1);
+    }
+
+    //Counting sort by depth, stable so siblings keep their relative order
+    std::vector<uint32_t> levelStarts(size_t(maxDepth) + 2, 0);
+    for (uint32_t slot = 0; slot < slotCount; ++slot)
+    {
+        if (depths[slot] != Invalid)
+        {
+            ++levelStarts[depths[slot] + 1];
+        }
+    }
+    for (size_t level = 1; level < levelStarts.size(); ++level)
+    {
+        levelStarts[level] += levelStarts[level - 1];
+    }
+    std::vector<uint32_t> newSlots(slotCount, Invalid);
+    for (uint32_t slot = 0; slot < slotCount; ++slot)
+    {
+        if (depths[slot] != Invalid)
+        {
+            newSlots[slot] = levelStarts[depths[slot]]++;
+        }
+    }
+
+    const size_t liveCount = m_nodeCount;
+    std::vector<JointPose> local(liveCount);
+    std::vector<float> world(liveCount * 16);
+    std::vector<uint32_t> parentSlots(liveCount);
+    std::vector<uint32_t> sortedDepths(liveCount);
+    std::vector<uint8_t> dirty(liveCount);
+    std::vector<uint32_t> slotNodes(liveCount);
+    for (uint32_t slot = 0; slot < slotCount; ++slot)
+    {
+        const uint32_t target = newSlots[slot];
+        if (target == Invalid)
+        {
+            continue;
+        }
+        local[target] = m_local[slot];
+        std::copy_n(m_world.data() + size_t(slot) * 16, 16, world.data() + size_t(target) * 16);
+        const uint32_t parent = m_parentSlots[slot];
+        parentSlots[target] = parent == Invalid ? Invalid : newSlots[parent];
+        sortedDepths[target] = depths[slot];
+        dirty[target] = m_dirty[slot];
+        slotNodes[target] = m_slotNodes[slot];
+        m_nodeSlots[m_slotNodes[slot]] = target;
+        m_anyDirty = m_anyDirty || dirty[target] != 0;
+    }
+    m_local = std::move(local);
+    m_world = std::move(world);
+    m_parentSlots = std::move(parentSlots);
+    m_depths = std::move(sortedDepths);
+    m_dirty = std::move(dirty);
+    m_slotNodes = std::move(slotNodes);
+    m_orderChanged = false;
+}
+
+size_t TransformHierarchy::update()
+{
+    if (m_orderChanged)
+    {
+        sortByDepth();
+    }
+    if (!m_anyDirty)
+    {
+        return 0;
+    }
+
+    //Parents precede children, one pass pushes dirty flags down every subtree.
+    //Dirty slots are gathered level by level since a level needs its parents final.
+    m_dirtySlots.clear();
+    m_levelOffsets.clear();
+    const uint32_t slotCount = uint32_t(m_local.size());
+    for (uint32_t slot = 0; slot < slotCount; ++slot)
+    {
+        const uint32_t parent = m_parentSlots[slot];
+        if (parent != Invalid && m_dirty[parent])
+        {
+            m_dirty[slot] = 1;
+        }
+        if (!m_dirty[slot])
+        {
+            continue;
+        }
+        if (m_dirtySlots.empty() || m_depths[m_dirtySlots.back()] != m_depths[slot])
+        {
+            m_levelOffsets.push_back(uint32_t(m_dirtySlots.size()));
+        }
+        m_dirtySlots.push_back(slot);
+    }
+    m_levelOffsets.push_back(uint32_t(m_dirtySlots.size()));
+
+    for (size_t level = 0; level + 1 < m_levelOffsets.size(); ++level)
+    {
+        const uint32_t* slots = m_dirtySlots.data() + m_levelOffsets[level];
+        const size_t count = m_levelOffsets[level + 1] - m_levelOffsets[level];
+        if (count >= ParallelThreshold)
+        {
+            JobSystem::getInstance().parallelFor(count, ParallelChunkSize, [&](size_t begin, size_t end) {
+                computeWorld(slots + begin, end - begin, m_local.data(), m_parentSlots.data(), m_world.data());
+            });
+        }
+        else
+        {
+            computeWorld(slots, count, m_local.data(), m_parentSlots.data(), m_world.data());
+        }
+    }
+
+    std::fill(m_dirty.begin(), m_dirty.end(), uint8_t(0));
+    m_anyDirty = false;
+    return m_dirtySlots.size();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+//Handle to a transform node, stays valid while the node lives
+struct TransformNode
+{
+    uint32_t id = UINT32_MAX;
+
+    bool isValid() const { return id != UINT32_MAX; }
+    bool operator==(const TransformNode& other) const { return id == other.id; }
+    bool operator!=(const TransformNode& other) const { return id != other.id; }
+};
+
+//Parent/child transforms of a scene. Nodes are stored in arrays sorted by depth,
+//so every level follows its parents and is computed in one batch. Only nodes
+//changed since the last update and their descendants are recomputed, four at a
+//time with SIMD, large levels split across the JobSystem.
+//World matrices are column-major 4x4 (16 floats), like the skinning matrices.
+//Poses of different nodes may be set concurrently; everything else must not
+//overlap other calls.
+class TransformHierarchy
+{
+public:
+    //Node at the identity pose, a root when parent is invalid
+    TransformNode create(TransformNode parent = TransformNode{});
+    //Children of node become roots with their local pose as world pose
+    void destroy(TransformNode node);
+    bool isAlive(TransformNode node) const;
+    size_t getNodeCount() const { return m_nodeCount; }
+
+    //Throws std::runtime_error when parent is node itself or one of its descendants
+    void setParent(TransformNode node, TransformNode parent);
+    TransformNode getParent(TransformNode node) const;
+
+    //Pose relative to the parent
+    const JointPose& getLocal(TransformNode node) const;
+    void setLocal(TransformNode node, const JointPose& pose);
+    void setTranslation(TransformNode node, float x, float y, float z);
+    //Unit quaternion x, y, z, w
+    void setRotation(TransformNode node, float x, float y, float z, float w);
+    void setScale(TransformNode node, float x, float y, float z);
+
+    //Recompute the world matrices of changed subtrees; returns the number of
+    //nodes recomputed
+    size_t update();
+    //World matrix as of the last update
+    const float* getWorldMatrix(TransformNode node) const;
+
+private:
+    static constexpr uint32_t Invalid = UINT32_MAX;
+
+    uint32_t getSlot(TransformNode node) const;
+    void markDirty(uint32_t slot);
+    //Restore depth order after topology changes and drop destroyed slots
+    void sortByDepth();
+
+    //Per slot, in depth order
+    std::vector<JointPose> m_local;
+    //16 floats per slot
+    std::vector<float> m_world;
+    std::vector<uint32_t> m_parentSlots;
+    std::vector<uint32_t> m_depths;
+    std::vector<uint8_t> m_dirty;
+    //Node id of every slot, Invalid for destroyed slots awaiting the next sort
+    std::vector<uint32_t> m_slotNodes;
+
+    //Slot of every node id, Invalid for free ids
+    std::vector<uint32_t> m_nodeSlots;
+    std::vector<uint32_t> m_freeNodes;
+    size_t m_nodeCount = 0;
+    bool m_orderChanged = false;
+    std::atomic<bool> m_anyDirty{ false };
+
+    //Scratch of update, kept to avoid reallocating every frame
+    std::vector<uint32_t> m_dirtySlots;
+    std::vector<uint32_t> m_levelOffsets;
+};
@@ -0,0 +1,232 @@
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr float UnormMax = 65535.0f;
+    constexpr float SnormMax = 32767.0f;
+
+    float signNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    float snormToFloat(int16_t value)
+    {
+        return std::max(float(value) / SnormMax, -1.0f);
+    }
+
+    void normalize(float v[3])
+    {
+        float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0f)
+        {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    //Angle cosine between a source direction and its decode, 1 when the source is degenerate
+    float getDecodeDot(const float source[3], const float decoded[3])
+    {
+        float unit[3] = { source[0], source[1], source[2] };
+        normalize(unit);
+        if (unit[0] == 0.0f && unit[1] == 0.0f && unit[2] == 0.0f)
+        {
+            return 1.0f;
+        }
+        return unit[0] * decoded[0] + unit[1] * decoded[1] + unit[2] * decoded[2];
+    }
+
+    float toDegrees(float cosine)
+    {
+        return std::acos(std::clamp(cosine, -1.0f, 1.0f)) * 180.0f / 3.14159265358979f;
+    }
+}
+
+void VertexQuantizer::encodeNormal(const float normal[3], int16_t encoded[2])
+{
+    float n[3] = { normal[0], normal[1], normal[2] };
+    normalize(n);
+    float l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+    if (l1 == 0.0f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+
+    //Project onto the octahedron and fold the lower hemisphere
+    float u = n[0] / l1;
+    float v = n[1] / l1;
+    if (n[2] < 0.0f)
+    {
+        float foldedU = (1.0f - std::fabs(v)) * signNotZero(u);
+        float foldedV = (1.0f - std::fabs(u)) * signNotZero(v);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    //Plain rounding is off by up to one step, pick the best floor/ceil neighbour
+    float baseU = std::floor(std::clamp(u, -1.0f, 1.0f) * SnormMax);
+    float baseV = std::floor(std::clamp(v, -1.0f, 1.0f) * SnormMax);
+    float bestDot = -FLT_MAX;
+    for (int i = 0; i < 4; ++i)
+    {
+        int16_t candidate[2] = {
+            int16_t(std::min(baseU + float(i & 1), SnormMax)),
+            int16_t(std::min(baseV + float(i >> 1), SnormMax)),
+        };
+        float decoded[3];
+        decodeNormal(candidate, decoded);
+        float dot = decoded[0] * n[0] + decoded[1] * n[1] + decoded[2] * n[2];
+        if (dot > bestDot)
+        {
+            bestDot = dot;
+            encoded[0] = candidate[0];
+            encoded[1] = candidate[1];
+        }
+    }
+}
+
+void VertexQuantizer::decodeNormal(const int16_t encoded[2], float normal[3])
+{
+    float x = snormToFloat(encoded[0]);
+    float y = snormToFloat(encoded[1]);
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    float t = std::max(-z, 0.0f);
+    normal[0] = x + (x >= 0.0f ? -t : t);
+    normal[1] = y + (y >= 0.0f ? -t : t);
+    normal[2] = z;
+    normalize(normal);
+}
+
+QuantizationError VertexQuantizer::quantize(const std::vector<ModelVertex>& vertices, std::vector<QuantizedVertex>& quantized, PositionDequantization& dequantization)
+{
+    QuantizationError error;
+    quantized.resize(vertices.size());
+    dequantization = PositionDequantization();
+    if (vertices.empty())
+    {
+        return error;
+    }
+
+    float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (const auto& vertex : vertices)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = std::min(minimum[axis], vertex.Pos[axis]);
+            maximum[axis] = std::max(maximum[axis], vertex.Pos[axis]);
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        dequantization.offset[axis] = minimum[axis];
+        dequantization.scale[axis] = maximum[axis] - minimum[axis];
+        error.extent = std::max(error.extent, dequantization.scale[axis]);
+    }
+
+    double positionErrorSum = 0.0;
+    float minNormalDot = 1.0f;
+    float minTangentDot = 1.0f;
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        const auto& vertex = vertices[i];
+        auto& packed = quantized[i];
+
+        float distanceSquared = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float scale = dequantization.scale[axis];
+            float unorm = scale > 0.0f ? (vertex.Pos[axis] - dequantization.offset[axis]) / scale : 0.0f;
+            packed.Pos[axis] = uint16_t(std::clamp(unorm, 0.0f, 1.0f) * UnormMax + 0.5f);
+
+            float decoded = dequantization.offset[axis] + float(packed.Pos[axis]) / UnormMax * scale;
+            float delta = decoded - vertex.Pos[axis];
+            distanceSquared += delta * delta;
+        }
+        packed.Pos[3] = vertex.Tangent[3] < 0.0f ? 0 : uint16_t(UnormMax);
+        float distance = std::sqrt(distanceSquared);
+        error.maxPositionError = std::max(error.maxPositionError, distance);
+        positionErrorSum += distance;
+
+        //Degenerate source directions carry nothing to lose
+        float decoded[3];
+        encodeNormal(vertex.Normal, packed.Normal);
+        decodeNormal(packed.Normal, decoded);
+        minNormalDot = std::min(minNormalDot, getDecodeDot(vertex.Normal, decoded));
+        encodeNormal(vertex.Tangent, packed.Tangent);
+        decodeNormal(packed.Tangent, decoded);
+        minTangentDot = std::min(minTangentDot, getDecodeDot(vertex.Tangent, decoded));
+
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            packed.UV[axis] = encodeHalf(vertex.UV[axis]);
+            error.maxUVError = std::max(error.maxUVError, std::fabs(decodeHalf(packed.UV[axis]) - vertex.UV[axis]));
+        }
+    }
+
+    error.meanPositionError = float(positionErrorSum / double(vertices.size()));
+    error.maxNormalError = toDegrees(minNormalDot);
+    error.maxTangentError = toDegrees(minTangentDot);
+    return error;
+}
+
+uint16_t VertexQuantizer::encodeHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7fffffff;
+    if (magnitude >= 0x7f800000)
+    {
+        //Infinity stays infinity, NaN stays a quiet NaN
+        return sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    if (magnitude >= 0x477ff000)
+    {
+        //65520 and up round past the largest half
+        return sign | 0x7c00;
+    }
+    if (magnitude < 0x38800000)
+    {
+        //Below the smallest normal half: count units of 2^-24
+        float absolute;
+        std::memcpy(&absolute, &magnitude, sizeof(absolute));
+        return sign | uint16_t(std::nearbyint(absolute * 16777216.0f));
+    }
+    //Rebias the exponent from 127 to 15 and round the dropped 13 mantissa bits to even
+    const uint32_t rounded = magnitude + 0xfff + ((magnitude >> 13) & 1);
+    return sign | uint16_t((rounded - 0x38000000) >> 13);
+}
+
+float VertexQuantizer::decodeHalf(uint16_t value)
+{
+    const uint32_t sign = uint32_t(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1f;
+    const uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0)
+    {
+        const float magnitude = std::ldexp(float(mantissa), -24);
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        bits |= sign;
+    }
+    else if (exponent == 31)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ModelData.h"
+
+struct QuantizationError
+{
+    //Model space distance between source and decoded positions
+    float maxPositionError = 0.0f;
+    float meanPositionError = 0.0f;
+    //Largest AABB extent, to put the position error in relation
+    float extent = 0.0f;
+    //Angle between source and decoded normals in degrees
+    float maxNormalError = 0.0f;
+    float maxTangentError = 0.0f;
+    //Largest absolute difference of a decoded UV component
+    float maxUVError = 0.0f;
+};
+
+//Import-time compression of ModelVertex streams to QuantizedVertex
+class VertexQuantizer
+{
+public:
+    //Quantize vertices against their AABB and measure the decode error
+    static QuantizationError quantize(const std::vector<ModelVertex>& vertices, std::vector<QuantizedVertex>& quantized, PositionDequantization& dequantization);
+
+    //Octahedral mapping of a unit vector to 2x16-bit snorm, rounded to the closest decodable normal
+    static void encodeNormal(const float normal[3], int16_t encoded[2]);
+    //Same decode as shaderQuantizedVS.hlsl
+    static void decodeNormal(const int16_t encoded[2], float normal[3]);
+
+    //IEEE half float, round to nearest even; out of range values become infinity
+    static uint16_t encodeHalf(float value);
+    static float decodeHalf(uint16_t value);
+};
@@ -0,0 +1,50 @@
+#include "World.h"
+#include <atomic>
+
+size_t World::nextTypeIndex()
+{
+    static std::atomic<size_t> next{ 0 };
+    return next++;
+}
+
+Entity World::create()
+{
+    uint32_t index;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = uint32_t(m_generations.size());
+        m_generations.push_back(0);
+    }
+    ++m_generations[index];
+    ++m_entityCount;
+    return Entity{ index, m_generations[index] };
+}
+
+void World::destroy(Entity entity)
+{
+    if (!isAlive(entity))
+    {
+        return;
+    }
+    for (auto& pool : m_pools)
+    {
+        if (pool)
+        {
+            pool->remove(entity.index);
+        }
+    }
+    ++m_generations[entity.index];
+    m_freeSlots.push_back(entity.index);
+    --m_entityCount;
+}
+
+bool World::isAlive(Entity entity) const
+{
+    return entity.index < m_generations.size() && m_generations[entity.index] == entity.generation &&
+        (entity.generation & 1) != 0;
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "ComponentPool.h"
+#include "JobSystem.h"
+
+//Entity storage of a scene. Every component type lives in its own sparse set,
+//so systems iterate tightly packed arrays of exactly the data they touch
+//instead of chasing one heap object per entity.
+class World
+{
+public:
+    World() = default;
+    //Teardown hooks refer to the world, it stays in place
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    Entity create();
+    //Drops every component of entity; stale handles are ignored
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+    size_t getEntityCount() const { return m_entityCount; }
+
+    template<class T, class... Args>
+    T& add(Entity entity, Args&&... args)
+    {
+        if (!isAlive(entity))
+        {
+            throw std::runtime_error("Component added to a destroyed entity");
+        }
+        return getPool<T>().emplace(entity.index, std::forward<Args>(args)...);
+    }
+
+    template<class T>
+    void remove(Entity entity)
+    {
+        if (isAlive(entity))
+        {
+            getPool<T>().remove(entity.index);
+        }
+    }
+
+    //nullptr when entity is dead or has no T
+    template<class T>
+    T* find(Entity entity)
+    {
+        return isAlive(entity) ? getPool<T>().find(entity.index) : nullptr;
+    }
+
+    template<class T>
+    T& get(Entity entity)
+    {
+        T* component = find<T>(entity);
+        if (component == nullptr)
+        {
+            throw std::runtime_error("Entity has no such component");
+        }
+        return *component;
+    }
+
+    //func(entity, T&) runs before a T of a live entity is removed, either by
+    //remove, destroy or add replacing it. Components owning data outside the
+    //world release it here. func must not add or remove components.
+    template<class T, class Func>
+    void onRemove(Func func)
+    {
+        getPool<T>().setTeardown([this, func](uint32_t index, T& component)
+        {
+            func(makeEntity(index), component);
+        });
+    }
+
+    template<class T>
+    ComponentPool<T>& getPool()
+    {
+        const size_t type = getTypeIndex<T>();
+        if (type >= m_pools.size())
+        {
+            m_pools.resize(type + 1);
+        }
+        if (!m_pools[type])
+        {
+            m_pools[type] = std::make_unique<ComponentPool<T>>();
+        }
+        return static_cast<ComponentPool<T>&>(*m_pools[type]);
+    }
+
+    //Calls func(entity, First&, Rest&...) for every entity owning all the
+    //components. The smallest pool drives the loop; a single component walks its
+    //array directly. Components must not be added or removed inside func.
+    template<class First, class... Rest, class Func>
+    void each(Func&& func)
+    {
+        if constexpr (sizeof...(Rest) == 0)
+        {
+            ComponentPool<First>& pool = getPool<First>();
+            const std::vector<uint32_t>& entities = pool.getEntities();
+            First* components = pool.data();
+            for (size_t i = 0; i < entities.size(); ++i)
+            {
+                func(makeEntity(entities[i]), components[i]);
+            }
+        }
+        else
+        {
+            ComponentPoolBase* pools[] = { &getPool<First>(), &getPool<Rest>()... };
+            ComponentPoolBase* smallest = pools[0];
+            for (ComponentPoolBase* pool : pools)
+            {
+                if (pool->size() < smallest->size())
+                {
+                    smallest = pool;
+                }
+            }
+            for (uint32_t index : smallest->getEntities())
+            {
+                bool complete = true;
+                for (ComponentPoolBase* pool : pools)
+                {
+                    complete = complete && pool->contains(index);
+                }
+                if (complete)
+                {
+                    func(makeEntity(index), getPool<First>().get(index), getPool<Rest>().get(index)...);
+                }
+            }
+        }
+    }
+
+    //each spread over the JobSystem in chunks of entities. func runs concurrently
+    //and may only touch the components of the entity it is given.
+    template<class First, class... Rest, class Func>
+    void parallelEach(size_t chunkSize, const Func& func)
+    {
+        //Pools are created up front, the workers only look them up
+        ComponentPoolBase* pools[] = { &getPool<First>(), &getPool<Rest>()... };
+        ComponentPoolBase* smallest = pools[0];
+        for (ComponentPoolBase* pool : pools)
+        {
+            if (pool->size() < smallest->size())
+            {
+                smallest = pool;
+            }
+        }
+        const std::vector<uint32_t>& entities = smallest->getEntities();
+        JobSystem::getInstance().parallelFor(entities.size(), chunkSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const uint32_t index = entities[i];
+                bool complete = true;
+                for (ComponentPoolBase* pool : pools)
+                {
+                    complete = complete && pool->contains(index);
+                }
+                if (complete)
+                {
+                    func(makeEntity(index), getPool<First>().get(index), getPool<Rest>().get(index)...);
+                }
+            }
+        });
+    }
+
+    //Dense id of a component type, shared by every world
+    template<class T>
+    static size_t getTypeIndex()
+    {
+        static const size_t index = nextTypeIndex();
+        return index;
+    }
+
+private:
+    static size_t nextTypeIndex();
+
+    Entity makeEntity(uint32_t index) const { return Entity{ index, m_generations[index] }; }
+
+    std::vector<std::unique_ptr<ComponentPoolBase>> m_pools;
+    //Generation per slot, odd while the slot is alive
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_freeSlots;
+    size_t m_entityCount = 0;
+};
@@ -1,14 +1,11 @@
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
-#define STBI_MSC_SECURE_CRT
-#define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#define TINYGLTF_IMPLEMENTATION
 
 #include <Windows.h>
 #include <tchar.h>
 #include <memory>
 #include "Game.h"
+#include "FrameArena.h"
 
 const TCHAR szWindowClass[] = _T("Smash or Shock!");
 const int window_width = 1280;
@@ -107,7 +104,13 @@ int WINAPI WinMain(
             break;
         }
         
+        //Frame boundary: nothing is being recorded, safe to swap reloaded models
+        //and rewind the frame arena; a new high-water mark is logged
+        game->setFrameArenaStats(FrameArena::getInstance().beginFrame());
+        renderer->updateHotReload();
+        renderer->updateTextures();
         game->update();
+        renderer->updateAnimation();
         game->draw();
     }
 
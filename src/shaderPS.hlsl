@@ -2,6 +2,9 @@ struct VSOutput
 {
   float4 Position : SV_POSITION;
   float4 Normal : NORMAL;
+  // xyz in world space, w the bitangent sign
+  float4 Tangent : TANGENT;
+  float2 UV : TEXCOORD;
 };
 
 Texture2D tex : register(t0);
@@ -10,7 +13,9 @@ SamplerState samp : register(s0);
 float4 main(VSOutput In) : SV_TARGET
 {
 	float3 light = normalize(float3(1, -1, 1));
-	float4 color = (dot(-light, In.Normal), 1.0f);
+	float4 baseColor = tex.Sample(samp, In.UV);
+	float diffuse = saturate(dot(-light, normalize(In.Normal.xyz)));
+	float4 color = float4(baseColor.rgb * (0.2f + 0.8f * diffuse), baseColor.a);
 
   return color;
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+struct VSInput
+{
+  float4 Position : POSITION;
+  float2 Normal : NORMAL;
+  float2 Tangent : TANGENT;
+  float2 UV : TEXCOORD;
+};
+struct VSOutput
+{
+  float4 Position : SV_POSITION;
+  float4 Normal : NORMAL;
+  // xyz in world space, w the bitangent sign
+  float4 Tangent : TANGENT;
+  float2 UV : TEXCOORD;
+};
+
+cbuffer ShaderParameter : register(b0)
+{
+  float4x4 world;
+  float4x4 view;
+  float4x4 proj;
+}
+
+// Per mesh AABB used to expand the 16-bit unorm positions
+cbuffer Dequantization : register(b1)
+{
+  float3 positionOffset;
+  float3 positionScale;
+}
+
+float3 decodeOctahedral(float2 e)
+{
+  float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+  float t = saturate(-n.z);
+  n.xy += select(n.xy >= 0.0, -t, t);
+  return normalize(n);
+}
+
+VSOutput main( VSInput In )
+{
+  VSOutput result = (VSOutput)0;
+  float4x4 mtxWVP = mul(world, mul(view, proj));
+  float4 position = float4(positionOffset + In.Position.xyz * positionScale, 1.0);
+  result.Position = mul(position, mtxWVP);
+  result.Normal = float4(mul(decodeOctahedral(In.Normal), (float3x3)world), 0.0);
+  // Position.w is the bitangent sign as unorm 0 or 1
+  result.Tangent = float4(mul(decodeOctahedral(In.Tangent), (float3x3)world), In.Position.w * 2.0 - 1.0);
+  result.UV = In.UV;
+  return result;
+}
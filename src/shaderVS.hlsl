@@ -2,11 +2,16 @@ struct VSInput
 {
   float4 Position : POSITION;
   float3 Normal : NORMAL;
+  float4 Tangent : TANGENT;
+  float2 UV : TEXCOORD;
 };
 struct VSOutput
 {
   float4 Position : SV_POSITION;
   float4 Normal : NORMAL;
+  // xyz in world space, w the bitangent sign
+  float4 Tangent : TANGENT;
+  float2 UV : TEXCOORD;
 };
 
 cbuffer ShaderParameter : register(b0)
@@ -22,6 +27,8 @@ VSOutput main( VSInput In )
   float4x4 mtxWVP = mul(world, mul(view, proj));
   result.Position = mul(In.Position, mtxWVP);
   //result.Position = In.Position;
-  result.Normal = mul(In.Normal, world);
+  result.Normal = float4(mul(In.Normal, (float3x3)world), 0.0);
+  result.Tangent = float4(mul(In.Tangent.xyz, (float3x3)world), In.Tangent.w);
+  result.UV = In.UV;
   return result;
 }
\ No newline at end of file